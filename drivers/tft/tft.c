@@ -8,15 +8,20 @@
  *********************/
 #include "lv_conf.h"
 #include "lvgl/lvgl.h"
+#include "lvgl/src/draw/stm32_dma2d/lv_gpu_stm32_dma2d.h"
 #include <string.h>
 #include <stdlib.h>
 
 #include "tft.h"
 #include "stm32f7xx.h"
 #include "stm32746g_discovery.h"
-#include "stm32746g_discovery_sdram.h"
 #include "stm32746g_discovery_ts.h"
 #include "drivers/BSP/Components/rk043fn48h/rk043fn48h.h"
+#include "hardware_config.h"
+#include "xlat_sdram.h"
+#include "xlat_trace.h"
+#include "FreeRTOS.h"
+#include "task.h"
 
 /*********************
  *      DEFINES
@@ -48,15 +53,29 @@
 #define LCD_BL_CTRL_GPIO_CLK_ENABLE()    __HAL_RCC_GPIOK_CLK_ENABLE()
 #define LCD_BL_CTRL_GPIO_CLK_DISABLE()   __HAL_RCC_GPIOK_CLK_DISABLE()
 
-#define CPY_BUF_DMA_STREAM               DMA2_Stream0
-#define CPY_BUF_DMA_CHANNEL              DMA_CHANNEL_0
-#define CPY_BUF_DMA_STREAM_IRQ           DMA2_Stream0_IRQn
-#define CPY_BUF_DMA_STREAM_IRQHANDLER    DMA2_Stream0_IRQHandler
+#define DCACHE_LINE_SIZE                 32
+
+/* A frame is ~17 ms, the wait is only re-checked after this long if the interrupt never came */
+#define TFT_SWAP_TIMEOUT_MS              50
+
+/* Write-through SDRAM region: the LVGL render buffer, followed by the two LTDC scan-out buffers */
+#define TFT_FB_SIZE                      (TFT_HOR_RES * TFT_VER_RES)
+
+_Static_assert(3 * TFT_FB_SIZE * sizeof(lv_color_t) <= XLAT_SDRAM_FRAMEBUFFERS_SIZE, "framebuffers don't fit their budget");
 
 /**********************
  *      TYPEDEFS
  **********************/
 
+#if LV_COLOR_DEPTH == 16
+typedef uint16_t uintpixel_t;
+#elif LV_COLOR_DEPTH == 24 || LV_COLOR_DEPTH == 32
+typedef uint32_t uintpixel_t;
+#endif
+
+/* Two RGB565 pixels, accessed as one word */
+typedef uint32_t __attribute__((may_alias)) tft_pixel_pair_t;
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
@@ -64,42 +83,48 @@
 /*These 3 functions are needed by LittlevGL*/
 static void ex_disp_flush(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t * color_p);
 static void ex_disp_clean_dcache(lv_disp_drv_t *drv);
+static void tft_dirty_area_add(const lv_area_t *area);
+static void tft_present(lv_disp_drv_t *drv);
+static void tft_area_copy(lv_disp_drv_t *drv, uintpixel_t *dst, const lv_area_t *area);
 
 static uint8_t LCD_Init(void);
 static void LCD_LayerRgb565Init(uint32_t FB_Address);
 static void LCD_DisplayOn(void);
 
-static void DMA_Config(void);
-static void DMA_TransferComplete(DMA_HandleTypeDef *han);
-static void DMA_TransferError(DMA_HandleTypeDef *han);
+static void ex_draw_blend(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc);
+static void ex_draw_ctx_init(lv_disp_drv_t *drv, lv_draw_ctx_t *draw_ctx);
+
+static void DCache_CleanRange(const void *addr, uint32_t size);
+static void DCache_InvalidateRange(const void *addr, uint32_t size);
 
 /**********************
  *  STATIC VARIABLES
  **********************/
-static LTDC_HandleTypeDef  hLtdcHandler;
+/* Set up by MX_LTDC_Init(), the same handle LTDC_IRQHandler() passes to the HAL */
+extern LTDC_HandleTypeDef hltdc;
 static lv_disp_drv_t disp_drv;
 
-#if LV_COLOR_DEPTH == 16
-typedef uint16_t uintpixel_t;
-#elif LV_COLOR_DEPTH == 24 || LV_COLOR_DEPTH == 32
-typedef uint32_t uintpixel_t;
-#endif
+/* LVGL draws straight into this buffer, in its own (rotated) coordinates */
+static lv_color_t * render_fb;
 
-/* You can try to change buffer to internal ram by uncommenting line below and commenting
- * SDRAM one. */
-//static uintpixel_t my_fb[TFT_HOR_RES * TFT_VER_RES];
+/* Scanned out by the LTDC in the panel orientation, swapped on vertical blank */
+static uintpixel_t * scan_fb[2];
+static uint8_t scan_front = 0;
 
-static __IO uintpixel_t * my_fb = (__IO uintpixel_t*) (0x60000000);
+/* Task notified by the register reload interrupt once the swap took effect */
+static TaskHandle_t swap_task = NULL;
 
-static DMA_HandleTypeDef  DmaHandle;
-static int32_t            x1_flush;
-static int32_t            y1_flush;
-static int32_t            x2_flush;
-static int32_t            y2_fill;
-static int32_t            y_fill_act;
-static const lv_color_t * buf_to_flush;
+/* Areas changed in the frame being flushed, and in the one before it */
+static lv_area_t dirty_areas[2][LV_INV_BUF_SIZE];
+static uint16_t dirty_cnt[2];
+static bool dirty_full[2];
+static uint8_t dirty_cur = 0;
 
 static lv_disp_t *our_disp = NULL;
+
+/* The blend function of the LVGL GPU, and what it is blending right now */
+static void (*gpu_blend)(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc);
+static const lv_draw_sw_blend_dsc_t * gpu_blend_dsc = NULL;
 /**********************
  *      MACROS
  **********************/
@@ -113,27 +138,29 @@ void tft_init(void)
 	/* There is only one display on STM32 */
 	if(our_disp != NULL)
 		abort();
+
+    uint8_t *fb = xlat_sdram_region_get(XLAT_SDRAM_FRAMEBUFFERS, NULL);
+    render_fb = (lv_color_t *) fb;
+    scan_fb[0] = (uintpixel_t *) (fb + 1 * TFT_FB_SIZE * sizeof(uintpixel_t));
+    scan_fb[1] = (uintpixel_t *) (fb + 2 * TFT_FB_SIZE * sizeof(uintpixel_t));
+
     /* LCD Initialization */
     LCD_Init();
 
     /* LCD Initialization */
-    LCD_LayerRgb565Init((uint32_t)my_fb);
+    LCD_LayerRgb565Init((uint32_t)scan_fb[scan_front]);
 
     /* Enable the LCD */
     LCD_DisplayOn();
 
-    DMA_Config();
-
    /*-----------------------------
 	* Create a buffer for drawing
 	*----------------------------*/
 
-   /* LittlevGL requires a buffer where it draws the objects. The buffer's has to be greater than 1 display row*/
+   /* LittlevGL draws directly into a full frame in SDRAM, no internal RAM is used for drawing */
 
 	static lv_disp_draw_buf_t disp_buf_1;
-	static lv_color_t buf1_1[TFT_HOR_RES * 68];
-	static lv_color_t buf1_2[TFT_HOR_RES * 68];
-	lv_disp_draw_buf_init(&disp_buf_1, buf1_1, buf1_2, TFT_HOR_RES * 68);   /*Initialize the display buffer*/
+	lv_disp_draw_buf_init(&disp_buf_1, render_fb, NULL, TFT_FB_SIZE);   /*Initialize the display buffer*/
 
 
 	/*-----------------------------------
@@ -151,12 +178,15 @@ void tft_init(void)
 	/*Used to copy the buffer's content to the display*/
 	disp_drv.flush_cb = ex_disp_flush;
 	disp_drv.clean_dcache_cb = ex_disp_clean_dcache;
+	disp_drv.draw_ctx_init = ex_draw_ctx_init;
 
 	/*Set a display buffer*/
 	disp_drv.draw_buf = &disp_buf_1;
 
-    /*Use software rotation*/
-    disp_drv.sw_rotate = 1;
+    /*Only redraw the changed areas, at their absolute position in the frame.
+     *The rotation is applied by the flush, while copying to the scan-out buffer*/
+    disp_drv.direct_mode = 1;
+    disp_drv.sw_rotate = 0;
 
 	/*Finally register the driver*/
 	our_disp = lv_disp_drv_register(&disp_drv);
@@ -166,57 +196,211 @@ void tft_init(void)
  *   STATIC FUNCTIONS
  **********************/
 
-/* Flush the content of the internal buffer the specific area on the display
- * You can use DMA or any hardware acceleration to do this operation in the background but
- * 'lv_flush_ready()' has to be called when finished
- * This function is required only when LV_VDB_SIZE != 0 in lv_conf.h*/
+/* Called by LVGL for every redrawn area, the render buffer already holds its final content.
+ * In direct mode the area passed here is always the whole screen, the scan-out buffer is
+ * updated from LVGL's list of invalidated areas once the last one is drawn. */
 static void ex_disp_flush(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t * color_p)
 {
-	int32_t x1 = area->x1;
-	int32_t x2 = area->x2;
-	int32_t y1 = area->y1;
-	int32_t y2 = area->y2;
-    /*Return if the area is out the screen*/
-
-    if(x2 < 0) return;
-    if(y2 < 0) return;
-    if(x1 > TFT_HOR_RES - 1) return;
-    if(y1 > TFT_VER_RES - 1) return;
-
-    /*Truncate the area to the screen*/
-    int32_t act_x1 = x1 < 0 ? 0 : x1;
-    int32_t act_y1 = y1 < 0 ? 0 : y1;
-    int32_t act_x2 = x2 > TFT_HOR_RES - 1 ? TFT_HOR_RES - 1 : x2;
-    int32_t act_y2 = y2 > TFT_VER_RES - 1 ? TFT_VER_RES - 1 : y2;
-
-    x1_flush = act_x1;
-    y1_flush = act_y1;
-    x2_flush = act_x2;
-    y2_fill = act_y2;
-    y_fill_act = act_y1;
-    buf_to_flush = color_p;
-
-	SCB_CleanInvalidateDCache();
-	SCB_InvalidateICache();
-    /*##-7- Start the DMA transfer using the interrupt mode #*/
-    /* Configure the source, destination and buffer size DMA fields and Start DMA Stream transfer */
-    /* Enable All the DMA interrupts */
-    HAL_StatusTypeDef err;
-    uint32_t length = (x2_flush - x1_flush + 1);
-#if LV_COLOR_DEPTH == 24 || LV_COLOR_DEPTH == 32
-    length *= 2; /* STM32 DMA uses 16-bit chunks so multiply by 2 for 32-bit color */
+    if(lv_disp_flush_is_last(drv)) {
+        lv_disp_t * disp = _lv_refr_get_disp_refreshing();
+        for(uint16_t i = 0; i < disp->inv_p; i++) {
+            /*Merged into another area by lv_refr_join_area()*/
+            if(disp->inv_area_joined[i]) {
+                continue;
+            }
+            tft_dirty_area_add(&disp->inv_areas[i]);
+        }
+        tft_present(drv);
+    }
+
+    /*The render buffer is never scanned out, LVGL may draw the next frame right away*/
+    lv_disp_flush_ready(drv);
+}
+
+static void tft_dirty_area_add(const lv_area_t *area)
+{
+    lv_area_t clipped;
+    lv_area_t screen = { 0, 0, TFT_HOR_RES - 1, TFT_VER_RES - 1 };
+
+    /*Ignore the area if it is out of the screen*/
+    if(!_lv_area_intersect(&clipped, area, &screen)) {
+        return;
+    }
+
+    if(dirty_cnt[dirty_cur] < LV_INV_BUF_SIZE) {
+        dirty_areas[dirty_cur][dirty_cnt[dirty_cur]++] = clipped;
+    }
+    else {
+        dirty_full[dirty_cur] = true;
+    }
+}
+
+/* Bring the back buffer up to date and show it from the next vertical blank on */
+static void tft_present(lv_disp_drv_t *drv)
+{
+    uint8_t prev = dirty_cur ^ 1;
+    lv_area_t screen = { 0, 0, TFT_HOR_RES - 1, TFT_VER_RES - 1 };
+
+    /*The back buffer is still on the screen until the previous swap took effect. The gfx task
+     *normally waited for it with tft_swap_wait() already, before taking the LVGL lock*/
+    tft_swap_wait();
+
+    /*The framebuffers are write-through (see hardware_config.h), memory is always up to date*/
+    uintpixel_t * back = scan_fb[scan_front ^ 1];
+
+    /*The back buffer misses this frame's changes, and the ones of the frame on the screen now*/
+    if(dirty_full[dirty_cur] || dirty_full[prev]) {
+        tft_area_copy(drv, back, &screen);
+    }
+    else {
+        for(uint16_t i = 0; i < dirty_cnt[dirty_cur]; i++) {
+            tft_area_copy(drv, back, &dirty_areas[dirty_cur][i]);
+        }
+        for(uint16_t i = 0; i < dirty_cnt[prev]; i++) {
+            bool covered = false;
+            for(uint16_t j = 0; j < dirty_cnt[dirty_cur] && !covered; j++) {
+                covered = _lv_area_is_in(&dirty_areas[prev][i], &dirty_areas[dirty_cur][j], 0);
+            }
+            if(!covered) {
+                tft_area_copy(drv, back, &dirty_areas[prev][i]);
+            }
+        }
+    }
+
+    /*Swap the buffers on the next vertical blank, the reload interrupt wakes up the next tft_present()*/
+    scan_front ^= 1;
+    HAL_LTDC_SetAddress_NoReload(&hltdc, (uint32_t)back, 0);
+    swap_task = xTaskGetCurrentTaskHandle();
+    __HAL_LTDC_CLEAR_FLAG(&hltdc, LTDC_FLAG_RR);
+    __HAL_LTDC_ENABLE_IT(&hltdc, LTDC_IT_RR);
+    hltdc.Instance->SRCR = LTDC_SRCR_VBR;
+
+    dirty_cur = prev;
+    dirty_cnt[dirty_cur] = 0;
+    dirty_full[dirty_cur] = false;
+}
+
+/* Sleep until the swap requested by the last tft_present() took effect */
+void tft_swap_wait(void)
+{
+    while(hltdc.Instance->SRCR & LTDC_SRCR_VBR) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TFT_SWAP_TIMEOUT_MS));
+    }
+}
+
+/* From LTDC_IRQHandler(), once the registers were reloaded on vertical blank. The HAL
+ * already disabled the interrupt again, it is only enabled while a swap is pending. */
+void HAL_LTDC_ReloadEventCallback(LTDC_HandleTypeDef *handle)
+{
+    (void) handle;
+    BaseType_t woken = pdFALSE;
+
+    if(swap_task != NULL) {
+        vTaskNotifyGiveFromISR(swap_task, &woken);
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+/* Copy an area of the render buffer to a scan-out buffer, in the panel orientation.
+ * Neither DMA2D nor the LTDC can mirror an image, the 180 degree rotation is done by the CPU */
+static void tft_area_copy(lv_disp_drv_t *drv, uintpixel_t *dst, const lv_area_t *area)
+{
+    int32_t w = lv_area_get_width(area);
+    int32_t h = lv_area_get_height(area);
+    const lv_color_t * src = &render_fb[area->y1 * TFT_HOR_RES + area->x1];
+
+    XLAT_TRACE(XLAT_TRACE_ID_GFX_FLUSH, 0, h);
+
+    if(drv->rotated != LV_DISP_ROT_180) {
+        for(int32_t y = 0; y < h; y++) {
+            memcpy(&dst[(area->y1 + y) * TFT_HOR_RES + area->x1], &src[y * TFT_HOR_RES], w * sizeof(uintpixel_t));
+        }
+        return;
+    }
+
+    for(int32_t y = 0; y < h; y++) {
+        const uintpixel_t * s = (const uintpixel_t *)&src[y * TFT_HOR_RES];
+        uintpixel_t * d = &dst[(TFT_VER_RES - 1 - area->y1 - y) * TFT_HOR_RES + (TFT_HOR_RES - 1 - area->x1)];
+        int32_t n = w;
+#if LV_COLOR_DEPTH == 16
+        /*Two pixels per access: a word with its halves swapped is the mirrored pair. The rows
+         *are word aligned, s and d - 1 are both aligned once an odd first pixel is copied*/
+        if(((uint32_t)s & 2) && n) {
+            *d-- = *s++;
+            n--;
+        }
+        const tft_pixel_pair_t * s2 = (const tft_pixel_pair_t *)s;
+        tft_pixel_pair_t * d2 = (tft_pixel_pair_t *)(d - 1);
+        for(; n >= 2; n -= 2) {
+            *d2-- = __ROR(*s2++, 16);
+        }
+        s = (const uintpixel_t *)s2;
+        d = (uintpixel_t *)d2 + 1;
 #endif
-    err = HAL_DMA_Start_IT(&DmaHandle,(uint32_t)buf_to_flush, (uint32_t)&my_fb[y_fill_act * TFT_HOR_RES + x1_flush],
-             length);
-    if(err != HAL_OK)
-    {
-        while(1);	/*Halt on error*/
+        while(n--) {
+            *d-- = *s++;
+        }
     }
 }
 
+/* Replaces the blend function of the GPU draw context, to know what the next DMA2D operation
+ * reads and writes when ex_disp_clean_dcache() is called */
+static void ex_draw_blend(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc)
+{
+    gpu_blend_dsc = dsc;
+    gpu_blend(draw_ctx, dsc);
+    gpu_blend_dsc = NULL;
+}
+
+static void ex_draw_ctx_init(lv_disp_drv_t *drv, lv_draw_ctx_t *draw_ctx)
+{
+    lv_draw_stm32_dma2d_ctx_init(drv, draw_ctx);
+
+    lv_draw_stm32_dma2d_ctx_t * dma2d_draw_ctx = (lv_draw_stm32_dma2d_ctx_t *)draw_ctx;
+    gpu_blend = dma2d_draw_ctx->blend;
+    dma2d_draw_ctx->blend = ex_draw_blend;
+}
+
+/* Called by the LVGL GPU before every DMA2D operation, i.e. from gpu_blend() */
 static void ex_disp_clean_dcache(lv_disp_drv_t *drv)
 {
-    SCB_CleanInvalidateDCache();
+    lv_draw_ctx_t * draw_ctx = drv->draw_ctx;
+    const lv_draw_sw_blend_dsc_t * dsc = gpu_blend_dsc;
+    lv_area_t blend_area;
+
+    if(!draw_ctx || !draw_ctx->buf || !dsc || !_lv_area_intersect(&blend_area, dsc->blend_area, draw_ctx->clip_area)) {
+        return;
+    }
+    lv_coord_t rows = lv_area_get_height(&blend_area);
+
+    /*The source (an image or a layer) is in cached RAM: write the rows DMA2D reads back to memory.
+     *Unlike an invalidate, this doesn't evict anything from the cache*/
+    if(dsc->src_buf) {
+        lv_coord_t src_w = lv_area_get_width(dsc->blend_area);
+        const lv_color_t * src = dsc->src_buf + (blend_area.y1 - dsc->blend_area->y1) * src_w;
+        DCache_CleanRange(src, rows * src_w * sizeof(lv_color_t));
+    }
+
+    /*The destination is write-through, memory is up to date. Drop the cached copy of the rows
+     *DMA2D is about to write*/
+    lv_coord_t buf_w = lv_area_get_width(draw_ctx->buf_area);
+    lv_color_t * dest = (lv_color_t *)draw_ctx->buf + (blend_area.y1 - draw_ctx->buf_area->y1) * buf_w;
+    DCache_InvalidateRange(dest, rows * buf_w * sizeof(lv_color_t));
+}
+
+static void DCache_CleanRange(const void *addr, uint32_t size)
+{
+    uint32_t start = (uint32_t)addr & ~(DCACHE_LINE_SIZE - 1);
+    uint32_t end = ((uint32_t)addr + size + DCACHE_LINE_SIZE - 1) & ~(DCACHE_LINE_SIZE - 1);
+    SCB_CleanDCache_by_Addr((uint32_t *)start, end - start);
+}
+
+/*Cache maintenance by address works on whole lines: round the range out to line boundaries*/
+static void DCache_InvalidateRange(const void *addr, uint32_t size)
+{
+    uint32_t start = (uint32_t)addr & ~(DCACHE_LINE_SIZE - 1);
+    uint32_t end = ((uint32_t)addr + size + DCACHE_LINE_SIZE - 1) & ~(DCACHE_LINE_SIZE - 1);
+    SCB_InvalidateDCache_by_Addr((uint32_t *)start, end - start);
 }
 
 
@@ -317,40 +501,37 @@ static uint8_t LCD_Init(void)
 
     /* The RK043FN48H LCD 480x272 is selected */
     /* Timing Configuration */
-    hLtdcHandler.Init.HorizontalSync = (RK043FN48H_HSYNC - 1);
-    hLtdcHandler.Init.VerticalSync = (RK043FN48H_VSYNC - 1);
-    hLtdcHandler.Init.AccumulatedHBP = (RK043FN48H_HSYNC + RK043FN48H_HBP - 1);
-    hLtdcHandler.Init.AccumulatedVBP = (RK043FN48H_VSYNC + RK043FN48H_VBP - 1);
-    hLtdcHandler.Init.AccumulatedActiveH = (RK043FN48H_HEIGHT + RK043FN48H_VSYNC + RK043FN48H_VBP - 1);
-    hLtdcHandler.Init.AccumulatedActiveW = (RK043FN48H_WIDTH + RK043FN48H_HSYNC + RK043FN48H_HBP - 1);
-    hLtdcHandler.Init.TotalHeigh = (RK043FN48H_HEIGHT + RK043FN48H_VSYNC + RK043FN48H_VBP + RK043FN48H_VFP - 1);
-    hLtdcHandler.Init.TotalWidth = (RK043FN48H_WIDTH + RK043FN48H_HSYNC + RK043FN48H_HBP + RK043FN48H_HFP - 1);
+    hltdc.Init.HorizontalSync = (RK043FN48H_HSYNC - 1);
+    hltdc.Init.VerticalSync = (RK043FN48H_VSYNC - 1);
+    hltdc.Init.AccumulatedHBP = (RK043FN48H_HSYNC + RK043FN48H_HBP - 1);
+    hltdc.Init.AccumulatedVBP = (RK043FN48H_VSYNC + RK043FN48H_VBP - 1);
+    hltdc.Init.AccumulatedActiveH = (RK043FN48H_HEIGHT + RK043FN48H_VSYNC + RK043FN48H_VBP - 1);
+    hltdc.Init.AccumulatedActiveW = (RK043FN48H_WIDTH + RK043FN48H_HSYNC + RK043FN48H_HBP - 1);
+    hltdc.Init.TotalHeigh = (RK043FN48H_HEIGHT + RK043FN48H_VSYNC + RK043FN48H_VBP + RK043FN48H_VFP - 1);
+    hltdc.Init.TotalWidth = (RK043FN48H_WIDTH + RK043FN48H_HSYNC + RK043FN48H_HBP + RK043FN48H_HFP - 1);
 
     /* LCD clock configuration */
     LCD_ClockConfig();
 
     /* Initialize the LCD pixel width and pixel height */
-    hLtdcHandler.LayerCfg->ImageWidth  = RK043FN48H_WIDTH;
-    hLtdcHandler.LayerCfg->ImageHeight = RK043FN48H_HEIGHT;
+    hltdc.LayerCfg->ImageWidth  = RK043FN48H_WIDTH;
+    hltdc.LayerCfg->ImageHeight = RK043FN48H_HEIGHT;
 
     /* Background value */
-    hLtdcHandler.Init.Backcolor.Blue = 0;
-    hLtdcHandler.Init.Backcolor.Green = 0;
-    hLtdcHandler.Init.Backcolor.Red = 0;
+    hltdc.Init.Backcolor.Blue = 0;
+    hltdc.Init.Backcolor.Green = 0;
+    hltdc.Init.Backcolor.Red = 0;
 
     /* Polarity */
-    hLtdcHandler.Init.HSPolarity = LTDC_HSPOLARITY_AL;
-    hLtdcHandler.Init.VSPolarity = LTDC_VSPOLARITY_AL;
-    hLtdcHandler.Init.DEPolarity = LTDC_DEPOLARITY_AL;
-    hLtdcHandler.Init.PCPolarity = LTDC_PCPOLARITY_IPC;
-    hLtdcHandler.Instance = LTDC;
-
-    if(HAL_LTDC_GetState(&hLtdcHandler) == HAL_LTDC_STATE_RESET)
-    {
-        /* Initialize the LCD Msp: this __weak function can be rewritten by the application */
-        LCD_MspInit();
-    }
-    HAL_LTDC_Init(&hLtdcHandler);
+    hltdc.Init.HSPolarity = LTDC_HSPOLARITY_AL;
+    hltdc.Init.VSPolarity = LTDC_VSPOLARITY_AL;
+    hltdc.Init.DEPolarity = LTDC_DEPOLARITY_AL;
+    hltdc.Init.PCPolarity = LTDC_PCPOLARITY_IPC;
+    hltdc.Instance = LTDC;
+
+    /* The handle is already initialized by hw_init(), the panel pins and clocks are set up here */
+    LCD_MspInit();
+    HAL_LTDC_Init(&hltdc);
 
     /* Assert display enable LCD_DISP pin */
     HAL_GPIO_WritePin(LCD_DISP_GPIO_PORT, LCD_DISP_PIN, GPIO_PIN_SET);
@@ -358,14 +539,10 @@ static uint8_t LCD_Init(void)
     /* Assert backlight LCD_BL_CTRL pin */
     HAL_GPIO_WritePin(LCD_BL_CTRL_GPIO_PORT, LCD_BL_CTRL_PIN, GPIO_PIN_SET);
 
-    BSP_SDRAM_Init();
-    HAL_EnableFMCMemorySwapping();
-
-    uint32_t i;
-    for(i = 0; i < (TFT_HOR_RES * TFT_VER_RES) ; i++)
-    {
-        my_fb[i] = 0;
-    }
+    /* The SDRAM holding the framebuffers is set up in hw_init() */
+    /* LVGL redraws the whole render buffer on the first refresh, only the scan-out buffers need clearing */
+    memset(scan_fb[0], 0, TFT_FB_SIZE * sizeof(uintpixel_t));
+    memset(scan_fb[1], 0, TFT_FB_SIZE * sizeof(uintpixel_t));
 
     return LCD_OK;
 }
@@ -398,105 +575,13 @@ static void LCD_LayerRgb565Init(uint32_t FB_Address)
     layer_cfg.ImageWidth = TFT_HOR_RES;
     layer_cfg.ImageHeight = TFT_VER_RES;
 
-    HAL_LTDC_ConfigLayer(&hLtdcHandler, &layer_cfg, 0);
+    HAL_LTDC_ConfigLayer(&hltdc, &layer_cfg, 0);
 }
 
 static void LCD_DisplayOn(void)
 {
     /* Display On */
-    __HAL_LTDC_ENABLE(&hLtdcHandler);
+    __HAL_LTDC_ENABLE(&hltdc);
     HAL_GPIO_WritePin(LCD_DISP_GPIO_PORT, LCD_DISP_PIN, GPIO_PIN_SET);        /* Assert LCD_DISP pin */
     HAL_GPIO_WritePin(LCD_BL_CTRL_GPIO_PORT, LCD_BL_CTRL_PIN, GPIO_PIN_SET);  /* Assert LCD_BL_CTRL pin */
 }
-
-static void DMA_Config(void)
-{
-    /*## -1- Enable DMA2 clock #################################################*/
-    __HAL_RCC_DMA2_CLK_ENABLE();
-
-    /*##-2- Select the DMA functional Parameters ###############################*/
-    DmaHandle.Init.Channel = CPY_BUF_DMA_CHANNEL;                   /* DMA_CHANNEL_0                    */
-    DmaHandle.Init.Direction = DMA_MEMORY_TO_MEMORY;                /* M2M transfer mode                */
-    DmaHandle.Init.PeriphInc = DMA_PINC_ENABLE;                     /* Peripheral increment mode Enable */
-    DmaHandle.Init.MemInc = DMA_MINC_ENABLE;                        /* Memory increment mode Enable     */
-    DmaHandle.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;   /* Peripheral data alignment : 16bit */
-    DmaHandle.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;      /* memory data alignment : 16bit     */
-    DmaHandle.Init.Mode = DMA_NORMAL;                               /* Normal DMA mode                  */
-    DmaHandle.Init.Priority = DMA_PRIORITY_HIGH;                    /* priority level : high            */
-    DmaHandle.Init.FIFOMode = DMA_FIFOMODE_ENABLE;                  /* FIFO mode enabled                */
-    DmaHandle.Init.FIFOThreshold = DMA_FIFO_THRESHOLD_1QUARTERFULL; /* FIFO threshold: 1/4 full   */
-    DmaHandle.Init.MemBurst = DMA_MBURST_SINGLE;                    /* Memory burst                     */
-    DmaHandle.Init.PeriphBurst = DMA_PBURST_SINGLE;                 /* Peripheral burst                 */
-
-    /*##-3- Select the DMA instance to be used for the transfer : DMA2_Stream0 #*/
-    DmaHandle.Instance = CPY_BUF_DMA_STREAM;
-
-    /*##-4- Initialize the DMA stream ##########################################*/
-    if(HAL_DMA_Init(&DmaHandle) != HAL_OK)
-    {
-        while(1)
-        {
-        }
-    }
-
-    /*##-5- Select Callbacks functions called after Transfer complete and Transfer error */
-    HAL_DMA_RegisterCallback(&DmaHandle, HAL_DMA_XFER_CPLT_CB_ID, DMA_TransferComplete);
-    HAL_DMA_RegisterCallback(&DmaHandle, HAL_DMA_XFER_ERROR_CB_ID, DMA_TransferError);
-
-    /*##-6- Configure NVIC for DMA transfer complete/error interrupts ##########*/
-    HAL_NVIC_SetPriority(CPY_BUF_DMA_STREAM_IRQ, 0, 0);
-    HAL_NVIC_EnableIRQ(CPY_BUF_DMA_STREAM_IRQ);
-}
-
-/**
-  * @brief  DMA conversion complete callback
-  * @note   This function is executed when the transfer complete interrupt
-  *         is generated
-  * @retval None
-  */
-static void DMA_TransferComplete(DMA_HandleTypeDef *han)
-{
-    y_fill_act ++;
-
-    if(y_fill_act > y2_fill) {
-    	SCB_CleanInvalidateDCache();
-    	SCB_InvalidateICache();
-        lv_disp_flush_ready(&disp_drv);
-    } else {
-    	uint32_t length = (x2_flush - x1_flush + 1);
-        buf_to_flush += x2_flush - x1_flush + 1;
-        /*##-7- Start the DMA transfer using the interrupt mode ####################*/
-        /* Configure the source, destination and buffer size DMA fields and Start DMA Stream transfer */
-        /* Enable All the DMA interrupts */
-#if LV_COLOR_DEPTH == 24 || LV_COLOR_DEPTH == 32
-        length *= 2; /* STM32 DMA uses 16-bit chunks so multiply by 2 for 32-bit color */
-#endif
-        if(HAL_DMA_Start_IT(han,(uint32_t)buf_to_flush, (uint32_t)&my_fb[y_fill_act * TFT_HOR_RES + x1_flush],
-                            length) != HAL_OK)
-        {
-            while(1);	/*Halt on error*/
-        }
-    }
-}
-
-/**
-  * @brief  DMA conversion error callback
-  * @note   This function is executed when the transfer error interrupt
-  *         is generated during DMA transfer
-  * @retval None
-  */
-static void DMA_TransferError(DMA_HandleTypeDef *han)
-{
-
-}
-
-/**
-  * @brief  This function handles DMA Stream interrupt request.
-  * @param  None
-  * @retval None
-  */
-void CPY_BUF_DMA_STREAM_IRQHANDLER(void)
-{
-    /* Check the interrupt and clear flag */
-    HAL_DMA_IRQHandler(&DmaHandle);
-}
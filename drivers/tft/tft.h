@@ -27,6 +27,9 @@
  * GLOBAL PROTOTYPES
  **********************/
 void tft_init(void);
+/* Wait for the pending buffer swap (vertical blank), without holding the LVGL lock:
+ * the next redraw would have to wait for it inside lv_task_handler() otherwise */
+void tft_swap_wait(void);
 
 /**********************
  *      MACROS
@@ -29,6 +29,8 @@ static void touchpad_read(lv_indev_drv_t *drv, lv_indev_data_t *data);
  *  STATIC VARIABLES
  **********************/
 static TS_StateTypeDef  TS_State;
+static volatile bool touch_irq_pending = false;   /*Set by the FT5336 INT line*/
+static bool touch_pressed = false;
 
 /**********************
  *      MACROS
@@ -45,6 +47,17 @@ void touchpad_init(void)
 {
     BSP_TS_Init(TFT_HOR_RES, TFT_VER_RES);
 
+    /* The FT5336 pulses its INT line while the panel is touched (trigger mode).
+     * Not BSP_TS_ITConfig(): it would lower the priority of EXTI15_10, which is shared with the
+     * measurement input. The IRQ is enabled by hw_exti_interrupts_enable() at that priority. */
+    GPIO_InitTypeDef gpio_init_structure = {0};
+    gpio_init_structure.Pin = TS_INT_PIN;
+    gpio_init_structure.Mode = GPIO_MODE_IT_RISING;
+    gpio_init_structure.Pull = GPIO_NOPULL;
+    gpio_init_structure.Speed = GPIO_SPEED_FAST;
+    HAL_GPIO_Init(TS_INT_GPIO_PORT, &gpio_init_structure);
+    ft5336_ts_drv.EnableIT(TS_I2C_ADDRESS);
+
     static lv_indev_drv_t indev_drv;                       /*Descriptor of an input device driver*/
     lv_indev_drv_init(&indev_drv);                  /*Basic initialization*/
     indev_drv.type = LV_INDEV_TYPE_POINTER;         /*The touchpad is pointer type device*/
@@ -53,6 +66,14 @@ void touchpad_init(void)
     lv_indev_drv_register(&indev_drv);
 }
 
+/**
+ * Called from EXTI15_10_IRQHandler when the FT5336 INT line fired
+ */
+void touchpad_irq_handler(void)
+{
+    touch_irq_pending = true;
+}
+
 /**********************
  *   STATIC FUNCTIONS
  **********************/
@@ -69,18 +90,22 @@ static void touchpad_read(lv_indev_drv_t *indev, lv_indev_data_t *data)
     /* Read your touchpad */
     static int16_t last_x = 0;
     static int16_t last_y = 0;
-    BSP_LED_Toggle(LED1);
-
-    BSP_TS_GetState(&TS_State);
-    if(TS_State.touchDetected) {
-            data->point.x = TS_State.touchX[0];
-            data->point.y = TS_State.touchY[0];
-            last_x = data->point.x;
-            last_y = data->point.y;
-            data->state = LV_INDEV_STATE_PRESSED;
-    } else {
-            data->point.x = last_x;
-            data->point.y = last_y;
-            data->state = LV_INDEV_STATE_RELEASED;
+
+    /* Only talk I2C when the controller signalled a touch, or to see the end of one: the INT
+     * line just stops pulsing on release. The EXTI pending bit covers the time the
+     * measurement code holds the shared IRQ disabled. */
+    if (touch_irq_pending || touch_pressed || __HAL_GPIO_EXTI_GET_IT(TS_INT_PIN)) {
+        touch_irq_pending = false;
+        __HAL_GPIO_EXTI_CLEAR_IT(TS_INT_PIN);
+        BSP_TS_GetState(&TS_State);
+        touch_pressed = TS_State.touchDetected;
+        if (touch_pressed) {
+            last_x = TS_State.touchX[0];
+            last_y = TS_State.touchY[0];
+        }
     }
+
+    data->point.x = last_x;
+    data->point.y = last_y;
+    data->state = touch_pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
 }
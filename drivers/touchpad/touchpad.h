@@ -24,6 +24,7 @@
  * GLOBAL PROTOTYPES
  **********************/
 void touchpad_init(void);
+void touchpad_irq_handler(void);
 
 /**********************
  *      MACROS
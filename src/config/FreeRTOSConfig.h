@@ -54,7 +54,7 @@
 // For better RTOS integration in IDE
 #define configUSE_TRACE_FACILITY                 1
 #define configRECORD_STACK_HIGH_ADDRESS          1
-// #define configGENERATE_RUN_TIME_STATS            1 // Needs portGET_RUN_TIME_COUNTER_VALUE
+#define configGENERATE_RUN_TIME_STATS            1 // See xlat_diag.h
 
 #define configUSE_PREEMPTION                     1
 #define configSUPPORT_STATIC_ALLOCATION          0
@@ -142,4 +142,18 @@ standard names. */
 
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
 
+/* Run time stats, clocked by the free running 1 MHz TIM2 counter (started in hw_init()) */
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+  uint32_t xlat_counter_1mhz_get(void);
+#endif
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()          xlat_counter_1mhz_get()
+
+/* Context switches in the RTT pipeline trace (see xlat_trace.h) */
+#if defined(XLAT_TRACE_ENABLED) && XLAT_TRACE_ENABLED && (defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__))
+  #include "xlat_trace.h"
+  #define traceTASK_SWITCHED_IN()   xlat_trace(XLAT_TRACE_ID_TASK_IN, (uint8_t)pxCurrentTCB->uxTCBNumber, 0)
+  #define traceTASK_SWITCHED_OUT()  xlat_trace(XLAT_TRACE_ID_TASK_OUT, (uint8_t)pxCurrentTCB->uxTCBNumber, 0)
+#endif
+
 #endif /* FREERTOS_CONFIG_H */
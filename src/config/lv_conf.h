@@ -49,15 +49,24 @@
 #define LV_MEM_CUSTOM      0
 #if LV_MEM_CUSTOM == 0
 /*Size of the memory available for `lv_mem_alloc()` in bytes (>= 2kB)*/
+#if defined(XLAT_LVGL_HEAP_SDRAM) && XLAT_LVGL_HEAP_SDRAM
+#  define LV_MEM_SIZE    (256U * 1024U)         /*XLAT_SDRAM_LVGL_HEAP_SIZE*/
+#else
 #  define LV_MEM_SIZE    (32U * 1024U)          /*[bytes]*/
+#endif
 
 /*Set an address for the memory pool instead of allocating it as a normal array. Can be in external SRAM too.*/
 #  define LV_MEM_ADR          0     /*0: unused*/
     /*Instead of an address give a memory allocator that will be called to get a memory pool for LVGL. E.g. my_malloc*/
     #if LV_MEM_ADR == 0
+    #if defined(XLAT_LVGL_HEAP_SDRAM) && XLAT_LVGL_HEAP_SDRAM
+        #define LV_MEM_POOL_INCLUDE "xlat_sdram.h"
+        #define LV_MEM_POOL_ALLOC   xlat_sdram_lvgl_heap_get
+    #else
         //#define LV_MEM_POOL_INCLUDE your_alloc_library  /* Uncomment if using an external allocator*/
         //#define LV_MEM_POOL_ALLOC   your_alloc          /* Uncomment if using an external allocator*/
     #endif
+    #endif
 
 #else       /*LV_MEM_CUSTOM*/
 #  define LV_MEM_CUSTOM_INCLUDE <stdlib.h>   /*Header for the dynamic memory function*/
@@ -58,7 +58,7 @@
 /* #define HAL_RNG_MODULE_ENABLED */
 #define HAL_RTC_MODULE_ENABLED
 #define HAL_SAI_MODULE_ENABLED
-/* #define HAL_SD_MODULE_ENABLED */
+#define HAL_SD_MODULE_ENABLED
 /* #define HAL_MMC_MODULE_ENABLED */
 #define HAL_SPDIFRX_MODULE_ENABLED
 /* #define HAL_SPI_MODULE_ENABLED */
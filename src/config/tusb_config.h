@@ -136,6 +136,49 @@
 #define CFG_TUH_HID_EPIN_BUFSIZE    64
 #define CFG_TUH_HID_EPOUT_BUFSIZE   64
 
+//--------------------------------------------------------------------
+// Device Configuration
+//--------------------------------------------------------------------
+
+// Enable Device stack, on the OTG_FS port (see usb_device.c)
+#define CFG_TUD_ENABLED       1
+
+#ifndef BOARD_TUD_RHPORT
+#define BOARD_TUD_RHPORT      0
+#endif
+
+#define CFG_TUD_MAX_SPEED     OPT_MODE_FULL_SPEED
+
+#ifndef CFG_TUD_MEM_SECTION
+#define CFG_TUD_MEM_SECTION
+#endif
+
+#ifndef CFG_TUD_MEM_ALIGN
+#define CFG_TUD_MEM_ALIGN     __attribute__ ((aligned(4)))
+#endif
+
+#define CFG_TUD_ENDPOINT0_SIZE  64
+
+//------------- CLASS -------------//
+#define CFG_TUD_CDC             1
+#define CFG_TUD_MSC             1
+#define CFG_TUD_HID             2   // HID pass-through, USB_PROXY_MAX_ITF
+#define CFG_TUD_MIDI            0
+#define CFG_TUD_VENDOR          0
+
+// CDC FIFO size of TX and RX, TX holds about 100 result lines
+#define CFG_TUD_CDC_RX_BUFSIZE  64
+#define CFG_TUD_CDC_TX_BUFSIZE  4096
+
+// CDC Endpoint transfer buffer size, more is faster
+#define CFG_TUD_CDC_EP_BUFSIZE  64
+
+// MSC buffer, one sector of the virtual volume (see usb_msc.c)
+#define CFG_TUD_MSC_EP_BUFSIZE  512
+
+// HID pass-through, the largest full speed interrupt packet
+#define CFG_TUD_HID_EP_BUFSIZE  64
+
 
 #ifdef __cplusplus
  }
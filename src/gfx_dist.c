@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include "gfx_dist.h"
+#include "xlat_hist.h"
+
+#define DIST_MIN_BINS       32      // the x axis shows 32, 64, 128 or all bins
+#define DIST_MIN_Y_SCALE    8       // histogram count at the top of the plot
+
+struct gfx_dist {
+    gfx_dist_view_t view;
+    uint16_t x_bins;    // number of bins across the plot
+    uint32_t y_scale;   // histogram only
+};
+
+static void dist_scale_reset(struct gfx_dist * dist)
+{
+    dist->x_bins = DIST_MIN_BINS;
+    dist->y_scale = DIST_MIN_Y_SCALE;
+}
+
+// Grow the axes to fit the data, returns true if they changed
+static bool dist_scale_update(struct gfx_dist * dist)
+{
+    bool changed = false;
+
+    while ((xlat_hist_last_bin_get() >= dist->x_bins) && (dist->x_bins < XLAT_HIST_BINS)) {
+        dist->x_bins *= 2;
+        changed = true;
+    }
+    while (xlat_hist_peak_get() > dist->y_scale) {
+        dist->y_scale *= 2;
+        changed = true;
+    }
+    return changed;
+}
+
+// Screen columns covered by a bin
+static void dist_bin_area_get(lv_obj_t * obj, const struct gfx_dist * dist, uint16_t bin, lv_area_t * area)
+{
+    lv_area_t content;
+    lv_obj_get_content_coords(obj, &content);
+    lv_coord_t w = lv_area_get_width(&content);
+
+    *area = content;
+    area->x1 = content.x1 + (lv_coord_t)((int32_t)bin * w / dist->x_bins);
+    area->x2 = content.x1 + (lv_coord_t)((int32_t)(bin + 1) * w / dist->x_bins) - 1;
+    if (area->x2 < area->x1) {
+        area->x2 = area->x1;
+    }
+}
+
+static void dist_histogram_draw(lv_obj_t * obj, const struct gfx_dist * dist, lv_draw_ctx_t * draw_ctx)
+{
+    lv_area_t content;
+    lv_obj_get_content_coords(obj, &content);
+    lv_coord_t h = lv_area_get_height(&content);
+    lv_coord_t w = lv_area_get_width(&content);
+
+    lv_draw_rect_dsc_t bar_dsc;
+    lv_draw_rect_dsc_init(&bar_dsc);
+    bar_dsc.bg_color = lv_obj_get_style_border_color(obj, LV_PART_MAIN);
+
+    // Only the bins inside the invalidated area
+    int32_t first = (int32_t)(draw_ctx->clip_area->x1 - content.x1) * dist->x_bins / w;
+    int32_t last = (int32_t)(draw_ctx->clip_area->x2 - content.x1 + 1) * dist->x_bins / w;
+    first = LV_CLAMP(0, first, dist->x_bins - 1);
+    last = LV_CLAMP(0, last, dist->x_bins - 1);
+
+    for (int32_t bin = first; bin <= last; bin++) {
+        uint32_t count = xlat_hist_count_get(bin);
+        if (count == 0) {
+            continue;
+        }
+        lv_area_t bar;
+        dist_bin_area_get(obj, dist, bin, &bar);
+        lv_coord_t bar_h = (lv_coord_t)((uint64_t)count * h / dist->y_scale);
+        bar.y1 = content.y2 - LV_MAX(bar_h, 1) + 1;
+        lv_draw_rect(draw_ctx, &bar_dsc, &bar);
+    }
+}
+
+static void dist_cdf_draw(lv_obj_t * obj, const struct gfx_dist * dist, lv_draw_ctx_t * draw_ctx)
+{
+    uint32_t total = xlat_hist_total_get();
+    if (total == 0) {
+        return;
+    }
+
+    lv_area_t content;
+    lv_obj_get_content_coords(obj, &content);
+    lv_coord_t h = lv_area_get_height(&content) - 1;
+
+    lv_draw_line_dsc_t line_dsc;
+    lv_draw_line_dsc_init(&line_dsc);
+    line_dsc.color = lv_obj_get_style_border_color(obj, LV_PART_MAIN);
+    line_dsc.width = 2;
+
+    // Every new sample moves the whole curve, the cost is bounded by the display refresh rate
+    uint32_t cumulative = 0;
+    lv_point_t prev = { content.x1, content.y2 };
+    for (uint16_t bin = 0; bin < dist->x_bins; bin++) {
+        lv_area_t bar;
+        dist_bin_area_get(obj, dist, bin, &bar);
+        cumulative += xlat_hist_count_get(bin);
+
+        lv_point_t next = { bar.x2, content.y2 - (lv_coord_t)((uint64_t)cumulative * h / total) };
+        lv_draw_line(draw_ctx, &line_dsc, &prev, &next);
+        prev = next;
+    }
+}
+
+static void dist_event_cb(lv_event_t * e)
+{
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    struct gfx_dist * dist = lv_obj_get_user_data(obj);
+
+    if (code == LV_EVENT_DRAW_MAIN) {
+        lv_draw_ctx_t * draw_ctx = lv_event_get_draw_ctx(e);
+
+        if (dist->view == GFX_DIST_HISTOGRAM) {
+            dist_histogram_draw(obj, dist, draw_ctx);
+        } else {
+            dist_cdf_draw(obj, dist, draw_ctx);
+        }
+
+        // Title and x range, only change together with the axes
+        char text[40];
+        uint32_t range_us = (uint32_t)dist->x_bins * XLAT_HIST_BIN_US;
+        snprintf(text, sizeof(text), "%s  0 - %lu.%lu ms", (dist->view == GFX_DIST_HISTOGRAM) ? "HIST" : "CDF",
+                 range_us / 1000, (range_us % 1000) / 100);
+
+        lv_draw_label_dsc_t label_dsc;
+        lv_draw_label_dsc_init(&label_dsc);
+        lv_obj_init_draw_label_dsc(obj, LV_PART_MAIN, &label_dsc);
+        lv_area_t label_area;
+        lv_obj_get_content_coords(obj, &label_area);
+        label_area.y2 = label_area.y1 + lv_font_get_line_height(label_dsc.font);
+        lv_draw_label(draw_ctx, &label_dsc, &label_area, text, NULL);
+    } else if (code == LV_EVENT_DELETE) {
+        lv_mem_free(dist);
+    }
+}
+
+
+// PUBLIC FUNCTIONS
+
+lv_obj_t * gfx_dist_create(lv_obj_t * parent, gfx_dist_view_t view)
+{
+    struct gfx_dist * dist = lv_mem_alloc(sizeof(struct gfx_dist));
+    LV_ASSERT_MALLOC(dist);
+    dist->view = view;
+    dist_scale_reset(dist);
+
+    lv_obj_t * obj = lv_obj_create(parent);
+    lv_obj_clear_flag(obj, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_user_data(obj, dist);
+    lv_obj_add_event_cb(obj, dist_event_cb, LV_EVENT_ALL, NULL);
+    return obj;
+}
+
+void gfx_dist_sample_added(lv_obj_t * obj, uint32_t latency_us)
+{
+    struct gfx_dist * dist = lv_obj_get_user_data(obj);
+
+    if (dist_scale_update(dist) || (dist->view == GFX_DIST_CDF)) {
+        lv_obj_invalidate(obj);
+        return;
+    }
+
+    // The axes didn't change: only the bar of this sample grew
+    lv_area_t bar;
+    dist_bin_area_get(obj, dist, xlat_hist_bin_get(latency_us), &bar);
+    lv_obj_invalidate_area(obj, &bar);
+}
+
+void gfx_dist_reset(lv_obj_t * obj)
+{
+    struct gfx_dist * dist = lv_obj_get_user_data(obj);
+
+    dist_scale_reset(dist);
+    lv_obj_invalidate(obj);
+}
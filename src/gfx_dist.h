@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef GFX_DIST_H
+#define GFX_DIST_H
+
+#include <stdint.h>
+#include "lvgl/lvgl.h"
+
+/*
+ * Latency distribution plots, drawn straight from the xlat_hist bins.
+ *
+ * A new sample only invalidates the histogram bar it went into. The axes are
+ * rescaled in powers of two, so a full redraw is only needed a few times per run.
+ */
+
+typedef enum gfx_dist_view {
+    GFX_DIST_HISTOGRAM,
+    GFX_DIST_CDF,
+} gfx_dist_view_t;
+
+lv_obj_t * gfx_dist_create(lv_obj_t * parent, gfx_dist_view_t view);
+void gfx_dist_sample_added(lv_obj_t * obj, uint32_t latency_us);
+void gfx_dist_reset(lv_obj_t * obj);
+
+#endif //GFX_DIST_H
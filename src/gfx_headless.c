@@ -0,0 +1,344 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Headless front-end, replaces gfx_main.c and gfx_settings.c in the xlat_headless build.
+ *
+ * There is no display stack: measurements are streamed as CSV over the serial console
+ * (USART1, the ST-LINK VCP). Commands are taken by xlat_cmd.c on the same port.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gfx_main.h"
+
+#include <main.h>
+#include <usb_task.h>
+
+#include "cmsis_os.h"
+#include "xlat.h"
+#include "xlat_config.h"
+#include "xlat_autostop.h"
+#include "xlat_campaign.h"
+#include "xlat_robust.h"
+#include "xlat_sdlog.h"
+#include "stdio_glue.h"
+
+// How long the task sleeps at most
+#define HEADLESS_POLL_MS 20
+
+// Auto-trigger run, driven from the task loop instead of LVGL timers
+static uint32_t trigger_remaining = 0;
+static bool trigger_pressed = false;
+static uint32_t trigger_next_tick;
+static bool trigger_segment_done = false;   // campaign segment over, next one starts after the release
+
+static void console_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+static void console_printf(const char *fmt, ...)
+{
+    char buf[100];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    vcp_writestr(buf);
+}
+
+static const char *mode_name_get(void)
+{
+    switch (xlat_mode_get()) {
+        case XLAT_MODE_MOUSE_CLICK:
+            return "click";
+        case XLAT_MODE_MOUSE_MOTION:
+            return "motion";
+        case XLAT_MODE_KEYBOARD:
+            return "key";
+        default:
+            return "unknown";
+    }
+}
+
+static void trigger_start(uint32_t count)
+{
+    trigger_remaining = count;
+    trigger_pressed = false;
+    trigger_segment_done = false;
+    trigger_next_tick = xTaskGetTickCount();
+    if (xlat_autostop_enabled()) {
+        // The stopping rule is about this run only
+        xlat_latency_reset();
+    }
+    srand(xlat_counter_1mhz_get());
+    console_printf("# trigger: %lu presses, every %lu ms\n", count, xlat_auto_trigger_interval_ms_get());
+}
+
+static void trigger_stop(void)
+{
+    xlat_campaign_abort();
+    trigger_segment_done = false;
+    if (trigger_pressed) {
+        xlat_auto_trigger_turn_off_action();
+        trigger_pressed = false;
+    }
+    trigger_remaining = 0;
+}
+
+static void campaign_segment_print(uint8_t index)
+{
+    const struct xlat_campaign_segment *seg = xlat_campaign_segment_get(index);
+
+    console_printf("# segment %u: %lu presses, every %u ms, pressed %u ms, %s edge, holdoff %lu us\n",
+                   index + 1, seg->count, seg->interval_ms, seg->pressed_ms, seg->rising ? "rising" : "falling",
+                   seg->holdoff_us);
+}
+
+static void campaign_start(void)
+{
+    uint32_t count = xlat_campaign_start();
+
+    if (!count) {
+        vcp_writestr("# campaign: no segments\n");
+        return;
+    }
+    xlat_latency_reset();
+    campaign_segment_print(0);
+    trigger_start(count);
+}
+
+// The previous segment is complete: report it, then start the next one with fresh statistics
+static void campaign_segment_next(void)
+{
+    struct xlat_campaign_result result;
+    uint8_t index = xlat_campaign_segment_index_get();
+
+    trigger_segment_done = false;
+    trigger_remaining = xlat_campaign_next();
+    if (xlat_campaign_result_get(index, &result)) {
+        console_printf("# segment %u done: count %lu, avg %lu us, stdev %lu us\n",
+                       index + 1, result.count, result.avg_us, result.stdev_us);
+    }
+    xlat_latency_reset();
+
+    if (trigger_remaining) {
+        campaign_segment_print(index + 1);
+    } else {
+        vcp_writestr("# campaign done\n");
+    }
+}
+
+static bool trigger_autostop(void)
+{
+    struct xlat_autostop_status st;
+
+    if (!xlat_autostop_check(&st)) {
+        return false;
+    }
+    console_printf("# autostop: %lu samples, mean +/- %lu us\n", st.count, st.mean_half_width_us);
+    return true;
+}
+
+// Returns the number of ticks until the next press or release
+static uint32_t trigger_run(void)
+{
+    if (!trigger_remaining && !trigger_pressed && !trigger_segment_done) {
+        return HEADLESS_POLL_MS;
+    }
+
+    int32_t wait = (int32_t)(trigger_next_tick - xTaskGetTickCount());
+    if (wait > 0) {
+        return (uint32_t)wait;
+    }
+
+    // The run ends early once the latency is known well enough
+    if (!trigger_pressed && trigger_remaining && trigger_autostop()) {
+        trigger_remaining = 0;
+        if (xlat_campaign_running()) {
+            trigger_segment_done = true;
+        } else {
+            vcp_writestr("# trigger done\n");
+            return HEADLESS_POLL_MS;
+        }
+    }
+
+    if (trigger_segment_done && !trigger_pressed) {
+        campaign_segment_next();
+        if (!trigger_remaining) {
+            return HEADLESS_POLL_MS;
+        }
+    }
+
+    xlat_auto_trigger_desync_sof();
+    if (trigger_pressed) {
+        xlat_auto_trigger_turn_off_action();
+        trigger_pressed = false;
+        trigger_next_tick += pdMS_TO_TICKS(xlat_auto_trigger_interval_ms_get() - xlat_auto_trigger_pressed_ms_get() + (rand() % 10));
+    } else {
+        // There is no GUI, every sample is taken with nothing else going on
+        xlat_quiet_window_start();
+        xlat_auto_trigger_action();
+        trigger_pressed = true;
+        trigger_remaining--;
+        if (!trigger_remaining) {
+            if (xlat_campaign_running()) {
+                trigger_segment_done = true;
+            } else {
+                vcp_writestr("# trigger done\n");
+            }
+        }
+        trigger_next_tick = xTaskGetTickCount() + pdMS_TO_TICKS(xlat_auto_trigger_pressed_ms_get());
+    }
+    return 0;
+}
+
+static void console_status(void)
+{
+    console_printf("# device: %s %s (%s)\n", usb_host_get_manuf_string(), usb_host_get_product_string(),
+                   usb_host_get_vidpid_string());
+    console_printf("# mode: %s, trigger remaining: %lu\n", mode_name_get(), trigger_remaining);
+    console_printf("# count %lu, avg %lu us, stdev %lu us, hid event drops %lu\n",
+                   xlat_latency_count_get(LATENCY_GPIO_TO_USB),
+                   xlat_latency_average_get(LATENCY_GPIO_TO_USB),
+                   xlat_latency_standard_deviation_get(LATENCY_GPIO_TO_USB),
+                   xlat_hid_event_drop_count_get());
+    console_printf("# median %lu us, MAD %lu us, %lu outliers, excluded: avg %lu us, stdev %lu us\n",
+                   xlat_robust_median_get(), xlat_robust_mad_get(), xlat_robust_outlier_count_get(),
+                   xlat_robust_inlier_average_get(), xlat_robust_inlier_standard_deviation_get());
+
+    struct xlat_sdlog_stats sdlog;
+    xlat_sdlog_stats_get(&sdlog);
+    if (sdlog.mounted) {
+        console_printf("# sd log: run %lu, %lu blocks written, %lu drops, %lu write errors\n",
+                       sdlog.run, sdlog.blocks_written, sdlog.drops, sdlog.write_errors);
+    } else {
+        vcp_writestr("# sd log: off\n");
+    }
+}
+
+static void gfx_event_handle(struct gfx_event *g_evt)
+{
+    switch (g_evt->type)
+    {
+    case GFX_EVENT_MEASUREMENT:
+        xlat_print_measurement();
+        break;
+
+    case GFX_EVENT_DEVICE_CONNECTED:
+        console_status();
+        break;
+
+    case GFX_EVENT_MODE_CHANGED:
+        console_printf("# mode: %s\n", mode_name_get());
+        break;
+
+    case GFX_EVENT_DEVICE_DISCONNECTED:
+        trigger_stop();
+        xlat_latency_reset();
+        vcp_writestr("# device disconnected\n");
+        break;
+
+    case GFX_EVENT_TRIGGER_START:
+        trigger_start(g_evt->value);
+        break;
+
+    case GFX_EVENT_TRIGGER_STOP:
+        trigger_stop();
+        vcp_writestr("# stopped\n");
+        break;
+
+    case GFX_EVENT_CLEAR:
+        xlat_latency_reset();
+        vcp_writestr("# cleared\n");
+        break;
+
+    case GFX_EVENT_CAMPAIGN_START:
+        campaign_start();
+        break;
+
+    case GFX_EVENT_SETTINGS_CHANGED:
+        // Nothing shows them
+        break;
+    }
+
+    // free event memory
+    osPoolFree(gfxevt_pool, g_evt);
+}
+
+
+// PUBLIC FUNCTIONS
+
+void gfx_init(void)
+{
+}
+
+void gfx_task(void const * argument)
+{
+    (void)argument;
+
+    while (!xlat_initialized) {
+        osDelay(1);
+    }
+
+    vcp_writestr("# xlat headless, type 'help' for the commands\n");
+
+    while (1) {
+        uint32_t sleep_ms = trigger_run();
+        if (sleep_ms > HEADLESS_POLL_MS) {
+            sleep_ms = HEADLESS_POLL_MS;
+        }
+
+        osEvent evt = osMessageGet(msgQGfxTask, sleep_ms);
+        while (evt.status == osEventMessage) {
+            gfx_event_handle(evt.value.p);
+            evt = osMessageGet(msgQGfxTask, 0);
+        }
+    }
+}
+
+void gfx_trigger_ready_set(bool state)
+{
+    (void)state;
+}
+
+uint32_t gfx_trigger_remaining_get(void)
+{
+    return trigger_remaining;
+}
+
+bool gfx_trigger_running_get(void)
+{
+    return trigger_remaining || trigger_pressed || trigger_segment_done;
+}
+
+bool gfx_event_send(gfx_event_t type, int32_t value)
+{
+    struct gfx_event *evt;
+    evt = osPoolAlloc(gfxevt_pool); // Allocate memory for the message
+    if (evt == NULL) {
+        return false;
+    }
+    evt->type = type;
+    evt->value = value;
+    if (osMessagePut(msgQGfxTask, (uint32_t)evt, 0U) != osOK) {
+        osPoolFree(gfxevt_pool, evt);
+        return false;
+    }
+    return true;
+}
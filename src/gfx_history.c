@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include "gfx_history.h"
+#include "xlat_history.h"
+
+#define HISTORY_MAX_COLUMNS     480     // display width
+#define HISTORY_MIN_SPAN        32      // samples across the plot at the highest zoom
+#define HISTORY_ZOOM_STEP_PX    20      // vertical drag distance per 2x zoom
+#define HISTORY_Y_ROUND_US      1000
+
+struct gfx_history {
+    uint32_t first;     // sample at the left edge
+    uint32_t span;      // samples across the plot
+    bool follow;        // show the whole run, panning or zooming turns this off
+    bool gesture;       // the current press panned or zoomed, it is not a tap
+    lv_coord_t zoom_acc;
+};
+
+// Column envelopes, min > max marks an empty column
+static struct xlat_history_span columns[HISTORY_MAX_COLUMNS];
+
+static void history_view_clamp(struct gfx_history * hist)
+{
+    uint32_t count = xlat_history_count_get();
+
+    if (hist->span < HISTORY_MIN_SPAN) {
+        hist->span = HISTORY_MIN_SPAN;
+    }
+    if (hist->follow || (hist->span >= count)) {
+        hist->follow = true;
+        hist->first = 0;
+        hist->span = LV_MAX(count, HISTORY_MIN_SPAN);
+    } else if (hist->first > count - hist->span) {
+        hist->first = count - hist->span;
+    }
+}
+
+static void history_draw(lv_obj_t * obj, struct gfx_history * hist, lv_draw_ctx_t * draw_ctx)
+{
+    lv_area_t content;
+    lv_obj_get_content_coords(obj, &content);
+    lv_coord_t w = LV_MIN(lv_area_get_width(&content), HISTORY_MAX_COLUMNS);
+    lv_coord_t h = lv_area_get_height(&content) - 1;
+
+    history_view_clamp(hist);
+
+    // First pass: envelopes of all columns, for the y range
+    uint32_t y_max = 0;
+    for (lv_coord_t col = 0; col < w; col++) {
+        uint32_t s0 = hist->first + (uint32_t)((uint64_t)col * hist->span / w);
+        uint32_t s1 = hist->first + (uint32_t)((uint64_t)(col + 1) * hist->span / w);
+        if (!xlat_history_span_get(s0, LV_MAX(s1, s0 + 1), &columns[col])) {
+            columns[col].min = UINT16_MAX;
+            columns[col].max = 0;
+        } else if (columns[col].max > y_max) {
+            y_max = columns[col].max;
+        }
+    }
+    uint32_t y_range = LV_MAX((y_max + HISTORY_Y_ROUND_US - 1) / HISTORY_Y_ROUND_US * HISTORY_Y_ROUND_US,
+                              HISTORY_Y_ROUND_US);
+
+    // Second pass: only the columns inside the invalidated area
+    lv_draw_rect_dsc_t col_dsc;
+    lv_draw_rect_dsc_init(&col_dsc);
+    col_dsc.bg_color = lv_obj_get_style_border_color(obj, LV_PART_MAIN);
+
+    lv_coord_t col_first = LV_MAX(draw_ctx->clip_area->x1 - content.x1, 0);
+    lv_coord_t col_last = LV_MIN(draw_ctx->clip_area->x2 - content.x1, w - 1);
+    for (lv_coord_t col = col_first; col <= col_last; col++) {
+        if (columns[col].min > columns[col].max) {
+            continue;
+        }
+        lv_area_t area = {
+            .x1 = content.x1 + col,
+            .x2 = content.x1 + col,
+            .y1 = content.y2 - (lv_coord_t)((uint64_t)columns[col].max * h / y_range),
+            .y2 = content.y2 - (lv_coord_t)((uint64_t)columns[col].min * h / y_range),
+        };
+        lv_draw_rect(draw_ctx, &col_dsc, &area);
+    }
+
+    char text[48];
+    uint32_t last = LV_MIN(hist->first + hist->span, xlat_history_count_get());
+    snprintf(text, sizeof(text), "HISTORY  #%lu-%lu  0 - %lu ms%s", hist->first + 1, last,
+             y_range / 1000, hist->follow ? "" : "  (hold: all)");
+
+    lv_draw_label_dsc_t label_dsc;
+    lv_draw_label_dsc_init(&label_dsc);
+    lv_obj_init_draw_label_dsc(obj, LV_PART_MAIN, &label_dsc);
+    lv_area_t label_area = content;
+    label_area.y2 = label_area.y1 + lv_font_get_line_height(label_dsc.font);
+    lv_draw_label(draw_ctx, &label_dsc, &label_area, text, NULL);
+}
+
+static void history_drag(lv_obj_t * obj, struct gfx_history * hist)
+{
+    lv_point_t vect;
+    lv_indev_get_vect(lv_indev_get_act(), &vect);
+    if ((vect.x == 0) && (vect.y == 0)) {
+        return;
+    }
+
+    lv_area_t content;
+    lv_obj_get_content_coords(obj, &content);
+    int64_t w = lv_area_get_width(&content);
+
+    history_view_clamp(hist);
+    hist->follow = false;
+    hist->gesture = true;
+
+    // Pan: dragging to the right shows earlier samples
+    int64_t first = (int64_t)hist->first - (int64_t)vect.x * hist->span / w;
+    hist->first = (first < 0) ? 0 : (uint32_t)first;
+
+    // Zoom around the center: dragging up zooms in
+    hist->zoom_acc += vect.y;
+    while (hist->zoom_acc <= -HISTORY_ZOOM_STEP_PX) {
+        hist->zoom_acc += HISTORY_ZOOM_STEP_PX;
+        if (hist->span / 2 >= HISTORY_MIN_SPAN) {
+            hist->first += hist->span / 4;
+            hist->span /= 2;
+        }
+    }
+    while (hist->zoom_acc >= HISTORY_ZOOM_STEP_PX) {
+        hist->zoom_acc -= HISTORY_ZOOM_STEP_PX;
+        hist->first = (hist->first > hist->span / 2) ? (hist->first - hist->span / 2) : 0;
+        hist->span *= 2;
+    }
+
+    history_view_clamp(hist);
+    lv_obj_invalidate(obj);
+}
+
+static void history_event_cb(lv_event_t * e)
+{
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    struct gfx_history * hist = lv_obj_get_user_data(obj);
+
+    switch (code) {
+        case LV_EVENT_DRAW_MAIN:
+            history_draw(obj, hist, lv_event_get_draw_ctx(e));
+            break;
+
+        case LV_EVENT_PRESSED:
+            hist->gesture = false;
+            hist->zoom_acc = 0;
+            break;
+
+        case LV_EVENT_PRESSING:
+            history_drag(obj, hist);
+            break;
+
+        case LV_EVENT_LONG_PRESSED:
+            hist->follow = true;
+            hist->gesture = true;
+            lv_obj_invalidate(obj);
+            break;
+
+        case LV_EVENT_CLICKED:
+            // Registered first: keep a pan or zoom from also counting as a tap
+            if (hist->gesture) {
+                lv_event_stop_processing(e);
+            }
+            break;
+
+        case LV_EVENT_DELETE:
+            lv_mem_free(hist);
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+// PUBLIC FUNCTIONS
+
+lv_obj_t * gfx_history_create(lv_obj_t * parent)
+{
+    struct gfx_history * hist = lv_mem_alloc(sizeof(struct gfx_history));
+    LV_ASSERT_MALLOC(hist);
+    lv_memset_00(hist, sizeof(struct gfx_history));
+    hist->follow = true;
+
+    lv_obj_t * obj = lv_obj_create(parent);
+    lv_obj_clear_flag(obj, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_SCROLL_CHAIN);
+    lv_obj_set_user_data(obj, hist);
+    lv_obj_add_event_cb(obj, history_event_cb, LV_EVENT_ALL, NULL);
+    return obj;
+}
+
+void gfx_history_sample_added(lv_obj_t * obj)
+{
+    struct gfx_history * hist = lv_obj_get_user_data(obj);
+    uint32_t sample = xlat_history_count_get() - 1;
+
+    // A zoomed in view only changes when the new sample is on screen
+    if (hist->follow || ((sample >= hist->first) && (sample < hist->first + hist->span))) {
+        lv_obj_invalidate(obj);
+    }
+}
+
+void gfx_history_reset(lv_obj_t * obj)
+{
+    struct gfx_history * hist = lv_obj_get_user_data(obj);
+
+    hist->follow = true;
+    lv_obj_invalidate(obj);
+}
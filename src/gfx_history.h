@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef GFX_HISTORY_H
+#define GFX_HISTORY_H
+
+#include "lvgl/lvgl.h"
+
+/*
+ * Full-run history plot, drawn from the xlat_history min/max pyramid.
+ *
+ * Every column shows the min/max envelope of the samples under it, so spikes
+ * stay visible at any zoom. Drag left/right to pan, drag up/down to zoom in/out,
+ * long press to go back to the whole run.
+ */
+
+lv_obj_t * gfx_history_create(lv_obj_t * parent);
+void gfx_history_sample_added(lv_obj_t * obj);
+void gfx_history_reset(lv_obj_t * obj);
+
+#endif //GFX_HISTORY_H
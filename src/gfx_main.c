@@ -29,7 +29,13 @@
 #include "tft/tft.h"
 #include "xlat.h"
 #include "xlat_config.h"
+#include "xlat_autostop.h"
+#include "xlat_campaign.h"
+#include "xlat_robust.h"
+#include "xlat_trace.h"
 #include "gfx_settings.h"
+#include "gfx_dist.h"
+#include "gfx_history.h"
 
 #define Y_CHART_SIZE_X 410
 #define Y_CHART_SIZE_Y 130
@@ -41,9 +47,14 @@
 #define Y_CHART_TICKS_MAJOR 6
 #define Y_CHART_TICKS_MINOR 2
 
+// Upper bound for the gfx task sleep, in case no LVGL timer is pending
+#define GFX_MAX_SLEEP_MS 100
+
 lv_color_t lv_color_lightblue = LV_COLOR_MAKE(0xa6, 0xd1, 0xd1);
 
 static lv_obj_t * chart;
+static lv_obj_t * dist_views[2];   // histogram and CDF, in place of the chart
+static lv_obj_t * history_view;    // whole run, in place of the chart
 static lv_obj_t * latency_label;
 static lv_obj_t * productname_label;
 static lv_obj_t * manufacturer_label;
@@ -58,6 +69,10 @@ static lv_coord_t chart_y_range = 0;
 
 static lv_timer_t * trigger_timer = NULL;
 static lv_timer_t * trigger_timer_turn_off = NULL;
+static size_t trigger_count = 0;  // presses left in the auto-trigger run
+
+static bool latency_view_robust = false; // latency label: all samples, or the outliers excluded
+static bool quiet_paused = false; // redraws and touch reads are paused for a quiet window
 
 static void chart_reset(void);
 
@@ -65,15 +80,33 @@ LV_IMG_DECLARE(xlat_logo);
 
 static void latency_label_update(void)
 {
-    lv_label_set_text_fmt(latency_label, "#%lu: %ldus, avg %ldus, stdev %ldus",
-                          xlat_latency_count_get(LATENCY_GPIO_TO_USB),
-                          xlat_last_latency_us_get(LATENCY_GPIO_TO_USB),
-                          xlat_latency_average_get(LATENCY_GPIO_TO_USB),
-                          xlat_latency_standard_deviation_get(LATENCY_GPIO_TO_USB)
-                          );
+    if (latency_view_robust) {
+        lv_label_set_text_fmt(latency_label, "-%lu outl.: avg %ldus, stdev %ldus, med %ldus, MAD %ldus",
+                              xlat_robust_outlier_count_get(),
+                              xlat_robust_inlier_average_get(),
+                              xlat_robust_inlier_standard_deviation_get(),
+                              xlat_robust_median_get(),
+                              xlat_robust_mad_get()
+                              );
+    } else {
+        lv_label_set_text_fmt(latency_label, "#%lu: %ldus, avg %ldus, stdev %ldus",
+                              xlat_latency_count_get(LATENCY_GPIO_TO_USB),
+                              xlat_last_latency_us_get(LATENCY_GPIO_TO_USB),
+                              xlat_latency_average_get(LATENCY_GPIO_TO_USB),
+                              xlat_latency_standard_deviation_get(LATENCY_GPIO_TO_USB)
+                              );
+    }
     lv_obj_align_to(latency_label, chart, LV_ALIGN_OUT_TOP_MID, 0, 0);
 }
 
+static void latency_label_event_cb(lv_event_t * e)
+{
+    if (lv_event_get_code(e) == LV_EVENT_CLICKED) {
+        latency_view_robust = !latency_view_robust;
+        latency_label_update();
+    }
+}
+
 void gfx_device_label_set(const char * manufacturer, const char * productname, const char *vidpid)
 {
     char tempstr[21];
@@ -101,6 +134,9 @@ static void latency_measurements_clear(void)
     // reset latency numbers
     xlat_latency_reset();
     chart_reset();
+    gfx_dist_reset(dist_views[GFX_DIST_HISTOGRAM]);
+    gfx_dist_reset(dist_views[GFX_DIST_CDF]);
+    gfx_history_reset(history_view);
     latency_label_update();
 }
 
@@ -143,24 +179,49 @@ static void auto_trigger_clear_timer(void)
         lv_timer_del(trigger_timer);
         trigger_timer = NULL;
     }
+    trigger_count = 0;
 }
 
-// Busy-wait a random 0..999 us before each GPIO edge toggle so the edge
-// phase is uniform vs the USB SOF — works for both speeds:
-//   - HS (125 us microframe): 1000 = 8 * 125, so delay_us mod 125 is
-//     uniform 0..124 -> uniform phase vs HS SOF.
-//   - FS (1 ms frame): delay_us is already uniform across the full frame.
-static void auto_trigger_desync_sof(void)
+// Pause the display refresh and the touch reads until the matching report was measured.
+// The rest of this lv_task_handler() pass skips the paused timers, the gfx task then
+// doesn't call it again until the window is over.
+static void quiet_window_start(void)
 {
-    uint32_t delay_us = rand() % 1000;
-    uint32_t t0 = xlat_counter_1mhz_get();
-    while ((xlat_counter_1mhz_get() - t0) < delay_us) { /* spin */ }
+    if (!xlat_quiet_mode_is_enabled()) {
+        return;
+    }
+
+    lv_timer_pause(lv_disp_get_default()->refr_timer);
+    for (lv_indev_t * indev = lv_indev_get_next(NULL); indev; indev = lv_indev_get_next(indev)) {
+        lv_timer_pause(indev->driver->read_timer);
+    }
+    quiet_paused = true;
+    xlat_quiet_window_start();
+}
+
+// Returns true while the GUI has to stay quiet, resumes it once the window is over
+static bool quiet_window_hold(void)
+{
+    if (!quiet_paused) {
+        return false;
+    }
+    if (xlat_quiet_window_active()) {
+        return true;
+    }
+
+    // Everything that changed in the meantime is drawn in one go
+    lv_timer_resume(lv_disp_get_default()->refr_timer);
+    for (lv_indev_t * indev = lv_indev_get_next(NULL); indev; indev = lv_indev_get_next(indev)) {
+        lv_timer_resume(indev->driver->read_timer);
+    }
+    quiet_paused = false;
+    return false;
 }
 
 void auto_trigger_turn_off_callback(lv_timer_t * timer)
 {
     (void)timer;
-    auto_trigger_desync_sof();
+    xlat_auto_trigger_desync_sof();
     xlat_auto_trigger_turn_off_action();
 }
 
@@ -168,45 +229,86 @@ void auto_trigger_callback(lv_timer_t * timer)
 {
     char label[20];
     size_t * count = timer->user_data;
+    struct xlat_autostop_status autostop;
 
-    auto_trigger_desync_sof();
-    xlat_auto_trigger_action();
-    trigger_timer_turn_off = lv_timer_create(auto_trigger_turn_off_callback, AUTO_TRIGGER_PRESSED_PERIOD_MS, NULL);
-    lv_timer_set_repeat_count(trigger_timer_turn_off, 1);
+    // The run ends early once the latency is known well enough
+    if (*count && xlat_autostop_check(&autostop)) {
+        printf("AutoTrigger stopped: %lu samples, mean +/- %lu us\n", autostop.count, autostop.mean_half_width_us);
+        *count = 0;
+    }
+
+    // The last press of a campaign segment is released by now: the next segment starts
+    // with this press, as a run of its own
+    if (*count == 0) {
+        *count = xlat_campaign_next();
+        if (*count == 0) {
+            auto_trigger_clear_timer();
+            return;
+        }
+        latency_measurements_clear();
+    }
 
+    // Update the GUI state first, nothing is drawn until the quiet window is over
     *count = (*count) - 1;
     if (*count) {
-        sprintf(label, "%lu", (long)*count);
+        if (xlat_campaign_running()) {
+            sprintf(label, "%u: %lu", xlat_campaign_segment_index_get() + 1, (long)*count);
+        } else {
+            sprintf(label, "%lu", (long)*count);
+        }
         lv_label_set_text(trigger_label, label);    /*Set the labels text*/
         lv_obj_center(trigger_label);
 
         // Restart the timer with a random period added to the base period
         lv_timer_set_period(timer, xlat_auto_trigger_interval_ms_get() + (rand() % 10));
+    } else if (xlat_campaign_running()) {
+        // Keep the timer: one more interval for the release, then the next segment
+        lv_timer_set_period(timer, xlat_auto_trigger_interval_ms_get());
     } else {
         auto_trigger_clear_timer();
     }
+
+    // In quiet mode, the release is delayed until the window is over
+    trigger_timer_turn_off = lv_timer_create(auto_trigger_turn_off_callback, xlat_auto_trigger_pressed_ms_get(), NULL);
+    lv_timer_set_repeat_count(trigger_timer_turn_off, 1);
+
+    quiet_window_start();
+    xlat_auto_trigger_desync_sof();
+    xlat_auto_trigger_action();
 }
 
-static void btn_trigger_event_cb(lv_event_t * e)
+static void auto_trigger_start(size_t count)
+{
+    // Trigger a new series of measurements
+    printf("AutoTrigger activated\n");
+    auto_trigger_clear_timer();
+    if (xlat_autostop_enabled()) {
+        // The stopping rule is about this run only
+        latency_measurements_clear();
+    }
+    trigger_count = count;
+    // seed the random number generator
+    srand(xlat_counter_1mhz_get());
+    // start the timer
+    trigger_timer = lv_timer_create(auto_trigger_callback, xlat_auto_trigger_interval_ms_get(), &trigger_count);
+}
+
+static void auto_trigger_stop(void)
 {
-    static int32_t count;
+    xlat_campaign_abort();
+    auto_trigger_clear_timer();
+}
 
+static void btn_trigger_event_cb(lv_event_t * e)
+{
     lv_event_code_t code = lv_event_get_code(e);
 
     if (code == LV_EVENT_CLICKED) {
-        if (count) {
+        if (trigger_timer) {
             // Already running
-            count = 0;
-            auto_trigger_clear_timer();
+            auto_trigger_stop();
         } else {
-            // Trigger a new series of measurements
-            printf("AutoTrigger activated\n");
-            count = 1000;
-            // seed the random number generator
-            srand(xlat_counter_1mhz_get());
-            // start the timer
-            trigger_timer = lv_timer_create(auto_trigger_callback, xlat_auto_trigger_interval_ms_get(), &count);
-            //lv_timer_set_repeat_count(timer, count);
+            auto_trigger_start(xlat_autostop_run_length_get());
         }
     }
 }
@@ -216,15 +318,29 @@ static void btn_trigger_event_cb(lv_event_t * e)
 static void chart_reset(void)
 {
     lv_chart_series_t * ser = lv_chart_get_series_next(chart, NULL);
-    lv_chart_remove_series(chart, ser);
-    lv_chart_add_series(chart, lv_color_lightblue, LV_CHART_AXIS_PRIMARY_Y);
+    lv_chart_set_all_value(chart, ser, LV_CHART_POINT_NONE);
     lv_chart_set_x_start_point(chart, ser, 0);
 
     chart_point_count = 0;
     chart_y_range = Y_CHART_RANGE;
     lv_chart_set_range(chart, LV_CHART_AXIS_PRIMARY_Y, 0, chart_y_range);
+}
 
-    lv_chart_refresh(chart);
+// Invalidate the line segments that touch a point, instead of the whole chart with its axes
+static void chart_point_invalidate(uint16_t id)
+{
+    uint16_t point_cnt = lv_chart_get_point_count(chart);
+    lv_coord_t w = lv_obj_get_content_width(chart);
+    lv_coord_t line_width = lv_obj_get_style_line_width(chart, LV_PART_ITEMS);
+
+    lv_area_t area;
+    lv_obj_get_content_coords(chart, &area);
+    lv_coord_t x_ofs = area.x1;
+    area.x1 = x_ofs + (lv_coord_t)((int32_t)w * (id > 0 ? id - 1 : 0) / (point_cnt - 1)) - line_width;
+    area.x2 = x_ofs + (lv_coord_t)((int32_t)w * LV_MIN(id + 1, point_cnt - 1) / (point_cnt - 1)) + line_width;
+    area.y1 -= line_width;
+    area.y2 += line_width;
+    lv_obj_invalidate_area(chart, &area);
 }
 
 static void chart_update(uint32_t value)
@@ -238,20 +354,27 @@ static void chart_update(uint32_t value)
     value = value > (INT16_MAX / 1000 * 1000) ? (INT16_MAX / 1000 * 1000) : value;
 #endif
 
-    lv_chart_set_next_value(chart, lv_chart_get_series_next(chart, NULL), (lv_coord_t)value);
+    // Circular update: write the new point in place and blank the next one to mark the sweep position.
+    // lv_chart_set_next_value() would redraw the whole chart for every point.
+    lv_chart_series_t * ser = lv_chart_get_series_next(chart, NULL);
+    lv_coord_t * points = lv_chart_get_y_array(chart, ser);
+    uint16_t id = lv_chart_get_x_start_point(chart, ser);
+    uint16_t next = (id + 1) % lv_chart_get_point_count(chart);
+    points[id] = (lv_coord_t)value;
+    points[next] = LV_CHART_POINT_NONE;
+    lv_chart_set_x_start_point(chart, ser, next);
 
     // can't overflow because we clipped down to the nearest 1000 within signed while value is unsigned
     value = (value + 999) / 1000 * 1000; // round up to nearest 1000
 
-    // update y-axis range if needed
+    // update y-axis range if needed, this redraws the chart and its axes
     if (value > chart_y_range) {
         chart_y_range = (lv_coord_t)value;
+        lv_chart_set_range(chart, LV_CHART_AXIS_PRIMARY_Y, 0, chart_y_range);
+    } else {
+        chart_point_invalidate(id);
+        chart_point_invalidate(next);
     }
-
-    lv_chart_set_range(chart, LV_CHART_AXIS_PRIMARY_Y, 0, chart_y_range);
-
-    // refresh the chart
-    lv_chart_refresh(chart);
 }
 
 /**
@@ -266,6 +389,7 @@ void lv_chart_new(lv_coord_t yrange)
     lv_obj_set_size(chart, Y_CHART_SIZE_X, Y_CHART_SIZE_Y);
     lv_obj_align(chart, LV_ALIGN_CENTER, 20, 10);
     lv_chart_set_range(chart, LV_CHART_AXIS_PRIMARY_Y, 0, yrange);
+    lv_chart_set_update_mode(chart, LV_CHART_UPDATE_MODE_CIRCULAR);
 
     // Do not display points on the data
     lv_obj_set_style_size(chart, 0, LV_PART_INDICATOR);
@@ -281,6 +405,21 @@ void lv_chart_new(lv_coord_t yrange)
     chart_y_range = yrange;
 }
 
+// Tapping the plot cycles chart -> histogram -> CDF -> history
+static void plot_view_cycle_event_cb(lv_event_t * e)
+{
+    lv_obj_t * views[] = { chart, dist_views[GFX_DIST_HISTOGRAM], dist_views[GFX_DIST_CDF], history_view };
+    lv_obj_t * target = lv_event_get_current_target(e);
+
+    for (size_t i = 0; i < sizeof(views) / sizeof(views[0]); i++) {
+        if (views[i] == target) {
+            lv_obj_add_flag(target, LV_OBJ_FLAG_HIDDEN);
+            lv_obj_clear_flag(views[(i + 1) % (sizeof(views) / sizeof(views[0]))], LV_OBJ_FLAG_HIDDEN);
+            break;
+        }
+    }
+}
+
 #endif
 
 static lv_style_t style_btn;
@@ -466,6 +605,9 @@ void gfx_xlat_gui(void)
     latency_label = lv_label_create(lv_scr_act());
     lv_label_set_text(latency_label, "Click to start measurement...");
     lv_obj_align_to(latency_label, chart, LV_ALIGN_OUT_TOP_MID, 0, 0);
+    // Click to switch between all samples and the outliers excluded
+    lv_obj_add_flag(latency_label, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_event_cb(latency_label, latency_label_event_cb, LV_EVENT_CLICKED, NULL);
 
     // Trigger ready label
     trigger_ready_cb = lv_checkbox_create(lv_scr_act());
@@ -480,6 +622,23 @@ void gfx_xlat_gui(void)
     ///////////
     lv_chart_new(Y_CHART_RANGE);
     lv_chart_add_cursor(chart, lv_color_white(), LV_DIR_TOP);
+    lv_obj_add_event_cb(chart, plot_view_cycle_event_cb, LV_EVENT_CLICKED, NULL);
+
+    // Distribution views, hidden until the chart is tapped
+    for (int i = 0; i < 2; i++) {
+        dist_views[i] = gfx_dist_create(lv_scr_act(), (gfx_dist_view_t)i);
+        lv_obj_add_style(dist_views[i], &style_chart, 0);
+        lv_obj_set_size(dist_views[i], Y_CHART_SIZE_X, Y_CHART_SIZE_Y);
+        lv_obj_align(dist_views[i], LV_ALIGN_CENTER, 20, 10);
+        lv_obj_add_flag(dist_views[i], LV_OBJ_FLAG_HIDDEN);
+        lv_obj_add_event_cb(dist_views[i], plot_view_cycle_event_cb, LV_EVENT_CLICKED, NULL);
+    }
+    history_view = gfx_history_create(lv_scr_act());
+    lv_obj_add_style(history_view, &style_chart, 0);
+    lv_obj_set_size(history_view, Y_CHART_SIZE_X, Y_CHART_SIZE_Y);
+    lv_obj_align(history_view, LV_ALIGN_CENTER, 20, 10);
+    lv_obj_add_flag(history_view, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_add_event_cb(history_view, plot_view_cycle_event_cb, LV_EVENT_CLICKED, NULL);
     latency_measurements_clear();
 }
 
@@ -497,6 +656,93 @@ void gfx_init(void)
 }
 
 
+static void gfx_event_handle(struct gfx_event *g_evt)
+{
+    switch (g_evt->type)
+    {
+    case GFX_EVENT_MEASUREMENT:
+        // New measurement received
+
+        // guard with LVGL mutex
+        xSemaphoreTake(lvgl_mutex, portMAX_DELAY);
+        {
+            // update chart data
+            chart_update(g_evt->value);
+            gfx_dist_sample_added(dist_views[GFX_DIST_HISTOGRAM], g_evt->value);
+            gfx_dist_sample_added(dist_views[GFX_DIST_CDF], g_evt->value);
+            gfx_history_sample_added(history_view);
+
+            // update to latest xlat measurements
+            latency_label_update();
+        }
+        xSemaphoreGive(lvgl_mutex);
+        XLAT_TRACE(XLAT_TRACE_ID_GFX_UPDATE, 0, 0);
+
+        xlat_print_measurement();
+        break;
+
+    case GFX_EVENT_DEVICE_CONNECTED:
+        gfx_labels_update();
+        break;
+
+    case GFX_EVENT_MODE_CHANGED:
+        gfx_mode_label_set();
+        xSemaphoreTake(lvgl_mutex, portMAX_DELAY);
+        gfx_settings_refresh();
+        xSemaphoreGive(lvgl_mutex);
+        break;
+
+    case GFX_EVENT_SETTINGS_CHANGED:
+        xSemaphoreTake(lvgl_mutex, portMAX_DELAY);
+        gfx_settings_refresh();
+        xSemaphoreGive(lvgl_mutex);
+        break;
+
+    case GFX_EVENT_DEVICE_DISCONNECTED:
+        auto_trigger_stop(); // stop auto-trigger in case it's running
+        gfx_data_locations_label_set();
+        gfx_device_label_set("", "No USB device found", "");
+        gfx_mode_label_set();
+        latency_measurements_clear();
+        break;
+
+    // Run control from the serial command interface
+    case GFX_EVENT_TRIGGER_START:
+        xSemaphoreTake(lvgl_mutex, portMAX_DELAY);
+        auto_trigger_start(g_evt->value);
+        xSemaphoreGive(lvgl_mutex);
+        break;
+
+    case GFX_EVENT_TRIGGER_STOP:
+        xSemaphoreTake(lvgl_mutex, portMAX_DELAY);
+        auto_trigger_stop();
+        xSemaphoreGive(lvgl_mutex);
+        break;
+
+    case GFX_EVENT_CAMPAIGN_START:
+        xSemaphoreTake(lvgl_mutex, portMAX_DELAY);
+        {
+            // The statistics of the first segment start from scratch too
+            uint32_t count = xlat_campaign_start();
+            if (count) {
+                latency_measurements_clear();
+                auto_trigger_start(count);
+            }
+        }
+        xSemaphoreGive(lvgl_mutex);
+        break;
+
+    case GFX_EVENT_CLEAR:
+        xSemaphoreTake(lvgl_mutex, portMAX_DELAY);
+        latency_measurements_clear();
+        xSemaphoreGive(lvgl_mutex);
+        break;
+    }
+
+    // free event memory
+    osPoolFree(gfxevt_pool, g_evt);
+}
+
 void gfx_task(void const * argument)
 {
     (void)argument;
@@ -506,61 +752,29 @@ void gfx_task(void const * argument)
     }
 
     while (1) {
-        xSemaphoreTake(lvgl_mutex, portMAX_DELAY);
-        lv_task_handler();
-        xSemaphoreGive(lvgl_mutex);
+        // During a quiet window, only wake up for events (the measurement ends it) or the timeout
+        uint32_t sleep_ms = QUIET_WINDOW_TIMEOUT_MS;
 
-        if (osMessageWaiting(msgQGfxTask))
-        {
-            // pop the message
-            osEvent evt = osMessageGet(msgQGfxTask, 0);
-            if (evt.status != osEventMessage)
-            {
-                return;
+        tft_swap_wait();
+        xSemaphoreTake(lvgl_mutex, portMAX_DELAY);
+        if (!quiet_window_hold()) {
+            // Run the LVGL timers that are due. Redraws are paced by the display refresh
+            // timer (LV_DISP_DEF_REFR_PERIOD), no matter how often we get here.
+            sleep_ms = lv_task_handler();
+            if (sleep_ms > GFX_MAX_SLEEP_MS) {
+                sleep_ms = GFX_MAX_SLEEP_MS;
             }
+        }
+        xSemaphoreGive(lvgl_mutex);
 
-            struct gfx_event* g_evt = evt.value.p;
-            switch (g_evt->type)
-            {
-            case GFX_EVENT_MEASUREMENT:
-                // New measurement received
-
-                // guard with LVGL mutex
-                xSemaphoreTake(lvgl_mutex, portMAX_DELAY);
-                {
-                    // update chart data
-                    chart_update(g_evt->value);
-
-                    // update to latest xlat measurements
-                    latency_label_update();
-                }
-                xSemaphoreGive(lvgl_mutex);
-
-                xlat_print_measurement();
-                break;
-
-            case GFX_EVENT_DEVICE_CONNECTED:
-                gfx_labels_update();
-                break;
-
-            case GFX_EVENT_MODE_CHANGED:
-                gfx_mode_label_set();
-                break;
-
-            case GFX_EVENT_DEVICE_DISCONNECTED:
-                auto_trigger_clear_timer(); // stop auto-trigger in case it's running
-                gfx_data_locations_label_set();
-                gfx_device_label_set("", "No USB device found", "");
-                gfx_mode_label_set();
-                latency_measurements_clear();
-                break;
-            }
+        // Sleep until the next LVGL deadline, or until an event comes in
+        osEvent evt = osMessageGet(msgQGfxTask, sleep_ms);
 
-            // free event memory
-            osPoolFree(gfxevt_pool, g_evt);
+        // Drain everything that is pending, the next lv_task_handler() call renders it all at once
+        while (evt.status == osEventMessage) {
+            gfx_event_handle(evt.value.p);
+            evt = osMessageGet(msgQGfxTask, 0);
         }
-
-        osDelay(1);
     }
 }
 
@@ -578,11 +792,28 @@ void gfx_trigger_ready_set(bool state)
     }
 }
 
-void gfx_event_send(gfx_event_t type, int32_t value)
+uint32_t gfx_trigger_remaining_get(void)
+{
+    return trigger_count;
+}
+
+bool gfx_trigger_running_get(void)
+{
+    return trigger_timer != NULL;
+}
+
+bool gfx_event_send(gfx_event_t type, int32_t value)
 {
     struct gfx_event *evt;
     evt = osPoolAlloc(gfxevt_pool); // Allocate memory for the message
+    if (evt == NULL) {
+        return false;
+    }
     evt->type = type;
     evt->value = value;
-    osMessagePut(msgQGfxTask, (uint32_t)evt, 0U);
+    if (osMessagePut(msgQGfxTask, (uint32_t)evt, 0U) != osOK) {
+        osPoolFree(gfxevt_pool, evt);
+        return false;
+    }
+    return true;
 }
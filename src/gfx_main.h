@@ -30,6 +30,11 @@ typedef enum gfx_event_type {
     GFX_EVENT_DEVICE_CONNECTED,
     GFX_EVENT_DEVICE_DISCONNECTED,
     GFX_EVENT_MODE_CHANGED,
+    GFX_EVENT_TRIGGER_START,    // value: number of presses
+    GFX_EVENT_TRIGGER_STOP,
+    GFX_EVENT_CLEAR,            // reset the statistics, ends the run
+    GFX_EVENT_CAMPAIGN_START,   // see xlat_campaign.h
+    GFX_EVENT_SETTINGS_CHANGED, // changed from the serial command interface
 } gfx_event_t;
 
 struct gfx_event {
@@ -41,10 +46,12 @@ void gfx_init(void);
 void gfx_task(void const * argument);
 void gfx_device_label_set(const char * manufacturer, const char * productname, const char *vidpid);
 void gfx_trigger_ready_set(bool state);
+uint32_t gfx_trigger_remaining_get(void);     // of the run or campaign segment
+bool gfx_trigger_running_get(void);
 void gfx_data_locations_label_set(void);
 void gfx_mode_label_set(void);
 void gfx_labels_update(void);
-void gfx_event_send(gfx_event_t type, int32_t value);
+bool gfx_event_send(gfx_event_t type, int32_t value);      // false when the queue is full
 void gfx_xlat_gui(void);
 
 #endif //XLAT_F7_FW_GFX_H
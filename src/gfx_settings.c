@@ -21,11 +21,17 @@
 #include "lvgl/lvgl.h"
 #include "xlat.h"
 #include "xlat_config.h"
+#include "xlat_autostop.h"
 #include "hardware_config.h"
+#include "xlat_diag.h"
+
+// Auto-stop choices after "Off": the mean is known to +/- this many us (95 % confidence)
+static const uint32_t autostop_half_widths_us[] = { 50, 20, 10, 5 };
 
 // UI layout constants
 #define LABEL_WIDTH 180
 #define DROPDOWN_WIDTH 180
+#define DIAG_UPDATE_PERIOD_MS 1000
 
 // Pointers to the widgets
 lv_obj_t *settings_screen;
@@ -37,6 +43,10 @@ lv_obj_t *trigger_dropdown;
 lv_obj_t *mode_dropdown;
 lv_obj_t *trigger_output_dropdown;
 lv_obj_t *trigger_interval_dropdown;
+lv_obj_t *quiet_mode_dropdown;
+lv_obj_t *autostop_dropdown;
+lv_obj_t *diag_label;
+static lv_timer_t *diag_timer = NULL;
 
 // Event handler for the back button
 static void back_btn_event_handler(lv_event_t* e)
@@ -46,6 +56,7 @@ static void back_btn_event_handler(lv_event_t* e)
         if (prev_screen) {
             lv_scr_load(prev_screen);
             lv_obj_del(settings_screen);
+            settings_screen = NULL;
         }
     }
 }
@@ -105,10 +116,75 @@ static void event_handler(lv_event_t* e)
             uint16_t sel = lv_dropdown_get_selected(obj);
             uint8_t pin = (sel == 0) ? 6 : 11; // D6 or D11
             xlat_auto_trigger_output_set(pin);
+        } else if (obj == quiet_mode_dropdown) {
+            uint16_t sel = lv_dropdown_get_selected(obj);
+            xlat_quiet_mode_set(sel);
+        } else if (obj == autostop_dropdown) {
+            uint16_t sel = lv_dropdown_get_selected(obj);
+            struct xlat_autostop_config cfg;
+            xlat_autostop_config_get(&cfg);
+            cfg.enabled = (sel != 0);
+            if (sel) {
+                cfg.level_pct = 95;
+                cfg.mean_half_width_us = autostop_half_widths_us[sel - 1];
+            }
+            xlat_autostop_config_set(&cfg);
         }
     }
 }
 
+static void diag_label_update(void)
+{
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    xlat_diag_lvgl_mem_set(mon.total_size, mon.total_size - mon.free_size, mon.max_used, mon.frag_pct);
+
+    xlat_diag_update();
+    const struct xlat_diag *diag = xlat_diag_get();
+
+    char text[768];
+    size_t len = 0;
+    for (uint8_t i = 0; (i < diag->task_count) && (len < sizeof(text)); i++) {
+        len += snprintf(&text[len], sizeof(text) - len, "%-12s CPU %3u.%u %%   stack free %5lu B\n",
+                        diag->tasks[i].name, diag->tasks[i].cpu_permille / 10, diag->tasks[i].cpu_permille % 10,
+                        diag->tasks[i].stack_free_min);
+    }
+    if (len < sizeof(text)) {
+        len += snprintf(&text[len], sizeof(text) - len,
+                        "ISR: EXTI %u.%u %%, OTG_HS %u.%u %%\n"
+                        "FreeRTOS heap: %u B free, %u B min ever\n"
+                        "LVGL mem: %lu of %lu B used, %lu B max, %u %% frag\n"
+                        "Drops: HID events %lu, log %lu, trace %lu, USB CDC %lu, SD %lu\n"
+                        "HID proxy: %lu reports, added delay avg %lu us, max %lu us",
+                        diag->isr_permille[XLAT_DIAG_ISR_EXTI] / 10, diag->isr_permille[XLAT_DIAG_ISR_EXTI] % 10,
+                        diag->isr_permille[XLAT_DIAG_ISR_OTG_HS] / 10, diag->isr_permille[XLAT_DIAG_ISR_OTG_HS] % 10,
+                        diag->heap_free, diag->heap_free_min,
+                        diag->lvgl_mem_used, diag->lvgl_mem_total, diag->lvgl_mem_max_used, diag->lvgl_mem_frag_pct,
+                        diag->hid_event_drops, diag->log_overruns, diag->trace_drops, diag->cdc_drops, diag->sdlog_drops,
+                        diag->proxy_forwarded, diag->proxy_delay_avg_us, diag->proxy_delay_max_us);
+    }
+    lv_label_set_text(diag_label, text);
+}
+
+static void diag_timer_cb(lv_timer_t *timer)
+{
+    LV_UNUSED(timer);
+    diag_label_update();
+}
+
+static void diag_event_handler(lv_event_t* e)
+{
+    lv_event_code_t code = lv_event_get_code(e);
+
+    if (code == LV_EVENT_CLICKED) {
+        // Export the numbers shown on screen to the serial console
+        xlat_diag_print();
+    } else if ((code == LV_EVENT_DELETE) && diag_timer) {
+        lv_timer_del(diag_timer);
+        diag_timer = NULL;
+    }
+}
+
 void gfx_settings_create_page(lv_obj_t *previous_screen)
 {
     prev_screen = previous_screen;
@@ -120,10 +196,11 @@ void gfx_settings_create_page(lv_obj_t *previous_screen)
     lv_obj_set_size(tabview, lv_disp_get_hor_res(NULL), lv_disp_get_ver_res(NULL) - 30);
     lv_obj_align(tabview, LV_ALIGN_TOP_MID, 0, 0);
 
-    // Create 3 tabs
+    // Create 4 tabs
     lv_obj_t *tab_mode = lv_tabview_add_tab(tabview, "Mode");
     lv_obj_t *tab_detection = lv_tabview_add_tab(tabview, "Detection");
     lv_obj_t *tab_trigger = lv_tabview_add_tab(tabview, "Trigger");
+    lv_obj_t *tab_diag = lv_tabview_add_tab(tabview, "Diagnostics");
 
     // Mode Tab Content
     // Add explanatory text for Mode tab first
@@ -231,6 +308,47 @@ void gfx_settings_create_page(lv_obj_t *previous_screen)
     lv_obj_align_to(trigger_interval_dropdown, trigger_interval_label, LV_ALIGN_OUT_RIGHT_MID, 10, 0);
     lv_obj_add_event_cb(trigger_interval_dropdown, event_handler, LV_EVENT_VALUE_CHANGED, NULL);
 
+    // Quiet mode: no GUI activity while waiting for the report
+    lv_obj_t *quiet_mode_label = lv_label_create(tab_trigger);
+    lv_label_set_text(quiet_mode_label, "Quiet Mode:");
+    lv_obj_set_width(quiet_mode_label, LABEL_WIDTH);
+    lv_obj_align_to(quiet_mode_label, trigger_interval_label, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 30);
+
+    quiet_mode_dropdown = lv_dropdown_create(tab_trigger);
+    lv_dropdown_set_options(quiet_mode_dropdown, "Off\nOn");
+    lv_obj_set_width(quiet_mode_dropdown, DROPDOWN_WIDTH);
+    lv_obj_align_to(quiet_mode_dropdown, quiet_mode_label, LV_ALIGN_OUT_RIGHT_MID, 10, 0);
+    lv_obj_add_event_cb(quiet_mode_dropdown, event_handler, LV_EVENT_VALUE_CHANGED, NULL);
+
+    // Auto-stop: end the run once the average is known well enough
+    lv_obj_t *autostop_label = lv_label_create(tab_trigger);
+    lv_label_set_text(autostop_label, "Auto-stop:");
+    lv_obj_set_width(autostop_label, LABEL_WIDTH);
+    lv_obj_align_to(autostop_label, quiet_mode_label, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 30);
+
+    autostop_dropdown = lv_dropdown_create(tab_trigger);
+    lv_dropdown_set_options(autostop_dropdown, "Off\nAvg +/- 50us\nAvg +/- 20us\nAvg +/- 10us\nAvg +/- 5us");
+    lv_obj_set_width(autostop_dropdown, DROPDOWN_WIDTH);
+    lv_obj_align_to(autostop_dropdown, autostop_label, LV_ALIGN_OUT_RIGHT_MID, 10, 0);
+    lv_obj_add_event_cb(autostop_dropdown, event_handler, LV_EVENT_VALUE_CHANGED, NULL);
+
+    // Diagnostics: refreshed while the settings screen is open
+    diag_label = lv_label_create(tab_diag);
+    lv_obj_set_width(diag_label, lv_pct(100));
+    lv_obj_align(diag_label, LV_ALIGN_TOP_LEFT, 0, 0);
+    lv_obj_add_event_cb(diag_label, diag_event_handler, LV_EVENT_DELETE, NULL);
+
+    lv_obj_t *btn_export = lv_btn_create(tab_diag);
+    lv_obj_set_size(btn_export, GFX_BTN_WIDTH, GFX_BTN_HEIGHT);
+    lv_obj_add_event_cb(btn_export, diag_event_handler, LV_EVENT_CLICKED, NULL);
+    lv_obj_t *export_label = lv_label_create(btn_export);
+    lv_label_set_text(export_label, "EXPORT");
+    lv_obj_center(export_label);
+
+    diag_label_update();
+    lv_obj_align_to(btn_export, diag_label, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 10);
+    diag_timer = lv_timer_create(diag_timer_cb, DIAG_UPDATE_PERIOD_MS, NULL);
+
     // Back button
     lv_obj_t *btn_back = lv_btn_create(settings_screen);
     lv_obj_set_size(btn_back, GFX_BTN_WIDTH, GFX_BTN_HEIGHT);
@@ -247,7 +365,15 @@ void gfx_settings_create_page(lv_obj_t *previous_screen)
     lv_label_set_text(version_label, version_str);
     lv_obj_align(version_label, LV_ALIGN_BOTTOM_RIGHT, -10, -10);
 
-    // Set initial values
+    gfx_settings_refresh();
+}
+
+void gfx_settings_refresh(void)
+{
+    if (settings_screen == NULL) {
+        return;
+    }
+
     lv_dropdown_set_selected(mode_dropdown, xlat_mode_get());
     lv_dropdown_set_selected(edge_dropdown, hw_config_input_trigger_is_rising_edge());
     lv_dropdown_set_selected(trigger_dropdown, xlat_auto_trigger_level_is_high());
@@ -287,5 +413,21 @@ void gfx_settings_create_page(lv_obj_t *previous_screen)
     uint16_t current_output = xlat_auto_trigger_output_get();
     uint16_t output_index = (current_output == 6) ? 0 : 1; // D6 or D11
     lv_dropdown_set_selected(trigger_output_dropdown, output_index);
+
+    lv_dropdown_set_selected(quiet_mode_dropdown, xlat_quiet_mode_is_enabled());
+
+    // Set auto-stop, to the closest choice that is not narrower than the setting
+    struct xlat_autostop_config autostop;
+    xlat_autostop_config_get(&autostop);
+    uint16_t autostop_index = 0;
+    if (autostop.enabled) {
+        autostop_index = 1;
+        for (uint16_t i = 0; i < sizeof(autostop_half_widths_us) / sizeof(autostop_half_widths_us[0]); i++) {
+            if (autostop_half_widths_us[i] >= autostop.mean_half_width_us) {
+                autostop_index = i + 1;
+            }
+        }
+    }
+    lv_dropdown_set_selected(autostop_dropdown, autostop_index);
 }
 
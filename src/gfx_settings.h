@@ -21,5 +21,6 @@
 #include "lvgl/lvgl.h"
 
 void gfx_settings_create_page(lv_obj_t *previous_screen);
+void gfx_settings_refresh(void);    // show the current settings, when the page is open
 
 #endif //GFX_SETTINGS_H
@@ -19,6 +19,7 @@
 #include "main.h"
 #include "xlat.h"
 #include "hardware_config.h"
+#include "stm32746g_discovery_sdram.h"
 
 CRC_HandleTypeDef hcrc;
 DMA2D_HandleTypeDef hdma2d;
@@ -34,6 +35,7 @@ UART_HandleTypeDef huart6;
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 void PeriphCommonClock_Config(void);
+static void MPU_Config(void);
 static void MX_GPIO_Init(void);
 static void MX_CRC_Init(void);
 static void MX_DMA2D_Init(void);
@@ -60,6 +62,9 @@ int hw_init(void)
     /* Configure the system clock */
     SystemClock_Config();
 
+    /* Set the memory attributes before any cache is enabled */
+    MPU_Config();
+
     /* Enable I-Cache */
     SCB_EnableICache();
 
@@ -69,6 +74,10 @@ int hw_init(void)
     /* Configure the peripherals common clocks */
     PeriphCommonClock_Config();
 
+    /* SDRAM, remapped to 0x60000000: used by the sample store in both builds */
+    BSP_SDRAM_Init();
+    HAL_EnableFMCMemorySwapping();
+
     /* Initialize all configured peripherals */
     MX_GPIO_Init();
     MX_CRC_Init();
@@ -175,7 +184,7 @@ void PeriphCommonClock_Config(void)
 
     /** Initializes the peripherals clock
     */
-    PeriphClkInitStruct.PeriphClockSelection = RCC_PERIPHCLK_LTDC|RCC_PERIPHCLK_SAI2;
+    PeriphClkInitStruct.PeriphClockSelection = RCC_PERIPHCLK_LTDC|RCC_PERIPHCLK_SAI2|RCC_PERIPHCLK_CLK48;
     PeriphClkInitStruct.PLLSAI.PLLSAIN = 384;
     PeriphClkInitStruct.PLLSAI.PLLSAIR = 5;
     PeriphClkInitStruct.PLLSAI.PLLSAIQ = 2;
@@ -183,12 +192,89 @@ void PeriphCommonClock_Config(void)
     PeriphClkInitStruct.PLLSAIDivQ = 1;
     PeriphClkInitStruct.PLLSAIDivR = RCC_PLLSAIDIVR_8;
     PeriphClkInitStruct.Sai2ClockSelection = RCC_SAI2CLKSOURCE_PLLSAI;
+    PeriphClkInitStruct.Clk48ClockSelection = RCC_CLK48SOURCE_PLLSAIP; // 384 MHz / 8 = 48 MHz for OTG_FS
     if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInitStruct) != HAL_OK)
     {
         Error_Handler();
     }
 }
 
+/**
+  * @brief MPU Configuration, see hardware_config.h for the layout
+  * @retval None
+  */
+static void MPU_Config(void)
+{
+    extern uint32_t _sdma_bss;      // linker script
+    extern uint32_t _sstack_guard;  // linker script
+    MPU_Region_InitTypeDef MPU_InitStruct = {0};
+
+    HAL_MPU_Disable();
+
+    /* SDRAM: write-back, read and write allocate */
+    MPU_InitStruct.Enable = MPU_REGION_ENABLE;
+    MPU_InitStruct.Number = MPU_REGION_NUMBER0;
+    MPU_InitStruct.BaseAddress = HW_SDRAM_ADDRESS;
+    MPU_InitStruct.Size = MPU_REGION_SIZE_8MB;
+    MPU_InitStruct.SubRegionDisable = 0x00;
+    MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL1;
+    MPU_InitStruct.AccessPermission = MPU_REGION_FULL_ACCESS;
+    MPU_InitStruct.DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE;
+    MPU_InitStruct.IsShareable = MPU_ACCESS_NOT_SHAREABLE;
+    MPU_InitStruct.IsCacheable = MPU_ACCESS_CACHEABLE;
+    MPU_InitStruct.IsBufferable = MPU_ACCESS_BUFFERABLE;
+    HAL_MPU_ConfigRegion(&MPU_InitStruct);
+
+#if HW_SDRAM_WT_SIZE
+    /* Framebuffers: write-through, no write allocate */
+    MPU_InitStruct.Number = MPU_REGION_NUMBER1;
+    MPU_InitStruct.BaseAddress = HW_SDRAM_WT_ADDRESS;
+    MPU_InitStruct.Size = MPU_REGION_SIZE_1MB;
+    MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL0;
+    MPU_InitStruct.IsCacheable = MPU_ACCESS_CACHEABLE;
+    MPU_InitStruct.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+    HAL_MPU_ConfigRegion(&MPU_InitStruct);
+    _Static_assert(HW_SDRAM_WT_SIZE == (1024 * 1024), "MPU region size");
+#endif
+
+    /* End of SDRAM: normal memory, not cacheable */
+    MPU_InitStruct.Number = MPU_REGION_NUMBER4;
+    MPU_InitStruct.BaseAddress = HW_SDRAM_NC_ADDRESS;
+    MPU_InitStruct.Size = MPU_REGION_SIZE_256KB;
+    MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL1;
+    MPU_InitStruct.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+    MPU_InitStruct.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+    HAL_MPU_ConfigRegion(&MPU_InitStruct);
+    _Static_assert(HW_SDRAM_NC_SIZE == (256 * 1024), "MPU region size");
+
+    /* DMA buffers in SRAM2: normal memory, not cacheable */
+    MPU_InitStruct.Number = MPU_REGION_NUMBER2;
+    MPU_InitStruct.BaseAddress = (uint32_t)&_sdma_bss;
+    MPU_InitStruct.Size = MPU_REGION_SIZE_16KB;
+    MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL1;
+    MPU_InitStruct.IsShareable = MPU_ACCESS_SHAREABLE;
+    MPU_InitStruct.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+    MPU_InitStruct.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+    HAL_MPU_ConfigRegion(&MPU_InitStruct);
+
+    /* Main stack guard: the lowest 32 bytes the stack can grow into */
+    MPU_InitStruct.Number = MPU_REGION_NUMBER3;
+    MPU_InitStruct.BaseAddress = (uint32_t)&_sstack_guard;
+    MPU_InitStruct.Size = MPU_REGION_SIZE_32B;
+    MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL0;
+    MPU_InitStruct.AccessPermission = MPU_REGION_NO_ACCESS;
+    MPU_InitStruct.IsShareable = MPU_ACCESS_NOT_SHAREABLE;
+    MPU_InitStruct.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+    MPU_InitStruct.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+    HAL_MPU_ConfigRegion(&MPU_InitStruct);
+
+    /* Keep the default memory map everywhere else */
+    HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
+
+    /* Report stack overflows as MemManage faults instead of escalating to HardFault */
+    SCB->SHCSR |= SCB_SHCSR_MEMFAULTENA_Msk;
+}
+
 /**
   * @brief CRC Initialization Function
   * @param None
@@ -199,8 +285,9 @@ static void MX_CRC_Init(void)
     hcrc.Instance = CRC;
     hcrc.Init.DefaultPolynomialUse = DEFAULT_POLYNOMIAL_ENABLE;
     hcrc.Init.DefaultInitValueUse = DEFAULT_INIT_VALUE_ENABLE;
-    hcrc.Init.InputDataInversionMode = CRC_INPUTDATA_INVERSION_NONE;
-    hcrc.Init.OutputDataInversionMode = CRC_OUTPUTDATA_INVERSION_DISABLE;
+    // Reflected in and out: with a final XOR, the CRC-32 of zlib (capture blocks)
+    hcrc.Init.InputDataInversionMode = CRC_INPUTDATA_INVERSION_BYTE;
+    hcrc.Init.OutputDataInversionMode = CRC_OUTPUTDATA_INVERSION_ENABLE;
     hcrc.InputDataFormat = CRC_INPUTDATA_FORMAT_BYTES;
     if (HAL_CRC_Init(&hcrc) != HAL_OK)
     {
@@ -24,6 +24,33 @@
 #define XLAT_TIMx_CLK_ENABLE()              __HAL_RCC_TIM2_CLK_ENABLE()
 #define XLAT_TIMx_handle                   htim2
 
+/*
+ * Memory regions set up by the MPU in hw_init()
+ *
+ * - SDRAM: normal memory, write-back cached
+ * - The start of SDRAM (framebuffers): write-through, the LTDC and DMA2D always
+ *   see what the CPU wrote, no cache clean is needed. Not used by the headless build.
+ * - The end of SDRAM: not cached, e.g. for buffers a debug probe reads
+ * - HW_DMA_BUFFER: not cached at all, for DMA descriptors and buffers
+ * - A no-access guard below the main stack, an overflow raises a MemManage fault
+ *
+ * What goes where in SDRAM is decided by xlat_sdram.c, nothing else uses SDRAM addresses.
+ * MPU regions must be a power of two in size and aligned to their size.
+ */
+#define HW_SDRAM_ADDRESS                    0x60000000
+#define HW_SDRAM_SIZE                       (8 * 1024 * 1024)
+#define HW_SDRAM_WT_ADDRESS                 HW_SDRAM_ADDRESS
+#if defined(XLAT_HEADLESS) && XLAT_HEADLESS
+#define HW_SDRAM_WT_SIZE                    0
+#else
+#define HW_SDRAM_WT_SIZE                    (1024 * 1024)
+#endif
+#define HW_SDRAM_NC_SIZE                    (256 * 1024)
+#define HW_SDRAM_NC_ADDRESS                 (HW_SDRAM_ADDRESS + HW_SDRAM_SIZE - HW_SDRAM_NC_SIZE)
+
+// Non-cacheable section in SRAM2 (see .dma_bss in the linker script), not zeroed at startup
+#define HW_DMA_BUFFER                       __attribute__((section(".dma_bss"), aligned(32)))
+
 typedef enum input_bias {
     INPUT_BIAS_NOPULL = 0x00,   //GPIO_NOPULL
     INPUT_BIAS_PULLUP = 0x01,   //GPIO_PULLUP 
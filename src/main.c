@@ -21,18 +21,40 @@
 #include "xlat.h"
 #include "gfx_main.h"
 #include "usb_task.h"
+#include "usb_device.h"
+#include "xlat_trace.h"
+#include "xlat_log.h"
+#include "xlat_diag.h"
+#include "xlat_sdram.h"
+#include "xlat_store.h"
+#include "xlat_sdlog.h"
+#include "xlat_cmd.h"
+#include "stdio_glue.h"
+
+#ifdef XLAT_HEADLESS
+// No display stack: spend the RAM on deeper event queues instead
+#define HID_EVENT_QUEUE_LEN 64
+#define GFX_TASK_STACK_SIZE 2048
+#else
+#define HID_EVENT_QUEUE_LEN 16
+#define GFX_TASK_STACK_SIZE (4096 * 2)
+#endif
 
 osThreadId xlatTaskHandle;
 osThreadId lvglTaskHandle;
 osThreadId usbHostTaskHandle;
+osThreadId usbDeviceTaskHandle;
+osThreadId logTaskHandle;
+osThreadId sdlogTaskHandle;
+osThreadId cmdTaskHandle;
 
-osPoolDef(hidevt_pool, 16, hid_event_t);               // Define memory pool
+osPoolDef(hidevt_pool, HID_EVENT_QUEUE_LEN, hid_event_t);               // Define memory pool
 osPoolId  hidevt_pool;
 
 osPoolDef(gfxevt_pool, 16, gfx_event_t);               // Define memory pool
 osPoolId  gfxevt_pool;
 
-osMessageQDef(msgQUsbClick, 16, hid_event_t *);              // Define message queue
+osMessageQDef(msgQUsbClick, HID_EVENT_QUEUE_LEN, hid_event_t *);              // Define message queue
 osMessageQId  msgQUsbHidEvent;
 
 osMessageQDef(msgQGfxTask, 4, gfx_event_t *);              // Define message queue
@@ -48,7 +70,12 @@ SemaphoreHandle_t lvgl_mutex;
 int main(void)
 {
     hw_init();
+    vcp_init();
+    xlat_sdram_init();
     hw_debug_init();
+    xlat_trace_init();
+    xlat_diag_init();
+    xlat_store_init();
     gfx_init();
 
     lvgl_mutex = xSemaphoreCreateMutex();
@@ -57,14 +84,24 @@ int main(void)
     gfxevt_pool = osPoolCreate(osPool(gfxevt_pool)); // create memory pool
     msgQUsbHidEvent = osMessageCreate(osMessageQ(msgQUsbClick), NULL);  // create msg queue
     msgQGfxTask = osMessageCreate(osMessageQ(msgQGfxTask), NULL);    // create msg queue
+    xlat_cmd_init();
 
     /* Create the thread(s) */
     osThreadDef(xlatTask, xlat_task, osPriorityNormal, 0, 2048 / 4);
     xlatTaskHandle = osThreadCreate(osThread(xlatTask), NULL);
-    osThreadDef(lvglTask, gfx_task, osPriorityLow, 0, 4096 * 2 / 4);
+    osThreadDef(lvglTask, gfx_task, osPriorityLow, 0, GFX_TASK_STACK_SIZE / 4);
     lvglTaskHandle = osThreadCreate(osThread(lvglTask), NULL);
     osThreadDef(usbHostTask, usb_host_task, osPriorityHigh, 0, 2048 / 4);
     usbHostTaskHandle = osThreadCreate(osThread(usbHostTask), NULL);
+    osThreadDef(usbDeviceTask, usb_device_task, osPriorityBelowNormal, 0, 1024 / 4);
+    usbDeviceTaskHandle = osThreadCreate(osThread(usbDeviceTask), NULL);
+    osThreadDef(logTask, xlat_log_task, osPriorityIdle, 0, 1024 / 4);
+    logTaskHandle = osThreadCreate(osThread(logTask), NULL);
+    osThreadDef(sdlogTask, xlat_sdlog_task, osPriorityLow, 0, 1024 / 4);
+    sdlogTaskHandle = osThreadCreate(osThread(sdlogTask), NULL);
+    // Never delays the measurement or the GUI, replies are written with busy-waiting
+    osThreadDef(cmdTask, xlat_cmd_task, osPriorityIdle, 0, 1024 / 4);
+    cmdTaskHandle = osThreadCreate(osThread(cmdTask), NULL);
 
     /* Start scheduler */
     osKernelStart();
@@ -25,6 +25,7 @@
 void HAL_TIM_MspPostInit(TIM_HandleTypeDef *htim);
 
 extern UART_HandleTypeDef huart1;
+extern UART_HandleTypeDef huart6;
 extern TIM_HandleTypeDef htim2;
 
 extern const osPoolDef_t os_pool_def_hidevt_pool;
@@ -14,10 +14,35 @@
  * You should have received a copy of the GNU General Public License
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 #include "main.h"
 
+// Several tasks write to the serial ports, a whole write never interleaves with another
+static SemaphoreHandle_t uart_mutex = NULL;
+
+static int uart_write(UART_HandleTypeDef *huart, const char *ptr, int len)
+{
+    // Before the scheduler runs there is only one caller, and interrupts can't wait
+    bool lock = (uart_mutex != NULL) && (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) &&
+                !xPortIsInsideInterrupt();
+
+    if (lock) {
+        xSemaphoreTake(uart_mutex, portMAX_DELAY);
+    }
+    HAL_UART_Transmit(huart, (uint8_t *) ptr, len, 100);
+    if (lock) {
+        xSemaphoreGive(uart_mutex);
+    }
+    return len;
+}
+
+void vcp_init(void)
+{
+    uart_mutex = xSemaphoreCreateMutex();
+}
+
 // RTT will override these
 __weak int _write(int file, char *ptr, int len)
 {
@@ -36,16 +61,19 @@ __weak int _read(int file, char *ptr, int len)
 
 int vcp_write(char *ptr, int len)
 {
-    HAL_UART_Transmit(&huart1, (uint8_t *) ptr, len, 100);
-    return len;
+    return uart_write(&huart1, ptr, len);
 }
 
 // C-string must be null-terminated
 int vcp_writestr(char *ptr)
 {
-    size_t len = strlen(ptr);
-    HAL_UART_Transmit(&huart1, (uint8_t *) ptr, len, 100);
-    return (int)len;
+    return uart_write(&huart1, ptr, (int)strlen(ptr));
+}
+
+// Arduino header D0/D1
+int uart6_writestr(char *ptr)
+{
+    return uart_write(&huart6, ptr, (int)strlen(ptr));
 }
 
 // RTT will override these
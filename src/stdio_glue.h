@@ -19,8 +19,10 @@
 #ifndef STDIO_GLUE_H
 #define STDIO_GLUE_H
 
+void vcp_init(void);
 int vcp_write(char *ptr, int len);
 int vcp_writestr(char *ptr);
 int vcp_read(char *ptr, int len);
+int uart6_writestr(char *ptr);
 
 #endif //STDIO_GLUE_H
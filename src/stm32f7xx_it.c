@@ -19,6 +19,11 @@
 #include "main.h"
 #include "stm32f7xx_it.h"
 #include "xlat.h"
+#include "xlat_trace.h"
+#include "xlat_diag.h"
+#ifndef XLAT_HEADLESS
+#include "touchpad/touchpad.h"
+#endif
 
 #include <tusb.h>
 
@@ -38,6 +43,7 @@ extern SAI_HandleTypeDef haudio_out_sai;
 extern SAI_HandleTypeDef haudio_in_sai;
 /* SDRAM handler declared in "stm32746g_discovery_sdram.c" file */
 extern SDRAM_HandleTypeDef sdramHandle;
+extern SD_HandleTypeDef uSdHandle;
 
 /******************************************************************************/
 /*           Cortex-M7 Processor Interruption and Exception Handlers          */
@@ -116,6 +122,7 @@ void DebugMon_Handler(void)
 
 void EXTI1_IRQHandler(void)
 {
+    gpio_irq_timestamp = xlat_counter_1mhz_get();
     HAL_GPIO_EXTI_IRQHandler(ARDUINO_SCK_D13_Pin);
 }
 
@@ -126,6 +133,7 @@ void EXTI1_IRQHandler(void)
   */
 void EXTI2_IRQHandler(void)
 {
+   gpio_irq_timestamp = xlat_counter_1mhz_get();
    HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_2);
 }
 
@@ -134,14 +142,36 @@ void EXTI2_IRQHandler(void)
   */
 void EXTI9_5_IRQHandler(void)
 {
+    gpio_irq_timestamp = xlat_counter_1mhz_get();
     HAL_GPIO_EXTI_IRQHandler(ARDUINO_D2_Pin);
 }
 
-void EXTI15_10_IRQHandler(void)
+/**
+  * @brief This function handles EXTI line[15:10] interrupts: the measurement input (D12),
+  *        and the touch controller INT line (LCD_INT) in the GUI build.
+  */
+XLAT_ITCM_FUNC void EXTI15_10_IRQHandler(void)
 {
-    HAL_GPIO_WritePin(ARDUINO_D5_GPIO_Port, ARDUINO_D5_Pin, 1);
-    HAL_GPIO_EXTI_IRQHandler(ARDUINO_D12_Pin);
-    HAL_GPIO_WritePin(ARDUINO_D5_GPIO_Port, ARDUINO_D5_Pin, 0);
+    // The edge timestamp before anything else, the instrumentation must not add to the latency
+    gpio_irq_timestamp = xlat_counter_1mhz_get();
+    XLAT_DIAG_ISR_ENTER();
+
+    // Measurement input first, the touch interrupt must not delay it or show up in the trace
+    if (__HAL_GPIO_EXTI_GET_IT(ARDUINO_D12_Pin)) {
+        XLAT_TRACE(XLAT_TRACE_ID_EXTI, 0, 0);
+        HAL_GPIO_WritePin(ARDUINO_D5_GPIO_Port, ARDUINO_D5_Pin, 1);
+        HAL_GPIO_EXTI_IRQHandler(ARDUINO_D12_Pin);
+        HAL_GPIO_WritePin(ARDUINO_D5_GPIO_Port, ARDUINO_D5_Pin, 0);
+    }
+
+#ifndef XLAT_HEADLESS
+    if (__HAL_GPIO_EXTI_GET_IT(LCD_INT_Pin)) {
+        __HAL_GPIO_EXTI_CLEAR_IT(LCD_INT_Pin);
+        touchpad_irq_handler();
+    }
+#endif
+
+    XLAT_DIAG_ISR_EXIT(XLAT_DIAG_ISR_EXTI);
 }
 
 /**
@@ -164,6 +194,30 @@ void AUDIO_OUT_SAIx_DMAx_IRQHandler(void)
   HAL_DMA_IRQHandler(haudio_out_sai.hdmatx);
 }
 
+/**
+  * @brief This function handles the SDMMC1 interrupt (microSD card, see xlat_blockdev_sd.c).
+  */
+void SDMMC1_IRQHandler(void)
+{
+    HAL_SD_IRQHandler(&uSdHandle);
+}
+
+/**
+  * @brief This function handles DMA2 Stream 3 interrupt request (SDMMC1 Rx).
+  */
+void DMA2_Stream3_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(uSdHandle.hdmarx);
+}
+
+/**
+  * @brief This function handles DMA2 Stream 6 interrupt request (SDMMC1 Tx).
+  */
+void DMA2_Stream6_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(uSdHandle.hdmatx);
+}
+
 /**
   * @brief This function handles DMA2D global interrupt.
   */
@@ -189,11 +243,27 @@ void LTDC_IRQHandler(void)
     HAL_LTDC_IRQHandler(&hltdc);
 }
 
+/**
+  * @brief This function handles USART1 global interrupt (serial console receive).
+  */
+void USART1_IRQHandler(void)
+{
+    HAL_UART_IRQHandler(&huart1);
+}
+
+/**
+  * @brief This function handles USART6 global interrupt (command port on the Arduino header).
+  */
+void USART6_IRQHandler(void)
+{
+    HAL_UART_IRQHandler(&huart6);
+}
+
 /**
   * @brief Forward USB interrupt events to TinyUSB IRQ Handler
   */
 void OTG_FS_IRQHandler(void) {
-  //tusb_int_handler(0, true);
+    tusb_int_handler(0, true);
 }
 
 /**
@@ -201,11 +271,15 @@ void OTG_FS_IRQHandler(void) {
  * Despite being called USB2_OTG
  * OTG_HS is marked as RHPort1 by TinyUSB to be consistent across stm32 port
  */
-void OTG_HS_IRQHandler(void) {
+XLAT_ITCM_FUNC void OTG_HS_IRQHandler(void) {
+    // First, the instrumentation below must not add to the latency
+    usb_hid_rx_timestamp = xlat_counter_1mhz_get();
+    XLAT_TRACE(XLAT_TRACE_ID_OTG_IRQ, 0, 0);
+    XLAT_DIAG_ISR_ENTER();
     HAL_GPIO_WritePin(ARDUINO_D3_GPIO_Port, ARDUINO_D3_Pin, GPIO_PIN_SET);
 
-    usb_hid_rx_timestamp = xlat_counter_1mhz_get(); // not as early as was done in the STM32 USB Host library...
     tusb_int_handler(1, true);
 
     HAL_GPIO_WritePin(ARDUINO_D3_GPIO_Port, ARDUINO_D3_Pin, GPIO_PIN_RESET);
+    XLAT_DIAG_ISR_EXIT(XLAT_DIAG_ISR_OTG_HS);
 }
@@ -18,9 +18,11 @@
 #include <main.h>
 #include <stm32f7xx_hal_gpio.h>
 #include <xlat.h>
+#include <xlat_trace.h>
 
 #include "tusb.h"
 #include "tusb_config.h"
+#include "usb_proxy.h"
 
 #define MAX_REPORT  4
 
@@ -51,6 +53,9 @@ void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t instance, uint8_t const *desc_re
   // Parse the HID descriptor using xlat
   xlat_parse_hid_descriptor((uint8_t*)desc_report, desc_len, itf_protocol);
 
+  // Re-expose the interface to the PC on the device port
+  usb_proxy_mount(dev_addr, instance, desc_report, desc_len);
+
   // By default host stack will use activate boot protocol on supported interface.
   // Therefore for this simple example, we only need to parse generic report descriptor (with built-in parser)
   if (itf_protocol == HID_ITF_PROTOCOL_NONE) {
@@ -76,17 +81,23 @@ void tuh_hid_umount_cb(uint8_t dev_addr, uint8_t instance) {
     printf("\033[0m");
   }
   xlat_clear_device_info();
+  usb_proxy_umount(dev_addr, instance);
 }
 
 
 // Invoked when received report from device via interrupt endpoint
-void tuh_hid_report_received_cb(uint8_t dev_addr, uint8_t instance, uint8_t const *report, uint16_t len) {
+XLAT_ITCM_FUNC void tuh_hid_report_received_cb(uint8_t dev_addr, uint8_t instance, uint8_t const *report, uint16_t len) {
+  XLAT_TRACE(XLAT_TRACE_ID_HID_REPORT, dev_addr, len);
   HAL_GPIO_WritePin(ARDUINO_D4_GPIO_Port, ARDUINO_D4_Pin, GPIO_PIN_SET);
 
   uint8_t const itf_protocol = tuh_hid_interface_protocol(dev_addr, instance);
 
   // usb_hid_rx_timestamp is set in the OTG_HS_IRQHandler (earliest possible)
-  xlat_usb_event_callback(usb_hid_rx_timestamp, report, len, itf_protocol); // Call to XLAT module
+  uint32_t rx_timestamp = usb_hid_rx_timestamp;
+  xlat_usb_event_callback(rx_timestamp, dev_addr, instance, report, len, itf_protocol); // Call to XLAT module
+
+  // Copy the report for the pass-through while the buffer is still ours
+  usb_proxy_report(dev_addr, instance, report, len, rx_timestamp);
 
   // continue to request to receive report (new IN token on interrupt endpoint)
   // Skip re-arm if device already unmounted — avoids race where a stale xfer-complete
@@ -95,5 +106,8 @@ void tuh_hid_report_received_cb(uint8_t dev_addr, uint8_t instance, uint8_t cons
     printf("Error: cannot request to receive report\n");
   }
 
+  // Forward to the PC last, the measurement never waits for the pass-through
+  usb_proxy_send();
+
   HAL_GPIO_WritePin(ARDUINO_D4_GPIO_Port, ARDUINO_D4_Pin, GPIO_PIN_RESET);
 }
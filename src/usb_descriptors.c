@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Descriptors of the USB device on the OTG_FS port, see usb_device.c and usb_msc.c
+
+#include <string.h>
+
+#include "stm32f7xx_hal.h"
+#include "tusb.h"
+
+#include "usb_proxy.h"
+
+#define USB_VID     0xCafe  // TinyUSB test VID
+#define USB_PID     0x4059  // CDC + MSC + HID composite
+#define USB_BCD     0x0200
+
+//--------------------------------------------------------------------+
+// Device Descriptors
+//--------------------------------------------------------------------+
+static tusb_desc_device_t const desc_device = {
+    .bLength            = sizeof(tusb_desc_device_t),
+    .bDescriptorType    = TUSB_DESC_DEVICE,
+    .bcdUSB             = USB_BCD,
+
+    // Use Interface Association Descriptor (IAD) for CDC, composite with MSC and HID
+    .bDeviceClass       = TUSB_CLASS_MISC,
+    .bDeviceSubClass    = MISC_SUBCLASS_COMMON,
+    .bDeviceProtocol    = MISC_PROTOCOL_IAD,
+    .bMaxPacketSize0    = CFG_TUD_ENDPOINT0_SIZE,
+
+    .idVendor           = USB_VID,
+    .idProduct          = USB_PID,
+    .bcdDevice          = 0x0100,
+
+    .iManufacturer      = 0x01,
+    .iProduct           = 0x02,
+    .iSerialNumber      = 0x03,
+
+    .bNumConfigurations = 0x01
+};
+
+// Invoked when received GET DEVICE DESCRIPTOR
+uint8_t const * tud_descriptor_device_cb(void)
+{
+    return (uint8_t const *) &desc_device;
+}
+
+//--------------------------------------------------------------------+
+// Configuration Descriptor
+//--------------------------------------------------------------------+
+enum {
+    ITF_NUM_CDC = 0,
+    ITF_NUM_CDC_DATA,
+    ITF_NUM_MSC,
+    ITF_NUM_HID,        // first proxied HID interface, there are usb_proxy_itf_count_get()
+};
+
+#define EPNUM_CDC_NOTIF     0x81
+#define EPNUM_CDC_OUT       0x02
+#define EPNUM_CDC_IN        0x82
+#define EPNUM_MSC_OUT       0x03
+#define EPNUM_MSC_IN        0x83
+#define EPNUM_HID_IN(n)     (0x84 + (n))
+
+#define CONFIG_BASE_LEN     (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_MSC_DESC_LEN)
+
+// The HID interfaces mirror the device under test, the descriptor is built at enumeration
+static uint8_t desc_fs_configuration[CONFIG_BASE_LEN + USB_PROXY_MAX_ITF * TUD_HID_DESC_LEN];
+
+// Invoked when received GET CONFIGURATION DESCRIPTOR
+uint8_t const * tud_descriptor_configuration_cb(uint8_t index)
+{
+    (void) index; // for multiple configurations
+
+    uint8_t hid_count = usb_proxy_itf_count_get();
+    uint16_t total_len = CONFIG_BASE_LEN + hid_count * TUD_HID_DESC_LEN;
+
+    uint8_t const desc_base[] = {
+        // Config number, interface count, string index, total length, attribute, power in mA
+        TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_HID + hid_count, 0, total_len, 0x00, 100),
+
+        // Interface number, string index, EP notification address and size, EP data address (out, in) and size
+        TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, 4, EPNUM_CDC_NOTIF, 8, EPNUM_CDC_OUT, EPNUM_CDC_IN, 64),
+
+        // Interface number, string index, EP Out & EP In address, EP size
+        TUD_MSC_DESCRIPTOR(ITF_NUM_MSC, 5, EPNUM_MSC_OUT, EPNUM_MSC_IN, 64),
+    };
+    memcpy(desc_fs_configuration, desc_base, sizeof(desc_base));
+
+    uint8_t *p = desc_fs_configuration + sizeof(desc_base);
+    for (uint8_t i = 0; i < hid_count; i++) {
+        // Interface number, string index, protocol, report descriptor len, EP In address, size & polling interval
+        uint8_t const desc_hid[] = {
+            TUD_HID_DESCRIPTOR(ITF_NUM_HID + i, 0, HID_ITF_PROTOCOL_NONE, usb_proxy_desc_len_get(i),
+                               EPNUM_HID_IN(i), CFG_TUD_HID_EP_BUFSIZE, 1),
+        };
+        memcpy(p, desc_hid, sizeof(desc_hid));
+        p += sizeof(desc_hid);
+    }
+
+    return desc_fs_configuration;
+}
+
+//--------------------------------------------------------------------+
+// String Descriptors
+//--------------------------------------------------------------------+
+enum {
+    STRID_LANGID = 0,
+    STRID_MANUFACTURER,
+    STRID_PRODUCT,
+    STRID_SERIAL,
+    STRID_CDC,
+    STRID_MSC,
+};
+
+static char const * const string_desc_arr[] = {
+    [STRID_MANUFACTURER] = "Finalmouse",
+    [STRID_PRODUCT] = "XLAT",
+    [STRID_SERIAL] = NULL,      // from the MCU unique ID
+    [STRID_CDC] = "XLAT results",
+    [STRID_MSC] = "XLAT runs",
+};
+
+static uint16_t desc_str[32 + 1];
+
+// Invoked when received GET STRING DESCRIPTOR request
+uint16_t const * tud_descriptor_string_cb(uint8_t index, uint16_t langid)
+{
+    (void) langid;
+    size_t chr_count;
+
+    if (index == STRID_LANGID) {
+        desc_str[1] = 0x0409; // English
+        chr_count = 1;
+    } else if (index == STRID_SERIAL) {
+        // 96-bit unique ID as hex
+        static const char hex[] = "0123456789ABCDEF";
+        const uint8_t *uid = (const uint8_t *) UID_BASE;
+        for (size_t i = 0; i < 12; i++) {
+            desc_str[1 + 2 * i] = hex[uid[i] >> 4];
+            desc_str[2 + 2 * i] = hex[uid[i] & 0xf];
+        }
+        chr_count = 24;
+    } else {
+        if (index >= sizeof(string_desc_arr) / sizeof(string_desc_arr[0])) {
+            return NULL;
+        }
+        const char *str = string_desc_arr[index];
+        chr_count = strlen(str);
+        if (chr_count > 32) {
+            chr_count = 32;
+        }
+        // ASCII to UTF-16
+        for (size_t i = 0; i < chr_count; i++) {
+            desc_str[1 + i] = str[i];
+        }
+    }
+
+    // first byte is length (including header), second byte is string type
+    desc_str[0] = (uint16_t) ((TUSB_DESC_STRING << 8) | (2 * chr_count + 2));
+    return desc_str;
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * USB device on the OTG_FS connector (CN13 on the discovery board).
+ *
+ * Every measurement is streamed as a CSV line over a CDC-ACM port, with the raw 1 MHz
+ * timestamps of the input edge and the HID report. The xlat task only appends the sample
+ * to the store (xlat_store.c); this task reads it back from there, formats the line and
+ * writes it to the TinyUSB FIFO, so the measurement path never waits for the host. When
+ * the host falls so far behind that samples are overwritten in the store, they are counted
+ * as dropped.
+ *
+ * The same device also exposes the completed runs as a read-only disk, see usb_msc.c,
+ * and passes the HID interfaces of the device under test through, see usb_proxy.c.
+ */
+
+#include <stdio.h>
+
+#include "stm32f7xx_hal.h"
+#include "cmsis_os.h"
+#include "tusb.h"
+
+#include "usb_device.h"
+#include "usb_proxy.h"
+#include "xlat.h"
+#include "xlat_store.h"
+
+// Below the measurement input and the OTG_HS host
+#define USB_DEVICE_IRQ_PRIORITY     7
+#define USB_CDC_LINE_LEN            64
+// How often the HID pass-through checks for a change of interfaces
+#define USB_DEVICE_POLL_MS          10
+
+static volatile uint32_t cdc_drops = 0;
+
+// Store index of the next sample to stream
+static uint32_t cdc_next = 0;
+
+static void board_fs_init(void)
+{
+    // PA10/PA11/PA12 are set to the OTG_FS alternate function by hw_init(), the 48 MHz clock
+    // comes from PLLSAI (PeriphCommonClock_Config())
+    __HAL_RCC_USB_OTG_FS_CLK_ENABLE();
+    HAL_NVIC_SetPriority(OTG_FS_IRQn, USB_DEVICE_IRQ_PRIORITY, 0);
+
+    // No VBUS sense
+    USB_OTG_FS->GCCFG &= ~USB_OTG_GCCFG_VBDEN;
+
+    // B-peripheral session valid override enable
+    USB_OTG_FS->GOTGCTL |= USB_OTG_GOTGCTL_BVALOEN;
+    USB_OTG_FS->GOTGCTL |= USB_OTG_GOTGCTL_BVALOVAL;
+}
+
+// Streams the samples added to the store since the last call, as long as the FIFO has room
+static void usb_cdc_samples_write(void)
+{
+    uint32_t next = xlat_store_next_get();
+
+    // Nobody listening: start from the newest sample once the port is opened
+    if (!tud_cdc_connected()) {
+        cdc_next = next;
+        return;
+    }
+
+    bool written = false;
+    while (cdc_next != next) {
+        struct xlat_sample s;
+        if (!xlat_store_sample_get(cdc_next, &s)) {
+            cdc_drops++;
+            cdc_next++;
+            continue;
+        }
+
+        char line[USB_CDC_LINE_LEN];
+        uint32_t count = cdc_next - xlat_store_run_first_get(cdc_next) + 1;
+        int len = snprintf(line, sizeof(line), "%lu;%lu;%lu;%lu;%u\n", count, s.timestamp_us,
+                           s.timestamp_us + s.latency_us, (uint32_t)s.latency_us, (unsigned)s.quiet);
+
+        // The rest goes out once the host has read some of the FIFO
+        if (tud_cdc_write_available() < (uint32_t)len) {
+            break;
+        }
+        tud_cdc_write(line, (uint32_t)len);
+        written = true;
+        cdc_next++;
+    }
+
+    if (written) {
+        tud_cdc_write_flush();
+    }
+}
+
+// USB device task
+// This top level thread processes all device events and invokes the class callbacks
+void usb_device_task(void const *param)
+{
+    (void) param;
+
+    tusb_rhport_init_t dev_init = {
+        .role = TUSB_ROLE_DEVICE,
+        .speed = TUSB_SPEED_FULL
+    };
+
+    // The host stack initializes the shared parts of TinyUSB first
+    while (!xlat_initialized || !tuh_inited()) {
+        osDelay(10);
+    }
+
+    board_fs_init();
+
+    if (!tusb_init(BOARD_TUD_RHPORT, &dev_init)) {
+        printf("Failed to init USB Device Stack\n");
+        vTaskSuspend(NULL);
+    }
+
+    // RTOS forever loop
+    while (1) {
+        // put this thread to waiting state until there is new events, or the poll interval
+        tud_task_ext(USB_DEVICE_POLL_MS, false);
+        usb_cdc_samples_write();
+        usb_proxy_task();
+    }
+}
+
+bool usb_cdc_connected(void)
+{
+    return tud_cdc_connected();
+}
+
+uint32_t usb_cdc_drop_count_get(void)
+{
+    return cdc_drops;
+}
+
+//--------------------------------------------------------------------+
+// TinyUSB Callbacks
+//--------------------------------------------------------------------+
+
+// Invoked when the terminal opens or closes the port
+void tud_cdc_line_state_cb(uint8_t itf, bool dtr, bool rts)
+{
+    (void) itf;
+    (void) rts;
+
+    if (dtr) {
+        static const char header[] = "count;gpio_us;usb_us;latency_us;quiet\n";
+        tud_cdc_write(header, sizeof(header) - 1);
+        tud_cdc_write_flush();
+    }
+}
+
+// Nothing is read from the port, drop whatever the host sends
+void tud_cdc_rx_cb(uint8_t itf)
+{
+    (void) itf;
+    tud_cdc_read_flush();
+}
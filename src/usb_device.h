@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// TinyUSB device stack on the OTG_FS port (rhport 0), next to the host stack on OTG_HS
+void usb_device_task(void const *param);
+
+// CDC-ACM result stream, see usb_device.c
+bool usb_cdc_connected(void);
+uint32_t usb_cdc_drop_count_get(void);
@@ -0,0 +1,416 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * USB mass-storage interface of the OTG_FS device: the completed runs as read-only files.
+ *
+ * Nothing is stored as a disk image. The FAT16 volume is described by a small file table
+ * that is rebuilt when the list of runs changes, and every sector is synthesized when the
+ * host reads it: boot sector, FATs and root directory from the table, file contents from
+ * the sample store. CSV lines have a fixed width so a file offset maps straight to a sample.
+ *
+ * When a run completes (or an old one is dropped), the next TEST UNIT READY reports
+ * "medium may have changed" and the host re-reads the volume.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "tusb.h"
+
+#include "xlat_store.h"
+#include "xlat_config.h"
+#include "xlat_sdram.h"
+
+#define SECTOR_SIZE             512
+#define SECTORS_PER_CLUSTER     8
+#define CLUSTER_SIZE            (SECTORS_PER_CLUSTER * SECTOR_SIZE)
+#define VOLUME_SECTORS          65536   // 32 MB, more than a full sample store as CSV
+#define RESERVED_SECTORS        1
+#define NUM_FATS                2
+#define FAT_SECTORS             32
+#define ROOT_ENTRIES            512
+#define ROOT_SECTORS            (ROOT_ENTRIES * 32 / SECTOR_SIZE)
+
+#define FAT_START               RESERVED_SECTORS
+#define ROOT_START              (FAT_START + NUM_FATS * FAT_SECTORS)
+#define DATA_START              (ROOT_START + ROOT_SECTORS)
+#define CLUSTER_COUNT           ((VOLUME_SECTORS - DATA_START) / SECTORS_PER_CLUSTER)
+
+// Between 4085 and 65524 clusters is what makes the volume FAT16
+_Static_assert((CLUSTER_COUNT >= 4085) && (CLUSTER_COUNT <= 65524), "not a FAT16 volume");
+_Static_assert((CLUSTER_COUNT + 2) * 2 <= FAT_SECTORS * SECTOR_SIZE, "FAT too small");
+
+#define CSV_LINE_LEN            32
+#define MAX_FILES               (XLAT_STORE_MAX_RUNS + 1)
+
+// A full sample store as CSV, with a header and a partial cluster per file
+_Static_assert((XLAT_SDRAM_SAMPLE_STORE_SIZE / sizeof(struct xlat_sample)) * CSV_LINE_LEN +
+               MAX_FILES * (CLUSTER_SIZE + CSV_LINE_LEN) <= CLUSTER_COUNT * CLUSTER_SIZE, "volume too small");
+
+// FAT timestamps of every entry: 2025-01-01 00:00
+#define FAT_DATE                (((2025 - 1980) << 9) | (1 << 5) | 1)
+#define FAT_TIME                0
+
+struct msc_file {
+    char name[11];              // 8.3, space padded
+    uint32_t size;
+    uint16_t cluster;           // first cluster, files are contiguous
+    uint16_t clusters;
+    bool summary;               // RUNS.TXT, otherwise the CSV of run
+    struct xlat_run run;
+};
+
+static struct msc_file files[MAX_FILES];
+static uint8_t file_count = 0;
+static char summary_text[128 + XLAT_STORE_MAX_RUNS * 72];     // rows are up to 68 characters
+static uint32_t volume_generation;
+static bool volume_built = false;
+static bool ejected = false;
+
+static uint8_t sector_buf[SECTOR_SIZE];
+
+static inline void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+static inline void put32(uint8_t *p, uint32_t v)
+{
+    put16(p, v & 0xffff);
+    put16(p + 2, v >> 16);
+}
+
+static const char *mode_name_get(uint8_t mode)
+{
+    switch (mode) {
+        case XLAT_MODE_MOUSE_CLICK:
+            return "click";
+        case XLAT_MODE_MOUSE_MOTION:
+            return "motion";
+        case XLAT_MODE_KEYBOARD:
+            return "key";
+        default:
+            return "unknown";
+    }
+}
+
+static void file_add(const char *name, uint32_t size, bool summary, const struct xlat_run *run)
+{
+    uint16_t next = file_count ? (files[file_count - 1].cluster + files[file_count - 1].clusters) : 2;
+    uint16_t clusters = (size + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+
+    if ((file_count == MAX_FILES) || ((next - 2 + clusters) > CLUSTER_COUNT)) {
+        return;
+    }
+
+    struct msc_file *f = &files[file_count++];
+    memcpy(f->name, name, sizeof(f->name));
+    f->size = size;
+    f->cluster = next;
+    f->clusters = clusters;
+    f->summary = summary;
+    if (run) {
+        f->run = *run;
+    }
+}
+
+static void volume_build(void)
+{
+    struct xlat_run runs[XLAT_STORE_MAX_RUNS];
+
+    // Read the generation first: a change while copying the runs triggers another rebuild
+    volume_generation = xlat_store_generation_get();
+    uint8_t n = xlat_store_runs_get(runs, XLAT_STORE_MAX_RUNS);
+
+    uint32_t len = snprintf(summary_text, sizeof(summary_text),
+                            "run  mode      count   avg_us stdev_us   min_us   max_us\r\n");
+    for (uint8_t i = 0; i < n; i++) {
+        len += snprintf(summary_text + len, sizeof(summary_text) - len, "%4lu %-6s %8lu %8lu %8lu %8lu %8lu\r\n",
+                        runs[i].number % 10000, mode_name_get(runs[i].mode), runs[i].count,
+                        runs[i].avg_us, runs[i].stdev_us, runs[i].min_us, runs[i].max_us);
+        // snprintf returns what it would have written: a cut row ends the file
+        if (len >= sizeof(summary_text)) {
+            len = sizeof(summary_text) - 1;
+            break;
+        }
+    }
+
+    file_count = 0;
+    file_add("RUNS    TXT", len, true, NULL);
+    for (uint8_t i = 0; i < n; i++) {
+        char name[12];
+        snprintf(name, sizeof(name), "RUN%04lu CSV", runs[i].number % 10000);
+        // header line + one line per sample
+        file_add(name, (runs[i].count + 1) * CSV_LINE_LEN, false, &runs[i]);
+    }
+
+    volume_built = true;
+}
+
+static struct msc_file *file_find(uint32_t cluster)
+{
+    for (uint8_t i = 0; i < file_count; i++) {
+        if ((cluster >= files[i].cluster) && (cluster < (uint32_t)(files[i].cluster + files[i].clusters))) {
+            return &files[i];
+        }
+    }
+    return NULL;
+}
+
+static void boot_sector_read(uint8_t *buf)
+{
+    static const uint8_t jump[] = {0xEB, 0x3C, 0x90};
+
+    memcpy(buf, jump, sizeof(jump));
+    memcpy(buf + 3, "MSDOS5.0", 8);
+    put16(buf + 11, SECTOR_SIZE);
+    buf[13] = SECTORS_PER_CLUSTER;
+    put16(buf + 14, RESERVED_SECTORS);
+    buf[16] = NUM_FATS;
+    put16(buf + 17, ROOT_ENTRIES);
+    put16(buf + 19, 0);                 // more than 65535 sectors, see below
+    buf[21] = 0xF8;                     // fixed disk
+    put16(buf + 22, FAT_SECTORS);
+    put16(buf + 24, 63);                // sectors per track
+    put16(buf + 26, 255);               // heads
+    put32(buf + 28, 0);                 // hidden sectors
+    put32(buf + 32, VOLUME_SECTORS);
+    buf[36] = 0x80;                     // drive number
+    buf[38] = 0x29;                     // extended boot signature
+    put32(buf + 39, 0x584C4154 ^ volume_generation);   // volume ID, differs for every rebuild
+    memcpy(buf + 43, "XLAT       ", 11);
+    memcpy(buf + 54, "FAT16   ", 8);
+    buf[510] = 0x55;
+    buf[511] = 0xAA;
+}
+
+static void fat_sector_read(uint32_t sector, uint8_t *buf)
+{
+    for (uint32_t i = 0; i < (SECTOR_SIZE / 2); i++) {
+        uint32_t cluster = sector * (SECTOR_SIZE / 2) + i;
+        uint16_t entry = 0;
+
+        if (cluster == 0) {
+            entry = 0xFFF8;             // media descriptor
+        } else if (cluster == 1) {
+            entry = 0xFFFF;
+        } else {
+            struct msc_file *f = file_find(cluster);
+            if (f) {
+                entry = (cluster == (uint32_t)(f->cluster + f->clusters - 1)) ? 0xFFFF : (cluster + 1);
+            }
+        }
+        put16(buf + 2 * i, entry);
+    }
+}
+
+static void dir_entry_write(uint8_t *e, const char *name, uint8_t attr, uint16_t cluster, uint32_t size)
+{
+    memcpy(e, name, 11);
+    e[11] = attr;
+    put16(e + 14, FAT_TIME);            // creation
+    put16(e + 16, FAT_DATE);
+    put16(e + 18, FAT_DATE);            // last access
+    put16(e + 22, FAT_TIME);            // last write
+    put16(e + 24, FAT_DATE);
+    put16(e + 26, cluster);
+    put32(e + 28, size);
+}
+
+static void root_sector_read(uint32_t sector, uint8_t *buf)
+{
+    for (uint32_t i = 0; i < (SECTOR_SIZE / 32); i++) {
+        uint32_t entry = sector * (SECTOR_SIZE / 32) + i;
+
+        if (entry == 0) {
+            dir_entry_write(buf + 32 * i, "XLAT       ", 0x08, 0, 0);  // volume label
+        } else if (entry <= file_count) {
+            struct msc_file *f = &files[entry - 1];
+            dir_entry_write(buf + 32 * i, f->name, 0x01, f->cluster, f->size);   // read-only
+        }
+    }
+}
+
+static void csv_sector_read(const struct msc_file *f, uint32_t offset, uint8_t *buf)
+{
+    char line[CSV_LINE_LEN + 1];
+
+    for (uint32_t pos = 0; (pos < SECTOR_SIZE) && ((offset + pos) < f->size); pos += CSV_LINE_LEN) {
+        uint32_t n = (offset + pos) / CSV_LINE_LEN;
+
+        if (n == 0) {
+            memcpy(line, "sample;time_us;latency_us;quiet\n", CSV_LINE_LEN);
+        } else {
+            struct xlat_sample s = {0};
+            xlat_store_sample_get(f->run.first + n - 1, &s);    // zeros once overwritten
+            uint32_t latency = (s.latency_us > 99999999) ? 99999999 : s.latency_us;
+            snprintf(line, sizeof(line), "%09lu;%010lu;%08lu;%u\n", n, s.timestamp_us, latency, s.quiet);
+        }
+        memcpy(buf + pos, line, CSV_LINE_LEN);
+    }
+}
+
+static void data_sector_read(uint32_t sector, uint8_t *buf)
+{
+    uint32_t cluster = sector / SECTORS_PER_CLUSTER + 2;
+    struct msc_file *f = file_find(cluster);
+
+    if (!f) {
+        return;
+    }
+
+    uint32_t offset = (cluster - f->cluster) * CLUSTER_SIZE + (sector % SECTORS_PER_CLUSTER) * SECTOR_SIZE;
+    if (offset >= f->size) {
+        return;
+    }
+
+    if (f->summary) {
+        uint32_t len = f->size - offset;
+        memcpy(buf, summary_text + offset, (len < SECTOR_SIZE) ? len : SECTOR_SIZE);
+    } else {
+        csv_sector_read(f, offset, buf);
+    }
+}
+
+static void sector_read(uint32_t lba, uint8_t *buf)
+{
+    memset(buf, 0, SECTOR_SIZE);
+
+    if (lba == 0) {
+        boot_sector_read(buf);
+    } else if (lba < ROOT_START) {
+        fat_sector_read((lba - FAT_START) % FAT_SECTORS, buf);
+    } else if (lba < DATA_START) {
+        root_sector_read(lba - ROOT_START, buf);
+    } else {
+        data_sector_read(lba - DATA_START, buf);
+    }
+}
+
+//--------------------------------------------------------------------+
+// TinyUSB Callbacks
+//--------------------------------------------------------------------+
+
+// Invoked when received SCSI_CMD_INQUIRY
+void tud_msc_inquiry_cb(uint8_t lun, uint8_t vendor_id[8], uint8_t product_id[16], uint8_t product_rev[4])
+{
+    (void) lun;
+
+    memcpy(vendor_id, "XLAT    ", 8);
+    memcpy(product_id, "Latency runs    ", 16);
+    memcpy(product_rev, "1.0 ", 4);
+}
+
+// Invoked when received Test Unit Ready command
+bool tud_msc_test_unit_ready_cb(uint8_t lun)
+{
+    if (ejected) {
+        tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, 0x3a, 0x00);  // medium not present
+        return false;
+    }
+
+    if (!volume_built || (xlat_store_generation_get() != volume_generation)) {
+        volume_build();
+        tud_msc_set_sense(lun, SCSI_SENSE_UNIT_ATTENTION, 0x28, 0x00);  // medium may have changed
+        return false;
+    }
+
+    return true;
+}
+
+// Invoked when received SCSI_CMD_READ_CAPACITY_10 and SCSI_CMD_READ_FORMAT_CAPACITY
+void tud_msc_capacity_cb(uint8_t lun, uint32_t *block_count, uint16_t *block_size)
+{
+    (void) lun;
+
+    *block_count = VOLUME_SECTORS;
+    *block_size = SECTOR_SIZE;
+}
+
+// Invoked when received Start Stop Unit command
+bool tud_msc_start_stop_cb(uint8_t lun, uint8_t power_condition, bool start, bool load_eject)
+{
+    (void) lun;
+    (void) power_condition;
+
+    if (load_eject) {
+        ejected = !start;
+    }
+    return true;
+}
+
+// Callback invoked when received READ10 command
+int32_t tud_msc_read10_cb(uint8_t lun, uint32_t lba, uint32_t offset, void *buffer, uint32_t bufsize)
+{
+    (void) lun;
+    uint8_t *out = buffer;
+    uint32_t done = 0;
+
+    if (!volume_built) {
+        volume_build();
+    }
+
+    if (lba >= VOLUME_SECTORS) {
+        return -1;
+    }
+
+    while ((done < bufsize) && (lba < VOLUME_SECTORS)) {
+        uint32_t len = SECTOR_SIZE - offset;
+        if (len > (bufsize - done)) {
+            len = bufsize - done;
+        }
+        sector_read(lba, sector_buf);
+        memcpy(out + done, sector_buf + offset, len);
+        done += len;
+        offset = 0;
+        lba++;
+    }
+
+    return (int32_t) done;
+}
+
+bool tud_msc_is_writable_cb(uint8_t lun)
+{
+    (void) lun;
+    return false;
+}
+
+// Callback invoked when received WRITE10 command, the volume is read-only
+int32_t tud_msc_write10_cb(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t *buffer, uint32_t bufsize)
+{
+    (void) lba;
+    (void) offset;
+    (void) buffer;
+    (void) bufsize;
+
+    tud_msc_set_sense(lun, SCSI_SENSE_DATA_PROTECT, 0x27, 0x00);   // write protected
+    return -1;
+}
+
+// Callback invoked for the SCSI commands TinyUSB doesn't handle itself
+int32_t tud_msc_scsi_cb(uint8_t lun, uint8_t const scsi_cmd[16], void *buffer, uint16_t bufsize)
+{
+    (void) scsi_cmd;
+    (void) buffer;
+    (void) bufsize;
+
+    tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x20, 0x00);  // invalid command
+    return -1;
+}
@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "tusb.h"
+
+#include "usb_proxy.h"
+#include "xlat.h"
+
+#define PROXY_SETTLE_MS     100     // wait for all the interfaces of a device before re-enumerating
+#define PROXY_DETACH_MS     50      // long enough for the PC to notice the disconnect
+#define PROXY_REPORT_MAX    CFG_TUD_HID_EP_BUFSIZE
+
+#define BOOT_MOUSE_REPORT_LEN       5
+#define BOOT_KEYBOARD_REPORT_LEN    8
+
+_Static_assert(USB_PROXY_MAX_ITF == CFG_TUD_HID, "one device HID instance per proxied interface");
+_Static_assert(USB_PROXY_DESC_MAX >= CFG_TUH_ENUMERATION_BUFSIZE, "report descriptors don't fit");
+
+struct proxy_itf {
+    uint8_t dev_addr;
+    uint8_t instance;
+    uint8_t report_len;         // boot protocol: reports are padded to this length, 0 otherwise
+    uint16_t desc_len;
+    uint8_t desc[USB_PROXY_DESC_MAX];
+};
+
+// Interfaces of the measured device, maintained by the host task
+static struct proxy_itf mounted[USB_PROXY_MAX_ITF];
+static uint8_t mounted_count = 0;
+static volatile bool mounted_changed = false;
+static volatile TickType_t mounted_changed_tick;
+
+// What the PC enumerated, only changed by the device task while detached
+static struct proxy_itf active[USB_PROXY_MAX_ITF];
+static uint8_t active_count = 0;
+
+// Per device interface: the report being sent, and the latest one waiting for the endpoint.
+// A newer report replaces a waiting one, the PC only polls once per millisecond.
+static struct {
+    uint8_t buf[2][PROXY_REPORT_MAX];
+    uint16_t len[2];
+    uint32_t timestamp[2];
+    uint8_t fill;               // buffer the host task writes to
+    uint32_t sent_timestamp;    // reception time of the report on the endpoint
+    bool pending;
+    bool busy;
+} queue[USB_PROXY_MAX_ITF];
+
+static struct usb_proxy_stats stats;
+static uint64_t delay_sum_us = 0;
+
+// Used instead of the device's own descriptor when the host stack runs it in boot protocol
+static uint8_t const boot_mouse_desc[] = { TUD_HID_REPORT_DESC_MOUSE() };
+static uint8_t const boot_keyboard_desc[] = { TUD_HID_REPORT_DESC_KEYBOARD() };
+
+static void mounted_changed_set(void)
+{
+    mounted_changed_tick = xTaskGetTickCount();
+    mounted_changed = true;
+}
+
+// Both sides are tasks, the scheduler lock is enough and the measurement interrupt is never masked
+static void proxy_flush(uint8_t itf)
+{
+    vTaskSuspendAll();
+    bool send = queue[itf].pending && !queue[itf].busy;
+    uint8_t idx = queue[itf].fill;
+    if (send) {
+        queue[itf].pending = false;
+        queue[itf].busy = true;
+        queue[itf].sent_timestamp = queue[itf].timestamp[idx];
+        queue[itf].fill ^= 1;
+    }
+    xTaskResumeAll();
+
+    if (send && !tud_hid_n_report(itf, 0, queue[itf].buf[idx], queue[itf].len[idx])) {
+        queue[itf].busy = false;
+    }
+}
+
+void usb_proxy_mount(uint8_t dev_addr, uint8_t instance, const uint8_t *desc_report, uint16_t desc_len)
+{
+    uint8_t const itf_protocol = tuh_hid_interface_protocol(dev_addr, instance);
+    uint8_t report_len = 0;
+
+    if ((itf_protocol != HID_ITF_PROTOCOL_NONE) && (tuh_hid_get_protocol(dev_addr, instance) == HID_PROTOCOL_BOOT)) {
+        if (itf_protocol == HID_ITF_PROTOCOL_MOUSE) {
+            desc_report = boot_mouse_desc;
+            desc_len = sizeof(boot_mouse_desc);
+            report_len = BOOT_MOUSE_REPORT_LEN;
+        } else {
+            desc_report = boot_keyboard_desc;
+            desc_len = sizeof(boot_keyboard_desc);
+            report_len = BOOT_KEYBOARD_REPORT_LEN;
+        }
+    }
+
+    if ((desc_report == NULL) || (desc_len == 0) || (desc_len > USB_PROXY_DESC_MAX)) {
+        printf("HID proxy: no report descriptor for instance %d\n", instance);
+        return;
+    }
+    if (mounted_count == USB_PROXY_MAX_ITF) {
+        printf("HID proxy: instance %d not forwarded, out of device interfaces\n", instance);
+        return;
+    }
+
+    vTaskSuspendAll();
+    struct proxy_itf *p = &mounted[mounted_count++];
+    p->dev_addr = dev_addr;
+    p->instance = instance;
+    p->report_len = report_len;
+    p->desc_len = desc_len;
+    memcpy(p->desc, desc_report, desc_len);
+    mounted_changed_set();
+    xTaskResumeAll();
+}
+
+void usb_proxy_umount(uint8_t dev_addr, uint8_t instance)
+{
+    vTaskSuspendAll();
+    for (uint8_t i = 0; i < mounted_count; i++) {
+        if ((mounted[i].dev_addr == dev_addr) && (mounted[i].instance == instance)) {
+            memmove(&mounted[i], &mounted[i + 1], (mounted_count - i - 1) * sizeof(mounted[0]));
+            mounted_count--;
+            mounted_changed_set();
+            break;
+        }
+    }
+    xTaskResumeAll();
+}
+
+// Only copies the report: the host stack reuses its buffer as soon as the endpoint is re-armed
+XLAT_ITCM_FUNC void usb_proxy_report(uint8_t dev_addr, uint8_t instance, const uint8_t *report, uint16_t len,
+                                     uint32_t rx_timestamp)
+{
+    int8_t itf = -1;
+
+    if (!tud_mounted()) {
+        return;
+    }
+
+    vTaskSuspendAll();
+    for (uint8_t i = 0; i < active_count; i++) {
+        if ((active[i].dev_addr == dev_addr) && (active[i].instance == instance)) {
+            itf = (int8_t)i;
+            break;
+        }
+    }
+    if (itf >= 0) {
+        uint8_t *buf = queue[itf].buf[queue[itf].fill];
+        uint16_t out_len = active[itf].report_len ? active[itf].report_len : len;
+        if (out_len > PROXY_REPORT_MAX) {
+            out_len = PROXY_REPORT_MAX;
+        }
+        if (len > out_len) {
+            len = out_len;
+        }
+        memcpy(buf, report, len);
+        memset(buf + len, 0, out_len - len);
+        queue[itf].len[queue[itf].fill] = out_len;
+        queue[itf].timestamp[queue[itf].fill] = rx_timestamp;
+        if (queue[itf].pending) {
+            stats.coalesced++;
+        }
+        queue[itf].pending = true;
+    }
+    xTaskResumeAll();
+}
+
+XLAT_ITCM_FUNC void usb_proxy_send(void)
+{
+    if (!tud_mounted()) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < active_count; i++) {
+        proxy_flush(i);
+    }
+}
+
+void usb_proxy_task(void)
+{
+    if (!mounted_changed || ((xTaskGetTickCount() - mounted_changed_tick) < pdMS_TO_TICKS(PROXY_SETTLE_MS))) {
+        return;
+    }
+
+    // Stop forwarding, and let the PC see a disconnect before it enumerates the new interfaces
+    vTaskSuspendAll();
+    active_count = 0;
+    xTaskResumeAll();
+    tud_disconnect();
+    vTaskDelay(pdMS_TO_TICKS(PROXY_DETACH_MS));
+
+    vTaskSuspendAll();
+    memcpy(active, mounted, sizeof(active));
+    active_count = mounted_count;
+    mounted_changed = false;
+    memset(queue, 0, sizeof(queue));
+    xTaskResumeAll();
+
+    tud_connect();
+}
+
+uint8_t usb_proxy_itf_count_get(void)
+{
+    return active_count;
+}
+
+uint16_t usb_proxy_desc_len_get(uint8_t itf)
+{
+    return (itf < active_count) ? active[itf].desc_len : 0;
+}
+
+void usb_proxy_stats_get(struct usb_proxy_stats *out)
+{
+    vTaskSuspendAll();
+    *out = stats;
+    out->delay_avg_us = stats.forwarded ? (uint32_t)(delay_sum_us / stats.forwarded) : 0;
+    xTaskResumeAll();
+}
+
+//--------------------------------------------------------------------+
+// TinyUSB Callbacks
+//--------------------------------------------------------------------+
+
+// Invoked when received GET HID REPORT DESCRIPTOR
+uint8_t const * tud_hid_descriptor_report_cb(uint8_t instance)
+{
+    return active[instance].desc;
+}
+
+// Invoked when a report was delivered to the PC
+void tud_hid_report_complete_cb(uint8_t instance, uint8_t const *report, uint16_t len)
+{
+    (void) report;
+    (void) len;
+
+    uint32_t delay = xlat_counter_1mhz_get() - queue[instance].sent_timestamp;
+
+    vTaskSuspendAll();
+    stats.forwarded++;
+    delay_sum_us += delay;
+    if (delay > stats.delay_max_us) {
+        stats.delay_max_us = delay;
+    }
+    queue[instance].busy = false;
+    xTaskResumeAll();
+
+    proxy_flush(instance);
+}
+
+// Invoked when received GET_REPORT control request, not supported
+uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type,
+                               uint8_t *buffer, uint16_t reqlen)
+{
+    (void) instance;
+    (void) report_id;
+    (void) report_type;
+    (void) buffer;
+    (void) reqlen;
+    return 0;
+}
+
+// Invoked when received SET_REPORT control request (e.g. keyboard LEDs), not forwarded
+void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type,
+                           uint8_t const *buffer, uint16_t bufsize)
+{
+    (void) instance;
+    (void) report_id;
+    (void) report_type;
+    (void) buffer;
+    (void) bufsize;
+}
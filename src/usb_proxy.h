@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef USB_PROXY_H
+#define USB_PROXY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * HID pass-through: the HID interfaces of the device under test are re-exposed to the PC
+ * on the OTG_FS device port, so the device stays usable while it is measured.
+ *
+ * Report descriptors are mirrored (interfaces the host stack switched to the boot protocol
+ * get the standard boot descriptor instead), and every report is forwarded from the host
+ * stack callback, after the measurement has taken its timestamp and the endpoint is re-armed.
+ * When the set of interfaces changes, the device port re-enumerates.
+ */
+
+#define USB_PROXY_MAX_ITF       2       // CFG_TUD_HID, IN endpoints 0x84 and 0x85
+#define USB_PROXY_DESC_MAX      512     // CFG_TUH_ENUMERATION_BUFSIZE
+
+struct usb_proxy_stats {
+    uint32_t forwarded;
+    uint32_t coalesced;         // replaced by a newer report before the PC polled
+    uint32_t delay_avg_us;      // report received on OTG_HS -> delivered to the PC
+    uint32_t delay_max_us;
+};
+
+// USB host task
+void usb_proxy_mount(uint8_t dev_addr, uint8_t instance, const uint8_t *desc_report, uint16_t desc_len);
+void usb_proxy_umount(uint8_t dev_addr, uint8_t instance);
+void usb_proxy_report(uint8_t dev_addr, uint8_t instance, const uint8_t *report, uint16_t len, uint32_t rx_timestamp);
+void usb_proxy_send(void);      // forwards the reports queued by usb_proxy_report()
+
+// USB device task
+void usb_proxy_task(void);
+uint8_t usb_proxy_itf_count_get(void);
+uint16_t usb_proxy_desc_len_get(uint8_t itf);
+
+void usb_proxy_stats_get(struct usb_proxy_stats *stats);
+
+#endif //USB_PROXY_H
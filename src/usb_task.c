@@ -172,6 +172,7 @@ static char manufacturer_string[64];
 static char product_string[64];
 static char serial_string[64];
 static char vidpid_string[32];  // Format: "VID:XXXX PID:XXXX"
+static tusb_desc_device_t device_descriptor;
 
 // Helper function to convert UTF-16LE to UTF-8
 static void utf16le_to_utf8(const uint16_t* utf16, size_t utf16_len, char* utf8, size_t utf8_len) {
@@ -198,6 +199,8 @@ static void utf16le_to_utf8(const uint16_t* utf16, size_t utf16_len, char* utf8,
 
 // Get and buffer string descriptors
 static void update_string_descriptors(uint8_t daddr, tusb_desc_device_t *desc_device) {
+    memcpy(&device_descriptor, desc_device, sizeof(device_descriptor));
+
     uint16_t temp_buf[64];
     
     // Get manufacturer string
@@ -277,3 +280,8 @@ const char * usb_host_get_vidpid_string(void)
 {
     return vidpid_string;
 }
+
+const uint8_t * usb_host_get_device_descriptor(void)
+{
+    return (const uint8_t *)&device_descriptor;
+}
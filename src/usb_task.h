@@ -1,8 +1,11 @@
 #pragma once
 
+#include <stdint.h>
+
 void usb_host_task(void const *param);
 const char* usb_host_get_manuf_string(void);
 const char* usb_host_get_product_string(void);
 const char* usb_host_get_serial_string(void);
 const char* usb_host_get_vidpid_string(void);
+const uint8_t* usb_host_get_device_descriptor(void); // 18 bytes, zeros when no device was mounted
 
@@ -26,6 +26,13 @@
 #include "main.h"
 #include "xlat.h"
 #include "xlat_config.h"
+#include "xlat_trace.h"
+#include "xlat_log.h"
+#include "xlat_hist.h"
+#include "xlat_robust.h"
+#include "xlat_history.h"
+#include "xlat_store.h"
+#include "xlat_sdlog.h"
 #include "stm32f7xx_hal_tim.h"
 #include "hardware_config.h"
 #include "stdio_glue.h"
@@ -38,29 +45,41 @@
 
 #include "Drivers/USB/Class/Common/HIDParser.h"
 
-volatile uint32_t usb_hid_rx_timestamp; // set in OTG_HS_IRQHandler
+XLAT_DTCM_BSS volatile uint32_t usb_hid_rx_timestamp; // set in OTG_HS_IRQHandler
+XLAT_DTCM_BSS volatile uint32_t gpio_irq_timestamp;   // set in the EXTI IRQ handlers
 
-static uint32_t last_btn_gpio_timestamp = 0;
+XLAT_DTCM_BSS static uint32_t last_btn_gpio_timestamp;
 static uint32_t last_usb_timestamp_us = 0;
 static uint32_t last_latency_us[LATENCY_TYPE_MAX];
 static uint64_t average_latency_us_sum[LATENCY_TYPE_MAX]; // sum of all measurements
 static uint64_t average_latency_us_sum_sq[LATENCY_TYPE_MAX]; // sum of squares, for variance
 static uint32_t average_latency_us_count[LATENCY_TYPE_MAX];
 
-static volatile uint_fast8_t gpio_irq_producer = 0;
-static volatile uint_fast8_t gpio_irq_consumer = 0;
+XLAT_DTCM_BSS static volatile uint_fast8_t gpio_irq_producer;
+XLAT_DTCM_BSS static volatile uint_fast8_t gpio_irq_consumer;
+
+static uint32_t hid_event_drops = 0; // events lost because the pool or queue was full
+
+static volatile bool quiet_window = false;
+static volatile uint32_t quiet_window_start_tick;
+static bool last_sample_quiet = false;
+
+// Report descriptor of the interface the measurement uses, recorded in the captures
+static uint8_t report_desc[512];
+static uint16_t report_desc_len = 0;
 
 // SETTINGS
 volatile bool       xlat_initialized = false;
-static TimerHandle_t xlat_timer_handle;
+XLAT_DTCM_BSS static TimerHandle_t xlat_timer_handle;
 
 
 ///////////////////////
 // PRIVATE FUNCTIONS //
 ///////////////////////
 
-// Locations of the clicks and X Y motion bytes in the HID report
-uint8_t prev_report[REPORT_LEN];
+// Previous report of each protocol, a combo device sends both on separate interfaces
+XLAT_DTCM_BSS static uint8_t prev_mouse_report[REPORT_LEN];
+XLAT_DTCM_BSS static hid_keyboard_report_t prev_kbd_report;
 
 static inline void hidreport_print_item(HID_ReportItem_t *item)
 {
@@ -218,13 +237,17 @@ static int calculate_gpio_to_usb_time(void)
     }
     gpio_irq_consumer = gpio_irq_producer;
 
+    // This is the report the quiet window was waiting for, the GUI may run again
+    last_sample_quiet = xlat_quiet_window_active();
+    quiet_window = false;
+
     xSemaphoreTake(lvgl_mutex, portMAX_DELAY);
     gfx_trigger_ready_set(false);
     xSemaphoreGive(lvgl_mutex);
 
     // gpio -> usb stats
     int32_t us = last_usb_timestamp_us - last_btn_gpio_timestamp;
-    printf("[gpio -> usb] diff: us: %5ld\n", us);
+    xlat_log("[gpio -> usb] diff: us: %5ld\n", us);
 
     // drop negative values
     if (us < 0) {
@@ -232,13 +255,13 @@ static int calculate_gpio_to_usb_time(void)
     }
 
     xlat_latency_measurement_add(us, LATENCY_GPIO_TO_USB);
+    XLAT_TRACE(XLAT_TRACE_ID_MEASUREMENT, last_sample_quiet, (us > UINT16_MAX) ? UINT16_MAX : us);
+    xlat_store_add(last_btn_gpio_timestamp, us, last_sample_quiet, xlat_robust_last_outlier_get());
+    xlat_sdlog_add(last_btn_gpio_timestamp, us, last_sample_quiet);
 
-    // send a message to the gfx thread, to refresh the plot
-    struct gfx_event *evt;
-    evt = osPoolAlloc(gfxevt_pool); // Allocate memory for the message
-    evt->type = GFX_EVENT_MEASUREMENT;
-    evt->value = us;
-    osMessagePut(msgQGfxTask, (uint32_t)evt, 0U);
+    // send a message to the gfx thread, to refresh the plot. When it is behind, the
+    // next measurement refreshes it
+    gfx_event_send(GFX_EVENT_MEASUREMENT, us);
 
     return 0;
 }
@@ -248,7 +271,7 @@ static int calculate_gpio_to_usb_time(void)
 // PUBLIC FUNCTIONS //
 //////////////////////
 
-uint32_t xlat_counter_1mhz_get(void)
+XLAT_ITCM_FUNC uint32_t xlat_counter_1mhz_get(void)
 {
     return __HAL_TIM_GET_COUNTER(&XLAT_TIMx_handle);
 }
@@ -263,90 +286,22 @@ void xlat_process_usb_hid_event(void)
     }
 
     struct hid_event *hevt = evt.value.p;
-
-    switch (hevt->itf_protocol) {
-        case HID_ITF_PROTOCOL_MOUSE: {
-            uint8_t* hid_raw_data = hevt->report;
-
-            // Check if the report ID is matching what's expected
-            if ((xlat_report_id_get() != 0) && (hid_raw_data[0] != xlat_report_id_get())) {
-                // ignore
-                goto out;
-            }
-    
-#if 0
-            printf("[%5lu] hid@%lu: ", xTaskGetTickCount(), hevt->timestamp);
-            for (int i = 0; i < hevt->report_size; i++) {
-                printf("%02x ", hid_raw_data[i]);
-            }
-            printf("\n");
-#endif
-
-            // FOR BUTTONS/CLICKS:
-            if (xlat_mode_get() == XLAT_MODE_MOUSE_CLICK) {
-                // The correct location of button data is determined by parsing the HID descriptor
-                // This information is available in the button_mask
-                for (uint8_t i = (xlat_report_id_get() ? 1 : 0); i < hevt->report_size; i++) {
-                    if (((hid_raw_data[i] ^ prev_report[i]) & hid_raw_data[i] & xlat_button_mask_get()[i])) {
-                        last_usb_timestamp_us = hevt->timestamp;
-                        calculate_gpio_to_usb_time();
-                        printf("[%5lu] hid click @ %lu - byte %d\n", xTaskGetTickCount(), hevt->timestamp, i);
-                        break;
-                    }
-                }
-            }
-            // FOR MOTION:
-            else if (xlat_mode_get() == XLAT_MODE_MOUSE_MOTION) {
-                // The correct location of button data is determined by parsing the HID descriptor
-                // This information is available in the motion_mask
-                for (uint8_t i = (xlat_report_id_get() ? 1 : 0); i < hevt->report_size; i++) {
-                    if (hid_raw_data[i] & xlat_motion_mask_get()[i]) {
-                        last_usb_timestamp_us = hevt->timestamp;
-                        calculate_gpio_to_usb_time();
-                        printf("[%5lu] hid motion @ %lu\n", xTaskGetTickCount(), hevt->timestamp);
-                        break;
-                    }
-                }
-            }
-            // Save the report for the next iteration
-            memcpy(prev_report, hid_raw_data, sizeof(prev_report));
-        }
-
-        case HID_ITF_PROTOCOL_KEYBOARD:
-            if (xlat_mode_get() != XLAT_MODE_KEYBOARD) {
-                goto out;
-            }
-            hid_keyboard_report_t *kbd_report = (hid_keyboard_report_t *)hevt->report;
-
-            // check the modifier bits:
-            if (kbd_report->modifier) {
-                // Save the captured USB event timestamp
-                last_usb_timestamp_us = hevt->timestamp;
-                // calculate the time between the last key press and this key press:
-                calculate_gpio_to_usb_time();
-                printf("USB HID event: modifier 0x%02X\n", kbd_report->modifier);
-                break;
-            }
-
-            // loop over the keycode array to see if any keys are pressed:
-            for (uint8_t i = 0; i < 6; i++) {
-                if (kbd_report->keycode[i]) {
-                    if (kbd_report->keycode[i] > 1) {
-                        // Save the captured USB event timestamp
-                        last_usb_timestamp_us = hevt->timestamp;
-                        // calculate the time between the last key press and this key press:
-                        calculate_gpio_to_usb_time();
-                        printf("USB HID event: key press 0x%02X\n", kbd_report->keycode[i]);
-                    }
-                }
-            }
-            break;
-
-        default:
-            break;
+    XLAT_TRACE(XLAT_TRACE_ID_XLAT_EVENT, hevt->changed, 0);
+
+    // Relevant fields were already extracted in the USB callback
+    last_usb_timestamp_us = hevt->timestamp;
+    calculate_gpio_to_usb_time();
+
+    if (hevt->changed & HID_EVENT_CHANGED_BUTTON) {
+        xlat_log("[%5lu] hid click @ %lu - byte %lu\n", xTaskGetTickCount(), hevt->timestamp, hevt->detail);
+    } else if (hevt->changed & HID_EVENT_CHANGED_MOTION) {
+        xlat_log("[%5lu] hid motion @ %lu\n", xTaskGetTickCount(), hevt->timestamp);
+    } else if (hevt->changed & HID_EVENT_CHANGED_MODIFIER) {
+        xlat_log("USB HID event: modifier 0x%02lX\n", hevt->detail);
+    } else if (hevt->changed & HID_EVENT_CHANGED_KEY) {
+        xlat_log("USB HID event: key press 0x%02lX\n", hevt->detail);
     }
 
-out:
     // free event memory
     osPoolFree(hidevt_pool, hevt);
 }
@@ -356,9 +311,10 @@ out:
   * @param  GPIO_Pin Specifies the pins connected EXTI line
   * @retval None
   */
-void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+XLAT_ITCM_FUNC void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
 {
-    uint32_t cnt = xlat_counter_1mhz_get();
+    // Latched on IRQ entry
+    uint32_t cnt = gpio_irq_timestamp;
     // debounce X ms
     if (cnt - last_btn_gpio_timestamp < xlat_gpio_irq_holdoff_us_get()) {
         return;
@@ -377,26 +333,132 @@ void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
 }
 
 
+// Mouse: a button went down, or the report carries X/Y motion
+XLAT_ITCM_FUNC static uint8_t hid_mouse_changes_get(uint8_t const *report, size_t report_size, uint8_t *detail)
+{
+    // Check if the report ID is matching what's expected
+    if ((xlat_report_id_get() != 0) && (report[0] != xlat_report_id_get())) {
+        return 0;
+    }
+
+    uint8_t changed = 0;
+
+    // The correct location of button/motion data is determined by parsing the HID descriptor
+    // This information is available in the button_mask and motion_mask
+    if (xlat_mode_get() == XLAT_MODE_MOUSE_CLICK) {
+        for (uint8_t i = (xlat_report_id_get() ? 1 : 0); i < report_size; i++) {
+            if ((report[i] ^ prev_mouse_report[i]) & report[i] & xlat_button_mask_get()[i]) {
+                changed = HID_EVENT_CHANGED_BUTTON;
+                *detail = i;
+                break;
+            }
+        }
+
+        // Save the report for the next iteration, only the click mode compares with it
+        memcpy(prev_mouse_report, report, report_size);
+    } else if (xlat_mode_get() == XLAT_MODE_MOUSE_MOTION) {
+        for (uint8_t i = (xlat_report_id_get() ? 1 : 0); i < report_size; i++) {
+            if (report[i] & xlat_motion_mask_get()[i]) {
+                changed = HID_EVENT_CHANGED_MOTION;
+                *detail = i;
+                break;
+            }
+        }
+    }
+
+    return changed;
+}
+
+// Keyboard: a modifier or a key that was not held in the previous report
+XLAT_ITCM_FUNC static uint8_t hid_keyboard_changes_get(uint8_t const *report, size_t report_size, uint8_t *detail)
+{
+    if ((xlat_mode_get() != XLAT_MODE_KEYBOARD) || (report_size < sizeof(hid_keyboard_report_t))) {
+        return 0;
+    }
+
+    hid_keyboard_report_t const *kbd_report = (hid_keyboard_report_t const *)report;
+    uint8_t changed = 0;
+
+    // check the modifier bits:
+    uint8_t new_modifiers = kbd_report->modifier & ~prev_kbd_report.modifier;
+    if (new_modifiers) {
+        changed = HID_EVENT_CHANGED_MODIFIER;
+        *detail = new_modifiers;
+    } else {
+        // loop over the keycode array to see if any new keys are pressed (0x01 is ErrorRollOver):
+        for (uint8_t i = 0; (i < 6) && !changed; i++) {
+            uint8_t key = kbd_report->keycode[i];
+            if (key <= 1) {
+                continue;
+            }
+            changed = HID_EVENT_CHANGED_KEY;
+            *detail = key;
+            for (uint8_t j = 0; j < 6; j++) {
+                if (prev_kbd_report.keycode[j] == key) {
+                    changed = 0;
+                    break;
+                }
+            }
+        }
+    }
+
+    memcpy(&prev_kbd_report, report, sizeof(hid_keyboard_report_t));
+
+    return changed;
+}
+
 /**
-  * @brief  The function is a callback about HID Data events
-  *  @param  phost: Selected device
+  * @brief  Called from the USB host task for every HID report received.
+  *         The relevant fields are extracted here, and a compact event is only
+  *         queued to the xlat task when the report carries a relevant transition.
   * @retval None
   */
-
-// In this callback the timestamp is wrapped in an event and sent to the main thread
-void xlat_usb_event_callback(uint32_t timestamp, uint8_t const *report, size_t report_size, uint8_t itf_protocol)
+XLAT_ITCM_FUNC void xlat_usb_event_callback(uint32_t timestamp, uint8_t dev_addr, uint8_t instance, uint8_t const *report, size_t report_size, uint8_t itf_protocol)
 {
-    struct hid_event *evt;
+    (void) dev_addr;
+    (void) instance;
+    uint8_t changed = 0;
+    uint8_t detail = 0;
+
+    if (report_size > sizeof(prev_mouse_report)) {
+        report_size = sizeof(prev_mouse_report);
+    }
 
-    evt = osPoolAlloc(hidevt_pool); // Allocate memory for the message
+    switch (itf_protocol) {
+        case HID_ITF_PROTOCOL_MOUSE:
+            changed = hid_mouse_changes_get(report, report_size, &detail);
+            break;
+
+        case HID_ITF_PROTOCOL_KEYBOARD:
+            changed = hid_keyboard_changes_get(report, report_size, &detail);
+            break;
+
+        default:
+            break;
+    }
+
+    if (!changed) {
+        return;
+    }
+
+    struct hid_event *evt = osPoolAlloc(hidevt_pool); // Allocate memory for the message
+    if (evt == NULL) {
+        hid_event_drops++;
+        return;
+    }
     evt->timestamp = timestamp;
-    evt->itf_protocol = itf_protocol;
-    if (report_size > sizeof(evt->report)) {
-        report_size = sizeof(evt->report);
+    evt->changed = changed;
+    evt->detail = detail;
+    XLAT_TRACE(XLAT_TRACE_ID_HID_EVENT, changed, 0);
+    if (osMessagePut(msgQUsbHidEvent, (uint32_t)evt, 0U) != osOK) {
+        osPoolFree(hidevt_pool, evt);
+        hid_event_drops++;
     }
-    evt->report_size = report_size;
-    memcpy(evt->report, report, report_size);
-    osMessagePut(msgQUsbHidEvent, (uint32_t)evt, 0U);
+}
+
+uint32_t xlat_hid_event_drop_count_get(void)
+{
+    return hid_event_drops;
 }
 
 
@@ -423,12 +485,17 @@ uint32_t xlat_latency_average_get(enum latency_type type)
 
 uint32_t xlat_latency_variance_get(enum latency_type type)
 {
-    if (type >= LATENCY_TYPE_MAX) {
+    if ((type >= LATENCY_TYPE_MAX) || (average_latency_us_count[type] == 0)) {
         return 0;
     }
-    uint64_t avg = average_latency_us_sum[type] / average_latency_us_count[type];
-    uint64_t avg_sq = average_latency_us_sum_sq[type] / average_latency_us_count[type];
-    return (uint32_t)(avg_sq - avg * avg);
+    // In double: averages rounded down to whole us would inflate the variance of tight
+    // distributions, which is what the auto-stop rule looks at
+    double avg = (double)average_latency_us_sum[type] / average_latency_us_count[type];
+    double variance = (double)average_latency_us_sum_sq[type] / average_latency_us_count[type] - avg * avg;
+    if (variance <= 0.0) {
+        return 0;
+    }
+    return (variance >= (double)UINT32_MAX) ? UINT32_MAX : (uint32_t)(variance + 0.5);
 }
 
 uint32_t xlat_latency_standard_deviation_get(enum latency_type type)
@@ -456,9 +523,15 @@ void xlat_latency_measurement_add(uint32_t latency_us, enum latency_type type)
     }
     last_latency_us[type] = latency_us;
     average_latency_us_sum[type] += latency_us;
-    average_latency_us_sum_sq[type] += latency_us * latency_us;
+    average_latency_us_sum_sq[type] += (uint64_t)latency_us * latency_us;  // 32 bits wrap at 65.5 ms
     average_latency_us_count[type]++;
 
+    if (type == LATENCY_GPIO_TO_USB) {
+        xlat_hist_add(latency_us);
+        xlat_history_add(latency_us);
+        xlat_robust_add(latency_us);
+    }
+
 //    printf(">>> GPIO->USB latency: %5lu us, ", last_gpio_to_usb_latency_us);
 //    printf("average latency: %5lu us\n", (uint32_t)(average_latency_us_sum / average_latency_us_count));
 }
@@ -471,6 +544,11 @@ void xlat_latency_reset(void)
         average_latency_us_sum_sq[i] = 0;
         average_latency_us_count[i] = 0;
     }
+    xlat_hist_reset();
+    xlat_history_reset();
+    xlat_robust_reset();
+    xlat_store_run_close();
+    xlat_sdlog_run_end();
 }
 
 static void xlat_timer_callback(TimerHandle_t xTimer)
@@ -484,6 +562,18 @@ static void xlat_timer_callback(TimerHandle_t xTimer)
     xSemaphoreGive(lvgl_mutex);
 }
 
+// Busy-wait a random 0..999 us before each GPIO edge toggle so the edge
+// phase is uniform vs the USB SOF — works for both speeds:
+//   - HS (125 us microframe): 1000 = 8 * 125, so delay_us mod 125 is
+//     uniform 0..124 -> uniform phase vs HS SOF.
+//   - FS (1 ms frame): delay_us is already uniform across the full frame.
+void xlat_auto_trigger_desync_sof(void)
+{
+    uint32_t delay_us = rand() % 1000;
+    uint32_t t0 = xlat_counter_1mhz_get();
+    while ((xlat_counter_1mhz_get() - t0) < delay_us) { /* spin */ }
+}
+
 void xlat_auto_trigger_action(void)
 {
     if (xlat_auto_trigger_output_get() == 6) {
@@ -502,15 +592,35 @@ void xlat_auto_trigger_turn_off_action(void)
     }
 }
 
+void xlat_quiet_window_start(void)
+{
+    quiet_window_start_tick = xTaskGetTickCount();
+    quiet_window = true;
+}
+
+bool xlat_quiet_window_active(void)
+{
+    if (quiet_window && (xTaskGetTickCount() - quiet_window_start_tick) > pdMS_TO_TICKS(QUIET_WINDOW_TIMEOUT_MS)) {
+        quiet_window = false;
+    }
+    return quiet_window;
+}
+
+bool xlat_last_sample_quiet_get(void)
+{
+    return last_sample_quiet;
+}
+
 void xlat_print_measurement(void)
 {
     // print the new measurement to the console in csv format
     char buf[50];
-    snprintf(buf, sizeof(buf), "%lu;%lu;%lu;%lu\n",
+    snprintf(buf, sizeof(buf), "%lu;%lu;%lu;%lu;%u\n",
              xlat_latency_count_get(LATENCY_GPIO_TO_USB),
              xlat_last_latency_us_get(LATENCY_GPIO_TO_USB),
              xlat_latency_average_get(LATENCY_GPIO_TO_USB),
-             xlat_latency_standard_deviation_get(LATENCY_GPIO_TO_USB));
+             xlat_latency_standard_deviation_get(LATENCY_GPIO_TO_USB),
+             xlat_last_sample_quiet_get());
     vcp_writestr(buf);
 }
 
@@ -556,6 +666,9 @@ void xlat_parse_hid_descriptor(uint8_t *desc, size_t desc_size, uint8_t itf_prot
         return;
     }
 
+    report_desc_len = (desc_size < sizeof(report_desc)) ? desc_size : sizeof(report_desc);
+    memcpy(report_desc, desc, report_desc_len);
+
     printf("Button mask: ");
     for (int i = 0; i < REPORT_LEN; i++) {
         printf("%02x", xlat_button_mask_get()[i]);
@@ -583,13 +696,21 @@ void xlat_clear_device_info(void)
 void xlat_clear_locations(void)
 {
     printf("Clearing locations\n");
-    memset(prev_report, 0, sizeof(prev_report));
+    memset(prev_mouse_report, 0, sizeof(prev_mouse_report));
+    memset(&prev_kbd_report, 0, sizeof(prev_kbd_report));
     memset(xlat_button_mask_get(), 0, REPORT_LEN);
     memset(xlat_motion_mask_get(), 0, REPORT_LEN);
     *(xlat_button_bits_get()) = 0;
     *(xlat_motion_bits_get()) = 0;
     xlat_report_id_set(0);
     xlat_keyboard_usage_page_found_set(false);
+    report_desc_len = 0;
+}
+
+uint16_t xlat_hid_report_desc_get(const uint8_t **desc)
+{
+    *desc = report_desc;
+    return report_desc_len;
 }
 
 void xlat_init(void)
@@ -602,7 +723,7 @@ void xlat_init(void)
     printf("XLAT initialized\n");
 
     char buf[50];
-    snprintf(buf, sizeof(buf), "count;latency_us;avg_us;stdev_us\n");
+    snprintf(buf, sizeof(buf), "count;latency_us;avg_us;stdev_us;quiet\n");
     vcp_writestr(buf);
 }
 
@@ -22,14 +22,29 @@
 #include <stdint.h>
 #include <stddef.h>
 
-#define AUTO_TRIGGER_PRESSED_PERIOD_MS (30)
+// Timing-critical code and data on the button/USB interrupt paths, placed in the
+// tightly coupled memories (see the .itcm_text/.dtcm_* sections in the linker script)
+#define XLAT_ITCM_FUNC  __attribute__((section(".itcm_text"), noinline))
+#define XLAT_DTCM_DATA  __attribute__((section(".dtcm_data")))
+#define XLAT_DTCM_BSS   __attribute__((section(".dtcm_bss")))
+
+#define AUTO_TRIGGER_PRESSED_PERIOD_MS (30) // default, see xlat_auto_trigger_pressed_ms_set()
+#define AUTO_TRIGGER_PRESSED_MIN_MS (10)
+#define AUTO_TRIGGER_COUNT_DEFAULT (1000)
+#define QUIET_WINDOW_TIMEOUT_MS (200) // give up waiting for the report after this
 #define REPORT_LEN 64
 
+// What changed in a HID report, as detected in the USB callback
+#define HID_EVENT_CHANGED_BUTTON    (1 << 0) // mouse button pressed
+#define HID_EVENT_CHANGED_MOTION    (1 << 1) // mouse X/Y motion
+#define HID_EVENT_CHANGED_MODIFIER  (1 << 2) // keyboard modifier pressed
+#define HID_EVENT_CHANGED_KEY       (1 << 3) // keyboard key pressed
+
+// Compact event, only queued when a report carries a relevant transition
 typedef struct hid_event {
-    uint32_t timestamp;
-    uint8_t report[64];
-    size_t report_size;
-    uint8_t itf_protocol;
+    uint32_t timestamp;     // OTG_HS IRQ timestamp (1 MHz)
+    uint8_t changed;        // HID_EVENT_CHANGED_* bits
+    uint8_t detail;         // report byte (mouse), modifier or keycode (keyboard)
 } hid_event_t;
 
 typedef enum latency_type {
@@ -47,11 +62,13 @@ typedef enum xlat_mode {
 
 extern volatile bool xlat_initialized;
 extern volatile uint32_t usb_hid_rx_timestamp; // set in OTG_HS_IRQHandler
+extern volatile uint32_t gpio_irq_timestamp;   // set in the EXTI IRQ handlers
 
 void xlat_init(void);
 void xlat_task(void const * argument);
 void xlat_process_usb_hid_event(void);
-void xlat_usb_event_callback(uint32_t timestamp, uint8_t const *report, size_t report_size, uint8_t itf_protocol); // called from USB Host library
+void xlat_usb_event_callback(uint32_t timestamp, uint8_t dev_addr, uint8_t instance, uint8_t const *report, size_t report_size, uint8_t itf_protocol); // called from USB Host library
+uint32_t xlat_hid_event_drop_count_get(void);
 
 uint32_t xlat_last_latency_us_get(enum latency_type type);
 uint32_t xlat_latency_average_get(enum latency_type type);
@@ -77,8 +94,16 @@ bool xlat_get_using_reportid(void);
 void xlat_parse_hid_descriptor(uint8_t *desc, size_t desc_size, uint8_t itf_protocol); // on device connect
 void xlat_clear_device_info(void); // on device disconnect
 void xlat_clear_locations(void);
+uint16_t xlat_hid_report_desc_get(const uint8_t **desc); // of the measured interface, 0 when none
 
+void xlat_auto_trigger_desync_sof(void);
 void xlat_auto_trigger_action(void);
 void xlat_auto_trigger_turn_off_action(void);
 
+// Quiet mode: the GUI is paused from just before an auto-trigger edge until the
+// matching report was measured, or until QUIET_WINDOW_TIMEOUT_MS passed
+void xlat_quiet_window_start(void);
+bool xlat_quiet_window_active(void);
+bool xlat_last_sample_quiet_get(void);
+
 #endif //XLAT_H
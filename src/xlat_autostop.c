@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <math.h>
+
+#include "xlat_autostop.h"
+
+#include "xlat.h"
+#include "xlat_hist.h"
+
+#define P99 0.99f
+
+static struct xlat_autostop_config config = {
+    .enabled = false,
+    .level_pct = 95,
+    .mean_half_width_us = XLAT_AUTOSTOP_MEAN_HALF_WIDTH_US,
+    .p99_half_width_us = 0,
+    .min_samples = XLAT_AUTOSTOP_MIN_SAMPLES,
+    .max_samples = XLAT_AUTOSTOP_MAX_SAMPLES,
+};
+
+// Two-sided standard normal quantile for the confidence level
+static float z_get(uint8_t level_pct)
+{
+    switch (level_pct) {
+        case 90:
+            return 1.645f;
+        case 99:
+            return 2.576f;
+        default:
+            return 1.960f;
+    }
+}
+
+// Interval for the P99 from the ranks n*p +/- z*sqrt(n*p*(1-p)), to the bin edges.
+// Returns false while n is too small for the upper rank to exist.
+static bool p99_interval_get(uint32_t n, float z, uint32_t *low_us, uint32_t *high_us)
+{
+    float center = n * P99;
+    float spread = z * sqrtf(n * P99 * (1.0f - P99));
+    float low_rank = floorf(center - spread);
+    float high_rank = ceilf(center + spread);
+
+    if ((n == 0) || (high_rank >= (float)n)) {
+        return false;
+    }
+
+    uint16_t low_bin = xlat_hist_rank_bin_get(low_rank > 0.0f ? (uint32_t)low_rank : 0);
+    uint16_t high_bin = xlat_hist_rank_bin_get((uint32_t)high_rank);
+    if (high_bin == XLAT_HIST_BINS - 1) {
+        // Everything above the histogram range lands in the last bin
+        return false;
+    }
+
+    *low_us = low_bin * XLAT_HIST_BIN_US;
+    *high_us = (high_bin + 1) * XLAT_HIST_BIN_US;
+    return true;
+}
+
+void xlat_autostop_config_get(struct xlat_autostop_config *cfg)
+{
+    *cfg = config;
+}
+
+bool xlat_autostop_config_set(const struct xlat_autostop_config *cfg)
+{
+    if (((cfg->level_pct != 90) && (cfg->level_pct != 95) && (cfg->level_pct != 99)) ||
+        (cfg->mean_half_width_us == 0) || (cfg->min_samples < 2) || (cfg->max_samples < cfg->min_samples)) {
+        return false;
+    }
+    config = *cfg;
+    return true;
+}
+
+bool xlat_autostop_enabled(void)
+{
+    return config.enabled;
+}
+
+uint32_t xlat_autostop_run_length_get(void)
+{
+    return config.enabled ? config.max_samples : AUTO_TRIGGER_COUNT_DEFAULT;
+}
+
+bool xlat_autostop_check(struct xlat_autostop_status *status)
+{
+    struct xlat_autostop_status st = {
+        .count = xlat_latency_count_get(LATENCY_GPIO_TO_USB),
+        .mean_half_width_us = UINT32_MAX,
+        .p99_low_us = 0,
+        .p99_high_us = UINT32_MAX,
+    };
+    float z = z_get(config.level_pct);
+
+    if (st.count >= 2) {
+        float variance = (float)xlat_latency_variance_get(LATENCY_GPIO_TO_USB);
+        st.mean_half_width_us = (uint32_t)ceilf(z * sqrtf(variance / st.count));
+    }
+    bool p99_known = p99_interval_get(xlat_hist_total_get(), z, &st.p99_low_us, &st.p99_high_us);
+
+    if (st.count >= config.max_samples) {
+        st.done = true;
+    } else if (st.count >= config.min_samples) {
+        st.done = (st.mean_half_width_us <= config.mean_half_width_us);
+        if (config.p99_half_width_us) {
+            st.done = st.done && p99_known &&
+                      ((st.p99_high_us - st.p99_low_us) / 2 <= config.p99_half_width_us);
+        }
+    }
+    st.done = st.done && config.enabled;
+
+    if (status) {
+        *status = st;
+    }
+    return st.done;
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef XLAT_AUTOSTOP_H
+#define XLAT_AUTOSTOP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Adaptive run length: an auto-trigger run ends once the latency is known well enough.
+ *
+ * Checked by the auto-trigger loop before every press. The run stops when, at the
+ * configured confidence level, the interval for the mean is within +/- mean_half_width_us
+ * (normal approximation, from the streaming sum and sum of squares) and, if enabled, the
+ * interval for the P99 is within +/- p99_half_width_us. The P99 interval is distribution
+ * free, from the order statistics in the histogram, so it can't get narrower than
+ * XLAT_HIST_BIN_US / 2. The run never stops before min_samples, and always at max_samples.
+ */
+
+#define XLAT_AUTOSTOP_MEAN_HALF_WIDTH_US    20
+#define XLAT_AUTOSTOP_MIN_SAMPLES           100
+#define XLAT_AUTOSTOP_MAX_SAMPLES           5000
+
+struct xlat_autostop_config {
+    bool enabled;
+    uint8_t level_pct;              // 90, 95 or 99
+    uint32_t mean_half_width_us;
+    uint32_t p99_half_width_us;     // 0: the P99 doesn't matter
+    uint32_t min_samples;
+    uint32_t max_samples;
+};
+
+struct xlat_autostop_status {
+    uint32_t count;
+    uint32_t mean_half_width_us;    // UINT32_MAX until there are 2 samples
+    uint32_t p99_low_us;            // 0 and UINT32_MAX until there are enough samples
+    uint32_t p99_high_us;
+    bool done;
+};
+
+void xlat_autostop_config_get(struct xlat_autostop_config *cfg);
+bool xlat_autostop_config_set(const struct xlat_autostop_config *cfg);    // false if out of range
+bool xlat_autostop_enabled(void);
+
+// Presses for a new run: max_samples when enabled, otherwise AUTO_TRIGGER_COUNT_DEFAULT
+uint32_t xlat_autostop_run_length_get(void);
+
+// True when the current run can stop, status can be NULL
+bool xlat_autostop_check(struct xlat_autostop_status *status);
+
+#endif //XLAT_AUTOSTOP_H
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef XLAT_BLOCKDEV_H
+#define XLAT_BLOCKDEV_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 512-byte block device, what the SD card logger writes to.
+ *
+ * Calls block the caller until the transfer is done, they are only made from the
+ * logger task. Buffers must be 32-byte aligned and a multiple of 32 bytes long
+ * (cache maintenance around the SDMMC DMA).
+ */
+
+#define XLAT_BLOCK_SIZE     512
+
+struct xlat_blockdev {
+    uint32_t block_count;
+    bool (*read)(struct xlat_blockdev *bd, uint32_t lba, void *buf, uint32_t count);
+    bool (*write)(struct xlat_blockdev *bd, uint32_t lba, const void *buf, uint32_t count);
+    void *ctx;
+};
+
+// microSD card on SDMMC1, false when there is no card or it doesn't initialize
+bool xlat_blockdev_sd_init(struct xlat_blockdev *bd);
+
+// Block device in memory, for the host build
+void xlat_blockdev_ram_init(struct xlat_blockdev *bd, void *mem, uint32_t block_count);
+
+#endif //XLAT_BLOCKDEV_H
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <string.h>
+
+#include "xlat_blockdev.h"
+
+static bool ram_read(struct xlat_blockdev *bd, uint32_t lba, void *buf, uint32_t count)
+{
+    if ((lba + count) > bd->block_count) {
+        return false;
+    }
+    memcpy(buf, (uint8_t *)bd->ctx + lba * XLAT_BLOCK_SIZE, count * XLAT_BLOCK_SIZE);
+    return true;
+}
+
+static bool ram_write(struct xlat_blockdev *bd, uint32_t lba, const void *buf, uint32_t count)
+{
+    if ((lba + count) > bd->block_count) {
+        return false;
+    }
+    memcpy((uint8_t *)bd->ctx + lba * XLAT_BLOCK_SIZE, buf, count * XLAT_BLOCK_SIZE);
+    return true;
+}
+
+void xlat_blockdev_ram_init(struct xlat_blockdev *bd, void *mem, uint32_t block_count)
+{
+    bd->block_count = block_count;
+    bd->read = ram_read;
+    bd->write = ram_write;
+    bd->ctx = mem;
+}
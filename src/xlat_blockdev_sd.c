@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * microSD card on SDMMC1 (4-bit bus), block transfers by DMA.
+ *
+ * The calling task sleeps until the DMA completion interrupt, then until the card
+ * has finished programming. The SDMMC and DMA interrupts are in stm32f7xx_it.c.
+ */
+
+#include <stdio.h>
+
+#include "main.h"
+#include "cmsis_os.h"
+#include "stm32746g_discovery_sd.h"
+
+#include "xlat_blockdev.h"
+
+#define SD_TIMEOUT_MS   1000
+
+static SemaphoreHandle_t sd_done;
+static volatile bool sd_error;
+
+static bool sd_wait(void)
+{
+    if ((xSemaphoreTake(sd_done, pdMS_TO_TICKS(SD_TIMEOUT_MS)) != pdTRUE) || sd_error) {
+        return false;
+    }
+
+    // The DMA is done, the card may still be busy programming
+    TickType_t start = xTaskGetTickCount();
+    while (BSP_SD_GetCardState() != SD_TRANSFER_OK) {
+        if ((xTaskGetTickCount() - start) > pdMS_TO_TICKS(SD_TIMEOUT_MS)) {
+            return false;
+        }
+        osDelay(1);
+    }
+    return true;
+}
+
+static bool sd_read(struct xlat_blockdev *bd, uint32_t lba, void *buf, uint32_t count)
+{
+    (void) bd;
+    uint32_t len = count * XLAT_BLOCK_SIZE;
+
+    // No dirty line may be written back over what the DMA wrote
+    SCB_InvalidateDCache_by_Addr(buf, len);
+    sd_error = false;
+    if (BSP_SD_ReadBlocks_DMA(buf, lba, count) != MSD_OK) {
+        return false;
+    }
+    bool ok = sd_wait();
+    SCB_InvalidateDCache_by_Addr(buf, len);
+    return ok;
+}
+
+static bool sd_write(struct xlat_blockdev *bd, uint32_t lba, const void *buf, uint32_t count)
+{
+    (void) bd;
+
+    SCB_CleanDCache_by_Addr((uint32_t *)buf, count * XLAT_BLOCK_SIZE);
+    sd_error = false;
+    if (BSP_SD_WriteBlocks_DMA((uint32_t *)buf, lba, count) != MSD_OK) {
+        return false;
+    }
+    return sd_wait();
+}
+
+bool xlat_blockdev_sd_init(struct xlat_blockdev *bd)
+{
+    HAL_SD_CardInfoTypeDef info;
+
+    if (sd_done == NULL) {
+        sd_done = xSemaphoreCreateBinary();
+    }
+
+    uint8_t state = BSP_SD_Init();
+    if (state != MSD_OK) {
+        printf("SD: %s\n", (state == MSD_ERROR_SD_NOT_PRESENT) ? "no card" : "init failed");
+        return false;
+    }
+
+    BSP_SD_GetCardInfo(&info);
+    if (info.BlockSize != XLAT_BLOCK_SIZE) {
+        printf("SD: unsupported block size %lu\n", info.BlockSize);
+        return false;
+    }
+
+    bd->block_count = info.BlockNbr;
+    bd->read = sd_read;
+    bd->write = sd_write;
+    bd->ctx = NULL;
+    return true;
+}
+
+// BSP callbacks, from the SDMMC interrupt
+
+void BSP_SD_WriteCpltCallback(void)
+{
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(sd_done, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+void BSP_SD_ReadCpltCallback(void)
+{
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(sd_done, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+void HAL_SD_ErrorCallback(SD_HandleTypeDef *hsd)
+{
+    (void) hsd;
+    BaseType_t woken = pdFALSE;
+    sd_error = true;
+    xSemaphoreGiveFromISR(sd_done, &woken);
+    portYIELD_FROM_ISR(woken);
+}
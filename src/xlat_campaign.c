@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "xlat_campaign.h"
+
+#include "hardware_config.h"
+#include "xlat.h"
+#include "xlat_config.h"
+
+static struct xlat_campaign_segment segments[XLAT_CAMPAIGN_MAX_SEGMENTS];
+static struct xlat_campaign_result results[XLAT_CAMPAIGN_MAX_SEGMENTS];
+static uint8_t segment_count = 0;
+static uint8_t segment_index = 0;
+static uint8_t completed = 0;
+static volatile bool running = false;
+
+// Settings in use before the campaign
+static struct xlat_campaign_segment saved;
+
+static void settings_apply(const struct xlat_campaign_segment *seg)
+{
+    // The interval first, the press duration is limited by it
+    xlat_auto_trigger_interval_ms_set(seg->interval_ms);
+    xlat_auto_trigger_pressed_ms_set(seg->pressed_ms);
+    xlat_gpio_irq_holdoff_us_set(seg->holdoff_us);
+    hw_config_input_trigger_set_edge(seg->rising);
+}
+
+static void campaign_end(void)
+{
+    settings_apply(&saved);
+    running = false;
+}
+
+void xlat_campaign_clear(void)
+{
+    if (running) {
+        return;
+    }
+    segment_count = 0;
+    segment_index = 0;
+    completed = 0;
+}
+
+bool xlat_campaign_segment_add(const struct xlat_campaign_segment *seg)
+{
+    if (running || (segment_count >= XLAT_CAMPAIGN_MAX_SEGMENTS)) {
+        return false;
+    }
+    if ((seg->count == 0) || (seg->interval_ms < 100) || (seg->interval_ms > 1000) ||
+        (seg->pressed_ms < AUTO_TRIGGER_PRESSED_MIN_MS) ||
+        (seg->pressed_ms > seg->interval_ms - AUTO_TRIGGER_PRESSED_MIN_MS)) {
+        return false;
+    }
+
+    segments[segment_count++] = *seg;
+    return true;
+}
+
+uint8_t xlat_campaign_segment_count_get(void)
+{
+    return segment_count;
+}
+
+const struct xlat_campaign_segment *xlat_campaign_segment_get(uint8_t index)
+{
+    return (index < segment_count) ? &segments[index] : NULL;
+}
+
+uint32_t xlat_campaign_start(void)
+{
+    if (running || (segment_count == 0)) {
+        return 0;
+    }
+
+    saved.interval_ms = (uint16_t)xlat_auto_trigger_interval_ms_get();
+    saved.pressed_ms = (uint16_t)xlat_auto_trigger_pressed_ms_get();
+    saved.holdoff_us = xlat_gpio_irq_holdoff_us_get();
+    saved.rising = hw_config_input_trigger_is_rising_edge();
+
+    segment_index = 0;
+    completed = 0;
+    running = true;
+    settings_apply(&segments[0]);
+    return segments[0].count;
+}
+
+uint32_t xlat_campaign_next(void)
+{
+    if (!running) {
+        return 0;
+    }
+
+    // Called before the statistics are reset
+    results[segment_index].count = xlat_latency_count_get(LATENCY_GPIO_TO_USB);
+    results[segment_index].avg_us = xlat_latency_average_get(LATENCY_GPIO_TO_USB);
+    results[segment_index].stdev_us = xlat_latency_standard_deviation_get(LATENCY_GPIO_TO_USB);
+    completed = segment_index + 1;
+
+    if (completed >= segment_count) {
+        campaign_end();
+        return 0;
+    }
+
+    segment_index++;
+    settings_apply(&segments[segment_index]);
+    return segments[segment_index].count;
+}
+
+void xlat_campaign_abort(void)
+{
+    if (running) {
+        campaign_end();
+    }
+}
+
+bool xlat_campaign_running(void)
+{
+    return running;
+}
+
+uint8_t xlat_campaign_segment_index_get(void)
+{
+    return segment_index;
+}
+
+bool xlat_campaign_result_get(uint8_t index, struct xlat_campaign_result *result)
+{
+    if (index >= completed) {
+        return false;
+    }
+    *result = results[index];
+    return true;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef XLAT_CAMPAIGN_H
+#define XLAT_CAMPAIGN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Auto-trigger campaign: a list of segments, run back to back without operator action.
+ *
+ * Every segment has its own press count, interval, press duration, input edge and
+ * holdoff. Each segment is a run of its own: the statistics are reset in between, so
+ * the sample store, the SD log and the USB volume get one run per segment, and the
+ * summary of every segment is kept here. The settings in use before the campaign are
+ * restored once it ends.
+ *
+ * The segment list is edited from the command task while no campaign runs, the
+ * sequencing is driven by the auto-trigger loop of the gfx task.
+ */
+
+#define XLAT_CAMPAIGN_MAX_SEGMENTS  16
+
+struct xlat_campaign_segment {
+    uint32_t count;             // presses
+    uint16_t interval_ms;       // 100-1000
+    uint16_t pressed_ms;        // shorter than the interval
+    uint32_t holdoff_us;
+    bool rising;                // input edge
+};
+
+struct xlat_campaign_result {
+    uint32_t count;
+    uint32_t avg_us;
+    uint32_t stdev_us;
+};
+
+// Segment list, refused while a campaign runs
+void xlat_campaign_clear(void);
+bool xlat_campaign_segment_add(const struct xlat_campaign_segment *seg);
+uint8_t xlat_campaign_segment_count_get(void);
+const struct xlat_campaign_segment *xlat_campaign_segment_get(uint8_t index);
+
+// Sequencing, from the auto-trigger loop. Both return the press count of the segment
+// that starts, after applying its settings, or 0 when there is nothing left to run.
+// The caller resets the statistics after each call.
+uint32_t xlat_campaign_start(void);
+uint32_t xlat_campaign_next(void);
+void xlat_campaign_abort(void);
+
+bool xlat_campaign_running(void);
+uint8_t xlat_campaign_segment_index_get(void);  // the one running, or how far the last campaign got
+bool xlat_campaign_result_get(uint8_t index, struct xlat_campaign_result *result);   // false if it didn't complete
+
+#endif //XLAT_CAMPAIGN_H
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <string.h>
+
+#include "xlat_capture.h"
+
+#ifndef XLAT_CAPTURE_HOST
+#include "main.h"
+extern CRC_HandleTypeDef hcrc;
+#endif
+
+static uint8_t varint_len(uint32_t v)
+{
+    uint8_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static uint8_t *varint_put(uint8_t *p, uint32_t v)
+{
+    while (v >= 0x80) {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+// False on a truncated or over-long varint
+static bool varint_get(const struct xlat_capture_block *blk, uint16_t *pos, uint32_t *v)
+{
+    uint32_t result = 0;
+
+    for (uint8_t shift = 0; (shift < 35) && (*pos < blk->length); shift += 7) {
+        uint8_t b = blk->payload[(*pos)++];
+        result |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *v = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+void xlat_capture_block_init(struct xlat_capture_block *blk, enum xlat_capture_block_type type, uint32_t run)
+{
+    // Unused payload bytes are zero, the same samples always give the same blocks
+    memset(blk, 0, sizeof(*blk));
+    blk->magic = XLAT_CAPTURE_MAGIC;
+    blk->version = XLAT_CAPTURE_VERSION;
+    blk->type = type;
+    blk->run = run;
+}
+
+bool xlat_capture_sample_put(struct xlat_capture_block *blk, uint32_t timestamp_us, uint32_t latency_us, bool quiet)
+{
+    // The 1 MHz counter wraps, deltas are modulo 2^32
+    uint32_t delta = blk->count ? (timestamp_us - blk->last_us) : timestamp_us;
+    uint32_t value = (latency_us << 1) | quiet;
+
+    if ((blk->length + varint_len(delta) + varint_len(value)) > XLAT_CAPTURE_PAYLOAD_SIZE) {
+        return false;
+    }
+
+    uint8_t *p = &blk->payload[blk->length];
+    p = varint_put(p, delta);
+    p = varint_put(p, value);
+    blk->length = (uint16_t)(p - blk->payload);
+    blk->last_us = timestamp_us;
+    blk->count++;
+    return true;
+}
+
+bool xlat_capture_record_put(struct xlat_capture_block *blk, enum xlat_capture_tag tag,
+                             const void *data, uint16_t len)
+{
+    if ((blk->length + 1 + varint_len(len) + len) > XLAT_CAPTURE_PAYLOAD_SIZE) {
+        return false;
+    }
+
+    uint8_t *p = &blk->payload[blk->length];
+    *p++ = (uint8_t)tag;
+    p = varint_put(p, len);
+    memcpy(p, data, len);
+    blk->length = (uint16_t)(p + len - blk->payload);
+    blk->count++;
+    return true;
+}
+
+void xlat_capture_block_seal(struct xlat_capture_block *blk, uint32_t seq)
+{
+    blk->seq = seq;
+    blk->crc = xlat_capture_crc32(blk, offsetof(struct xlat_capture_block, crc));
+}
+
+bool xlat_capture_block_check(const struct xlat_capture_block *blk)
+{
+    return (blk->magic == XLAT_CAPTURE_MAGIC) &&
+           (blk->version == XLAT_CAPTURE_VERSION) &&
+           (blk->length <= XLAT_CAPTURE_PAYLOAD_SIZE) &&
+           (blk->crc == xlat_capture_crc32(blk, offsetof(struct xlat_capture_block, crc)));
+}
+
+bool xlat_capture_sample_next(const struct xlat_capture_block *blk, struct xlat_capture_cursor *cur,
+                              uint32_t *timestamp_us, uint32_t *latency_us, bool *quiet)
+{
+    uint32_t delta;
+    uint32_t value;
+
+    if ((blk->type != XLAT_CAPTURE_BLOCK_SAMPLES) || (cur->index >= blk->count) ||
+        !varint_get(blk, &cur->pos, &delta) || !varint_get(blk, &cur->pos, &value)) {
+        return false;
+    }
+
+    cur->prev_us = cur->index ? (cur->prev_us + delta) : delta;
+    cur->index++;
+    *timestamp_us = cur->prev_us;
+    *latency_us = value >> 1;
+    *quiet = value & 1;
+    return true;
+}
+
+bool xlat_capture_record_next(const struct xlat_capture_block *blk, struct xlat_capture_cursor *cur,
+                              uint8_t *tag, const uint8_t **data, uint16_t *len)
+{
+    uint32_t n;
+
+    if ((blk->type != XLAT_CAPTURE_BLOCK_INFO) || (cur->index >= blk->count) || (cur->pos >= blk->length)) {
+        return false;
+    }
+
+    *tag = blk->payload[cur->pos++];
+    if (!varint_get(blk, &cur->pos, &n) || (n > (uint32_t)(blk->length - cur->pos))) {
+        return false;
+    }
+
+    *data = &blk->payload[cur->pos];
+    *len = (uint16_t)n;
+    cur->pos += n;
+    cur->index++;
+    return true;
+}
+
+#ifdef XLAT_CAPTURE_HOST
+
+// 4 bits at a time
+uint32_t xlat_capture_crc32(const void *data, size_t len)
+{
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    const uint8_t *p = data;
+    uint32_t crc = 0xFFFFFFFF;
+
+    while (len--) {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+#else
+
+// The CRC unit is set up for the reflected CRC-32 in MX_CRC_Init(), only the final XOR is left.
+// The unit is shared by the sdlog and command tasks: a block is fed in one go, with the
+// scheduler suspended (a few us for 512 bytes)
+uint32_t xlat_capture_crc32(const void *data, size_t len)
+{
+    vTaskSuspendAll();
+    uint32_t crc = HAL_CRC_Calculate(&hcrc, (uint32_t *)data, len);
+    xTaskResumeAll();
+    return ~crc;
+}
+
+#endif
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef XLAT_CAPTURE_H
+#define XLAT_CAPTURE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Binary capture format, version 1: how runs are stored on the SD card.
+ * Decode on a PC with tools/xlat_capture_decode.c.
+ *
+ * A capture is a sequence of 512-byte blocks, each with the format version, a sequence
+ * number, the run number and a CRC-32 (zlib), so every block decodes on its own.
+ *
+ * Sample blocks hold one entry per measurement, two unsigned LEB128 varints:
+ *   - timestamp delta to the previous sample of the block in us (the first one is absolute)
+ *   - latency in us << 1 | quiet flag
+ * A sample typically takes 5 bytes, against 8 raw and 20-30 as a CSV line.
+ *
+ * Info blocks are written when a run starts: records of a tag, a varint length and the
+ * data, see enum xlat_capture_tag. A record never spans two blocks, the report descriptor
+ * is split into chunks that carry their offset.
+ */
+
+#define XLAT_CAPTURE_MAGIC          0x50434C58      // "XLCP"
+#define XLAT_CAPTURE_VERSION        1
+#define XLAT_CAPTURE_BLOCK_SIZE     512
+#define XLAT_CAPTURE_HEADER_SIZE    24
+#define XLAT_CAPTURE_PAYLOAD_SIZE   (XLAT_CAPTURE_BLOCK_SIZE - XLAT_CAPTURE_HEADER_SIZE - 4)
+#define XLAT_CAPTURE_DESC_CHUNK     192             // report descriptor bytes per record
+
+enum xlat_capture_block_type {
+    XLAT_CAPTURE_BLOCK_INFO = 1,
+    XLAT_CAPTURE_BLOCK_SAMPLES,
+};
+
+enum xlat_capture_tag {
+    XLAT_CAPTURE_TAG_FIRMWARE = 1,  // firmware version string
+    XLAT_CAPTURE_TAG_DEVICE_DESC,   // USB device descriptor, 18 bytes
+    XLAT_CAPTURE_TAG_MANUFACTURER,  // string
+    XLAT_CAPTURE_TAG_PRODUCT,       // string
+    XLAT_CAPTURE_TAG_SERIAL,        // string
+    XLAT_CAPTURE_TAG_VIDPID,        // string, "vvvv:pppp"
+    XLAT_CAPTURE_TAG_SETTINGS,      // struct xlat_capture_settings
+    XLAT_CAPTURE_TAG_REPORT_DESC,   // uint16_t offset, then up to XLAT_CAPTURE_DESC_CHUNK bytes of the
+                                    // measured interface's report descriptor
+};
+
+struct __attribute__((packed)) xlat_capture_settings {
+    uint8_t mode;                   // enum xlat_mode
+    uint8_t trigger_level_high;
+    uint8_t trigger_output;         // pin 6 or 11
+    uint8_t quiet_mode;
+    uint16_t trigger_interval_ms;
+    uint16_t reserved;
+    uint32_t gpio_irq_holdoff_us;
+    uint16_t button_bits;           // location found in the report descriptor
+    uint16_t motion_bits;
+    uint8_t report_id;
+    uint8_t keyboard_found;
+};
+
+struct xlat_capture_block {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t type;               // enum xlat_capture_block_type
+    uint16_t length;            // payload bytes used
+    uint32_t seq;               // position in the capture
+    uint32_t run;
+    uint16_t count;             // samples or records
+    uint16_t reserved;
+    uint32_t last_us;           // timestamp of the last sample, the encoder's delta base
+    uint8_t payload[XLAT_CAPTURE_PAYLOAD_SIZE];
+    uint32_t crc;               // CRC-32 (zlib) of everything above
+};
+
+_Static_assert(sizeof(struct xlat_capture_block) == XLAT_CAPTURE_BLOCK_SIZE, "capture blocks are 512 bytes");
+_Static_assert(offsetof(struct xlat_capture_block, payload) == XLAT_CAPTURE_HEADER_SIZE, "capture header layout");
+
+// Read position in a block
+struct xlat_capture_cursor {
+    uint16_t pos;
+    uint16_t index;
+    uint32_t prev_us;
+};
+
+// Encoding, nothing is allocated: the caller owns the block
+void xlat_capture_block_init(struct xlat_capture_block *blk, enum xlat_capture_block_type type, uint32_t run);
+bool xlat_capture_sample_put(struct xlat_capture_block *blk, uint32_t timestamp_us, uint32_t latency_us, bool quiet);
+bool xlat_capture_record_put(struct xlat_capture_block *blk, enum xlat_capture_tag tag,
+                             const void *data, uint16_t len);
+void xlat_capture_block_seal(struct xlat_capture_block *blk, uint32_t seq);
+
+// Decoding
+bool xlat_capture_block_check(const struct xlat_capture_block *blk);
+bool xlat_capture_sample_next(const struct xlat_capture_block *blk, struct xlat_capture_cursor *cur,
+                              uint32_t *timestamp_us, uint32_t *latency_us, bool *quiet);
+bool xlat_capture_record_next(const struct xlat_capture_block *blk, struct xlat_capture_cursor *cur,
+                              uint8_t *tag, const uint8_t **data, uint16_t *len);
+
+// CRC-32 as in zlib, on the CRC unit in the firmware (one caller at a time)
+uint32_t xlat_capture_crc32(const void *data, size_t len);
+
+#endif //XLAT_CAPTURE_H
@@ -0,0 +1,737 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xlat_cmd.h"
+
+#include "main.h"
+#include "gfx_main.h"
+#include "hardware_config.h"
+#include "stdio_glue.h"
+#include "usb_task.h"
+#include "xlat.h"
+#include "xlat_autostop.h"
+#include "xlat_campaign.h"
+#include "xlat_capture.h"
+#include "xlat_config.h"
+#include "xlat_diag.h"
+#include "xlat_robust.h"
+#include "xlat_store.h"
+
+#define CMD_TRIGGER_COUNT_MAX       1000000
+#define CMD_HOLDOFF_US_MIN          1000
+#define CMD_HOLDOFF_US_MAX          1000000
+#define CMD_HEX_BYTES_PER_LINE      32
+
+enum cmd_port_id {
+    CMD_PORT_USART1 = 0,
+    CMD_PORT_USART6,
+    CMD_PORT_MAX,
+};
+
+struct cmd_port {
+    UART_HandleTypeDef *huart;
+    IRQn_Type irq;
+    int (*write)(char *ptr);
+    uint8_t rx_byte;
+    bool overflow;
+    size_t line_len;
+    char line[XLAT_CMD_LINE_LEN];
+};
+
+// A command returns NULL when done, or the reason it failed
+struct cmd {
+    const char *name;
+    const char *(*handler)(int argc, char **argv);
+    const char *usage;
+    const char *help;
+};
+
+static struct cmd_port ports[CMD_PORT_MAX] = {
+    [CMD_PORT_USART1] = { .huart = &huart1, .irq = USART1_IRQn, .write = vcp_writestr },
+    [CMD_PORT_USART6] = { .huart = &huart6, .irq = USART6_IRQn, .write = uart6_writestr },
+};
+
+// Received bytes, tagged with the port: (port << 8) | byte
+osMessageQDef(cmdRx, XLAT_CMD_RX_QUEUE_LEN, uint32_t);
+static osMessageQId cmd_rx_queue;
+
+// Only used by the command task, kept off its stack
+static struct cmd_port *reply_port;
+static char reply_buf[XLAT_CMD_LINE_LEN + 8];
+static struct xlat_run runs[XLAT_STORE_MAX_RUNS];
+static struct xlat_capture_block capture_blk;
+
+static const char *const mode_names[] = { "click", "motion", "key" };    // enum xlat_mode
+static const char *const edge_names[] = { "falling", "rising" };
+static const char *const bias_names[] = { "none", "up", "down" };       // input_bias_t
+static const char *const level_names[] = { "low", "high" };
+static const char *const onoff_names[] = { "off", "on" };
+
+#define NAME_GET(names, i)  (((size_t)(i) < (sizeof(names) / sizeof((names)[0]))) ? (names)[(i)] : "?")
+
+static void reply(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+static void reply(const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(reply_buf + 1, sizeof(reply_buf) - 2, fmt, args);
+    va_end(args);
+
+    if (len < 0) {
+        return;
+    }
+    if ((size_t)len > sizeof(reply_buf) - 3) {
+        len = sizeof(reply_buf) - 3;
+    }
+    reply_buf[0] = '>';
+    reply_buf[len + 1] = '\n';
+    reply_buf[len + 2] = '\0';
+    reply_port->write(reply_buf);
+}
+
+static int name_lookup(const char *const *names, size_t count, const char *name)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (!strcmp(names[i], name)) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+#define NAME_LOOKUP(names, name)    name_lookup((names), sizeof(names) / sizeof((names)[0]), (name))
+
+static bool number_parse(const char *str, uint32_t min, uint32_t max, uint32_t *value)
+{
+    char *end;
+    unsigned long v = strtoul(str, &end, 0);
+
+    if ((end == str) || (*end != '\0') || (v < min) || (v > max)) {
+        return false;
+    }
+    *value = (uint32_t)v;
+    return true;
+}
+
+// "5" or "5.5", in tenths
+static bool tenths_parse(const char *str, uint32_t min, uint32_t max, uint32_t *value)
+{
+    char *end;
+    unsigned long v = strtoul(str, &end, 10) * 10;
+
+    if (end == str) {
+        return false;
+    }
+    if ((end[0] == '.') && (end[1] >= '0') && (end[1] <= '9')) {
+        v += end[1] - '0';
+        end += 2;
+    }
+    if ((*end != '\0') || (v < min) || (v > max)) {
+        return false;
+    }
+    *value = (uint32_t)v;
+    return true;
+}
+
+static const struct xlat_run *run_find(uint32_t number)
+{
+    uint8_t count = xlat_store_runs_get(runs, XLAT_STORE_MAX_RUNS);
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (runs[i].number == number) {
+            return &runs[i];
+        }
+    }
+    return NULL;
+}
+
+static void hex_reply(const uint8_t *data, size_t len)
+{
+    static const char digits[] = "0123456789abcdef";
+    char hex[CMD_HEX_BYTES_PER_LINE * 2 + 1];
+
+    while (len) {
+        size_t n = (len > CMD_HEX_BYTES_PER_LINE) ? CMD_HEX_BYTES_PER_LINE : len;
+        for (size_t i = 0; i < n; i++) {
+            hex[2 * i] = digits[data[i] >> 4];
+            hex[2 * i + 1] = digits[data[i] & 0x0F];
+        }
+        hex[2 * n] = '\0';
+        reply("%s", hex);
+        data += n;
+        len -= n;
+    }
+}
+
+static const char *cmd_help(int argc, char **argv);
+
+static const char *cmd_status(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    reply("device %s %s (%s)", usb_host_get_manuf_string(), usb_host_get_product_string(),
+          usb_host_get_vidpid_string());
+    reply("firmware %s", APP_VERSION_FULL);
+    reply("trigger_remaining %lu", gfx_trigger_remaining_get());
+    if (xlat_campaign_running()) {
+        reply("campaign segment %u of %u", xlat_campaign_segment_index_get() + 1, xlat_campaign_segment_count_get());
+    } else {
+        reply("campaign off");
+    }
+    return NULL;
+}
+
+static const char *cmd_get(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    reply("mode %s", NAME_GET(mode_names, xlat_mode_get()));
+    reply("edge %s", NAME_GET(edge_names, hw_config_input_trigger_is_rising_edge()));
+    reply("bias %s", NAME_GET(bias_names, hw_config_input_bias_get()));
+    reply("holdoff_us %lu", xlat_gpio_irq_holdoff_us_get());
+    reply("interval_ms %lu", xlat_auto_trigger_interval_ms_get());
+    reply("pressed_ms %lu", xlat_auto_trigger_pressed_ms_get());
+    reply("level %s", NAME_GET(level_names, xlat_auto_trigger_level_is_high()));
+    reply("output %u", xlat_auto_trigger_output_get());
+    reply("quiet %s", NAME_GET(onoff_names, xlat_quiet_mode_is_enabled()));
+    reply("outlier_k %u.%u", xlat_robust_k_x10_get() / 10, xlat_robust_k_x10_get() % 10);
+
+    struct xlat_autostop_config autostop;
+    xlat_autostop_config_get(&autostop);
+    reply("autostop %s", NAME_GET(onoff_names, autostop.enabled));
+    reply("autostop_level %u", autostop.level_pct);
+    reply("autostop_mean_us %lu", autostop.mean_half_width_us);
+    reply("autostop_p99_us %lu", autostop.p99_half_width_us);
+    reply("autostop_min %lu", autostop.min_samples);
+    reply("autostop_max %lu", autostop.max_samples);
+    return NULL;
+}
+
+// Run length, see xlat_autostop.h
+static const char *autostop_set(const char *name, const char *value)
+{
+    struct xlat_autostop_config cfg;
+    uint32_t number;
+    int i;
+
+    xlat_autostop_config_get(&cfg);
+
+    if (!strcmp(name, "autostop")) {
+        if ((i = NAME_LOOKUP(onoff_names, value)) < 0) {
+            return "autostop: off or on";
+        }
+        cfg.enabled = i;
+    } else if (!strcmp(name, "autostop_level")) {
+        if (!number_parse(value, 90, 99, &number) || ((number != 90) && (number != 95) && (number != 99))) {
+            return "autostop_level: 90, 95 or 99";
+        }
+        cfg.level_pct = (uint8_t)number;
+    } else if (!strcmp(name, "autostop_mean_us")) {
+        if (!number_parse(value, 1, UINT32_MAX, &number)) {
+            return "autostop_mean_us: at least 1";
+        }
+        cfg.mean_half_width_us = number;
+    } else if (!strcmp(name, "autostop_p99_us")) {
+        if (!number_parse(value, 0, UINT32_MAX, &number)) {
+            return "autostop_p99_us: 0 (off) or more";
+        }
+        cfg.p99_half_width_us = number;
+    } else if (!strcmp(name, "autostop_min")) {
+        if (!number_parse(value, 2, CMD_TRIGGER_COUNT_MAX, &number)) {
+            return "autostop_min: 2 to 1000000";
+        }
+        cfg.min_samples = number;
+    } else if (!strcmp(name, "autostop_max")) {
+        if (!number_parse(value, 2, CMD_TRIGGER_COUNT_MAX, &number)) {
+            return "autostop_max: 2 to 1000000";
+        }
+        cfg.max_samples = number;
+    } else {
+        return "unknown setting, see 'get'";
+    }
+
+    if (!xlat_autostop_config_set(&cfg)) {
+        return "autostop_min must not be above autostop_max";
+    }
+    return NULL;
+}
+
+static const char *cmd_set(int argc, char **argv)
+{
+    if (argc != 3) {
+        return "usage: set <name> <value>";
+    }
+
+    const char *name = argv[1];
+    const char *value = argv[2];
+    gfx_event_t changed = GFX_EVENT_SETTINGS_CHANGED;
+    const char *err = NULL;
+    uint32_t number;
+    int i;
+
+    if (!strcmp(name, "mode")) {
+        if ((i = NAME_LOOKUP(mode_names, value)) < 0) {
+            return "mode: click, motion or key";
+        }
+        xlat_mode_set((enum xlat_mode)i);
+        changed = GFX_EVENT_MODE_CHANGED;
+    } else if (!strcmp(name, "edge")) {
+        if ((i = NAME_LOOKUP(edge_names, value)) < 0) {
+            return "edge: falling or rising";
+        }
+        hw_config_input_trigger_set_edge(i);
+    } else if (!strcmp(name, "bias")) {
+        if ((i = NAME_LOOKUP(bias_names, value)) < 0) {
+            return "bias: none, up or down";
+        }
+        hw_config_input_bias((input_bias_t)i);
+    } else if (!strcmp(name, "holdoff_us")) {
+        if (!number_parse(value, CMD_HOLDOFF_US_MIN, CMD_HOLDOFF_US_MAX, &number)) {
+            return "holdoff_us: 1000 to 1000000";
+        }
+        xlat_gpio_irq_holdoff_us_set(number);
+    } else if (!strcmp(name, "interval_ms")) {
+        if (!number_parse(value, 100, 1000, &number)) {
+            return "interval_ms: 100 to 1000";
+        }
+        xlat_auto_trigger_interval_ms_set(number);
+    } else if (!strcmp(name, "pressed_ms")) {
+        if (!number_parse(value, AUTO_TRIGGER_PRESSED_MIN_MS,
+                          xlat_auto_trigger_interval_ms_get() - AUTO_TRIGGER_PRESSED_MIN_MS, &number)) {
+            return "pressed_ms: 10 ms to the interval - 10 ms";
+        }
+        xlat_auto_trigger_pressed_ms_set(number);
+    } else if (!strcmp(name, "level")) {
+        if ((i = NAME_LOOKUP(level_names, value)) < 0) {
+            return "level: low or high";
+        }
+        xlat_auto_trigger_level_set(i);
+    } else if (!strcmp(name, "output")) {
+        if (!number_parse(value, 6, 11, &number) || ((number != 6) && (number != 11))) {
+            return "output: 6 or 11";
+        }
+        xlat_auto_trigger_output_set((uint8_t)number);
+    } else if (!strcmp(name, "quiet")) {
+        if ((i = NAME_LOOKUP(onoff_names, value)) < 0) {
+            return "quiet: off or on";
+        }
+        xlat_quiet_mode_set(i);
+    } else if (!strcmp(name, "outlier_k")) {
+        if (!tenths_parse(value, 10, 1000, &number)) {
+            return "outlier_k: 1.0 to 100.0";
+        }
+        xlat_robust_k_x10_set((uint16_t)number);
+    } else if (!strncmp(name, "autostop", 8)) {
+        if ((err = autostop_set(name, value)) != NULL) {
+            return err;
+        }
+    } else {
+        return "unknown setting, see 'get'";
+    }
+
+    // The setting is applied either way, only the display may be out of date
+    if (!gfx_event_send(changed, 0)) {
+        return "busy, set but not shown on the display";
+    }
+    return NULL;
+}
+
+static const char *cmd_trigger(int argc, char **argv)
+{
+    uint32_t count = xlat_autostop_run_length_get();
+
+    if ((argc > 1) && !number_parse(argv[1], 1, CMD_TRIGGER_COUNT_MAX, &count)) {
+        return "count: 1 to 1000000";
+    }
+    if (gfx_trigger_running_get()) {
+        return "busy, 'stop' first";
+    }
+    if (!gfx_event_send(GFX_EVENT_TRIGGER_START, (int32_t)count)) {
+        return "busy";
+    }
+    return NULL;
+}
+
+static const char *campaign_add(int argc, char **argv)
+{
+    struct xlat_campaign_segment seg;
+    uint32_t interval, pressed;
+    int rising;
+
+    if (argc != 7) {
+        return "usage: campaign add <count> <interval_ms> <pressed_ms> <edge> <holdoff_us>";
+    }
+    if (!number_parse(argv[2], 1, CMD_TRIGGER_COUNT_MAX, &seg.count)) {
+        return "count: 1 to 1000000";
+    }
+    if (!number_parse(argv[3], 100, 1000, &interval)) {
+        return "interval_ms: 100 to 1000";
+    }
+    if (!number_parse(argv[4], AUTO_TRIGGER_PRESSED_MIN_MS, interval - AUTO_TRIGGER_PRESSED_MIN_MS, &pressed)) {
+        return "pressed_ms: 10 ms to the interval - 10 ms";
+    }
+    if ((rising = NAME_LOOKUP(edge_names, argv[5])) < 0) {
+        return "edge: falling or rising";
+    }
+    if (!number_parse(argv[6], CMD_HOLDOFF_US_MIN, CMD_HOLDOFF_US_MAX, &seg.holdoff_us)) {
+        return "holdoff_us: 1000 to 1000000";
+    }
+    seg.interval_ms = (uint16_t)interval;
+    seg.pressed_ms = (uint16_t)pressed;
+    seg.rising = rising;
+
+    if (!xlat_campaign_segment_add(&seg)) {
+        return xlat_campaign_running() ? "busy, 'stop' first" : "too many segments";
+    }
+    return NULL;
+}
+
+static const char *cmd_campaign(int argc, char **argv)
+{
+    if ((argc < 2) || !strcmp(argv[1], "show")) {
+        // Segments with the results of the ones that completed
+        reply("segment,count,interval_ms,pressed_ms,edge,holdoff_us,done,n,avg_us,stdev_us");
+        for (uint8_t i = 0; i < xlat_campaign_segment_count_get(); i++) {
+            const struct xlat_campaign_segment *seg = xlat_campaign_segment_get(i);
+            struct xlat_campaign_result result = { 0 };
+            bool done = xlat_campaign_result_get(i, &result);
+            reply("%u,%lu,%u,%u,%s,%lu,%u,%lu,%lu,%lu", i + 1, seg->count, seg->interval_ms, seg->pressed_ms,
+                  NAME_GET(edge_names, seg->rising), seg->holdoff_us, done, result.count, result.avg_us,
+                  result.stdev_us);
+        }
+        return NULL;
+    }
+
+    if (!strcmp(argv[1], "add")) {
+        return campaign_add(argc, argv);
+    } else if (!strcmp(argv[1], "clear")) {
+        if (xlat_campaign_running()) {
+            return "busy, 'stop' first";
+        }
+        xlat_campaign_clear();
+    } else if (!strcmp(argv[1], "start")) {
+        if (gfx_trigger_running_get()) {
+            return "busy, 'stop' first";
+        }
+        if (!xlat_campaign_segment_count_get()) {
+            return "no segments, see 'campaign add'";
+        }
+        if (!gfx_event_send(GFX_EVENT_CAMPAIGN_START, 0)) {
+            return "busy";
+        }
+    } else {
+        return "usage: campaign [show|add|clear|start]";
+    }
+    return NULL;
+}
+
+static const char *cmd_stop(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+    if (!gfx_event_send(GFX_EVENT_TRIGGER_STOP, 0)) {
+        return "busy";
+    }
+    return NULL;
+}
+
+static const char *cmd_clear(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+    if (!gfx_event_send(GFX_EVENT_CLEAR, 0)) {
+        return "busy";
+    }
+    return NULL;
+}
+
+static const char *cmd_stats(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    reply("count %lu", xlat_latency_count_get(LATENCY_GPIO_TO_USB));
+    reply("avg_us %lu", xlat_latency_average_get(LATENCY_GPIO_TO_USB));
+    reply("stdev_us %lu", xlat_latency_standard_deviation_get(LATENCY_GPIO_TO_USB));
+    reply("last_us %lu", xlat_last_latency_us_get(LATENCY_GPIO_TO_USB));
+    reply("hid_event_drops %lu", xlat_hid_event_drop_count_get());
+    reply("median_us %lu", xlat_robust_median_get());
+    reply("mad_us %lu", xlat_robust_mad_get());
+    reply("outliers %lu", xlat_robust_outlier_count_get());
+    reply("excl_count %lu", xlat_robust_inlier_count_get());
+    reply("excl_avg_us %lu", xlat_robust_inlier_average_get());
+    reply("excl_stdev_us %lu", xlat_robust_inlier_standard_deviation_get());
+
+    struct xlat_autostop_status autostop;
+    xlat_autostop_check(&autostop);
+    reply("mean_ci_us %lu", autostop.mean_half_width_us);
+    reply("p99_ci_us %lu %lu", autostop.p99_low_us, autostop.p99_high_us);
+    return NULL;
+}
+
+static const char *cmd_runs(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    uint8_t count = xlat_store_runs_get(runs, XLAT_STORE_MAX_RUNS);
+
+    reply("run,count,mode,avg_us,stdev_us,min_us,max_us");
+    for (uint8_t i = 0; i < count; i++) {
+        reply("%lu,%lu,%s,%lu,%lu,%lu,%lu", runs[i].number, runs[i].count, NAME_GET(mode_names, runs[i].mode),
+              runs[i].avg_us, runs[i].stdev_us, runs[i].min_us, runs[i].max_us);
+    }
+    return NULL;
+}
+
+static const char *cmd_samples(int argc, char **argv)
+{
+    uint32_t number, first = 0, count = UINT32_MAX;
+
+    if ((argc < 2) || !number_parse(argv[1], 1, UINT32_MAX, &number)) {
+        return "usage: samples <run> [first] [count]";
+    }
+    if ((argc > 2) && !number_parse(argv[2], 0, UINT32_MAX, &first)) {
+        return "bad first";
+    }
+    if ((argc > 3) && !number_parse(argv[3], 1, UINT32_MAX, &count)) {
+        return "bad count";
+    }
+
+    const struct xlat_run *run = run_find(number);
+    if (run == NULL) {
+        return "no such run, see 'runs'";
+    }
+    if (first >= run->count) {
+        return "first is past the end of the run";
+    }
+    if (count > run->count - first) {
+        count = run->count - first;
+    }
+
+    reply("index,timestamp_us,latency_us,quiet,outlier");
+    for (uint32_t i = first; i < first + count; i++) {
+        struct xlat_sample s;
+        if (!xlat_store_sample_get(run->first + i, &s)) {
+            return "overwritten";
+        }
+        reply("%lu,%lu,%lu,%u,%u", i, s.timestamp_us, (uint32_t)s.latency_us, (unsigned)s.quiet, (unsigned)s.outlier);
+    }
+    return NULL;
+}
+
+static const char *cmd_capture(int argc, char **argv)
+{
+    uint32_t number;
+
+    if ((argc < 2) || !number_parse(argv[1], 1, UINT32_MAX, &number)) {
+        return "usage: capture <run>";
+    }
+
+    const struct xlat_run *run = run_find(number);
+    if (run == NULL) {
+        return "no such run, see 'runs'";
+    }
+
+    // One block is XLAT_CAPTURE_BLOCK_SIZE / CMD_HEX_BYTES_PER_LINE lines, numbered from 0
+    uint32_t seq = 0;
+    xlat_capture_block_init(&capture_blk, XLAT_CAPTURE_BLOCK_SAMPLES, run->number);
+    for (uint32_t i = 0; i < run->count; i++) {
+        struct xlat_sample s;
+        if (!xlat_store_sample_get(run->first + i, &s)) {
+            return "overwritten";
+        }
+        if (!xlat_capture_sample_put(&capture_blk, s.timestamp_us, s.latency_us, s.quiet)) {
+            xlat_capture_block_seal(&capture_blk, seq++);
+            hex_reply((const uint8_t *)&capture_blk, sizeof(capture_blk));
+            xlat_capture_block_init(&capture_blk, XLAT_CAPTURE_BLOCK_SAMPLES, run->number);
+            xlat_capture_sample_put(&capture_blk, s.timestamp_us, s.latency_us, s.quiet);
+        }
+    }
+    if (capture_blk.count) {
+        xlat_capture_block_seal(&capture_blk, seq);
+        hex_reply((const uint8_t *)&capture_blk, sizeof(capture_blk));
+    }
+    return NULL;
+}
+
+static const char *cmd_diag(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    xlat_diag_update();
+    const struct xlat_diag *diag = xlat_diag_get();
+
+    reply("period_ms %lu", diag->period_us / 1000);
+    for (uint8_t i = 0; i < diag->task_count; i++) {
+        reply("task %s cpu_permille %u stack_free %lu", diag->tasks[i].name, diag->tasks[i].cpu_permille,
+              diag->tasks[i].stack_free_min);
+    }
+    reply("heap_free %u min %u", diag->heap_free, diag->heap_free_min);
+    reply("drops hid %lu log %lu trace %lu cdc %lu sdlog %lu", diag->hid_event_drops, diag->log_overruns,
+          diag->trace_drops, diag->cdc_drops, diag->sdlog_drops);
+    return NULL;
+}
+
+static const struct cmd cmds[] = {
+    { "help",     cmd_help,     "help",                          "this list" },
+    { "status",   cmd_status,   "status",                        "device, firmware and auto-trigger state" },
+    { "get",      cmd_get,      "get",                           "all settings" },
+    { "set",      cmd_set,      "set <name> <value>",            "change a setting, names as in 'get'" },
+    { "trigger",  cmd_trigger,  "trigger [count]",               "start an auto-trigger run (default 1000, or autostop_max)" },
+    { "stop",     cmd_stop,     "stop",                          "stop the auto-trigger run or campaign" },
+    { "clear",    cmd_clear,    "clear",                         "reset the statistics, completes the run" },
+    { "campaign", cmd_campaign, "campaign [show]",               "segments of the campaign, with results" },
+    { "campaign", cmd_campaign, "campaign add <count> <interval_ms> <pressed_ms> <edge> <holdoff_us>",
+      "append a segment" },
+    { "campaign", cmd_campaign, "campaign clear|start",          "remove all segments, or run them in a row" },
+    { "stats",    cmd_stats,    "stats",                         "statistics of the current run" },
+    { "runs",     cmd_runs,     "runs",                          "completed runs still in memory" },
+    { "samples",  cmd_samples,  "samples <run> [first] [count]", "samples of a completed run, as CSV" },
+    { "capture",  cmd_capture,  "capture <run>",                 "samples of a completed run, as capture blocks" },
+    { "diag",     cmd_diag,     "diag",                          "CPU load, stack and heap since the last 'diag'" },
+};
+
+static const char *cmd_help(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    for (size_t i = 0; i < sizeof(cmds) / sizeof(cmds[0]); i++) {
+        reply("%-30s %s", cmds[i].usage, cmds[i].help);
+    }
+    return NULL;
+}
+
+static void line_process(struct cmd_port *port)
+{
+    char *argv[XLAT_CMD_MAX_ARGS + 1];
+    int argc = 0;
+    char *save;
+    const char *tag = NULL;
+    const char *err;
+
+    reply_port = port;
+
+    for (char *tok = strtok_r(port->line, " \t", &save); tok; tok = strtok_r(NULL, " \t", &save)) {
+        if ((argc == 0) && (tag == NULL) && (tok[0] == '@')) {
+            tag = tok;
+        } else if (argc < XLAT_CMD_MAX_ARGS + 1) {
+            argv[argc++] = tok;
+        }
+    }
+
+    if (port->overflow) {
+        err = "line too long";
+    } else if (argc == 0) {
+        err = "empty";
+    } else if (argc > XLAT_CMD_MAX_ARGS) {
+        err = "too many arguments";
+    } else {
+        err = "unknown command, see 'help'";
+        for (size_t i = 0; i < sizeof(cmds) / sizeof(cmds[0]); i++) {
+            if (!strcmp(argv[0], cmds[i].name)) {
+                err = cmds[i].handler(argc, argv);
+                break;
+            }
+        }
+    }
+
+    if (err) {
+        reply("err %s%s%s", err, tag ? " " : "", tag ? tag : "");
+    } else {
+        reply("ok%s%s", tag ? " " : "", tag ? tag : "");
+    }
+}
+
+static void rx_char(struct cmd_port *port, char c)
+{
+    if ((c == '\r') || (c == '\n')) {
+        // A CRLF ends one line, not two
+        if (port->line_len || port->overflow) {
+            port->line[port->line_len] = '\0';
+            line_process(port);
+        }
+        port->line_len = 0;
+        port->overflow = false;
+    } else if (port->line_len < (XLAT_CMD_LINE_LEN - 1)) {
+        port->line[port->line_len++] = c;
+    } else {
+        port->overflow = true;
+    }
+}
+
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+    for (uint32_t i = 0; i < CMD_PORT_MAX; i++) {
+        if (huart == ports[i].huart) {
+            osMessagePut(cmd_rx_queue, (i << 8) | ports[i].rx_byte, 0);
+            HAL_UART_Receive_IT(huart, &ports[i].rx_byte, 1);
+        }
+    }
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    // Overrun or framing error: drop the byte and keep receiving
+    for (uint32_t i = 0; i < CMD_PORT_MAX; i++) {
+        if (huart == ports[i].huart) {
+            HAL_UART_Receive_IT(huart, &ports[i].rx_byte, 1);
+        }
+    }
+}
+
+
+// PUBLIC FUNCTIONS
+
+void xlat_cmd_init(void)
+{
+    cmd_rx_queue = osMessageCreate(osMessageQ(cmdRx), NULL);
+
+    for (uint32_t i = 0; i < CMD_PORT_MAX; i++) {
+        // Below configMAX_SYSCALL_INTERRUPT_PRIORITY, and below the button EXTI
+        HAL_NVIC_SetPriority(ports[i].irq, 6, 0);
+        HAL_NVIC_EnableIRQ(ports[i].irq);
+        HAL_UART_Receive_IT(ports[i].huart, &ports[i].rx_byte, 1);
+    }
+}
+
+void xlat_cmd_task(void const * argument)
+{
+    (void)argument;
+
+    while (!xlat_initialized) {
+        osDelay(1);
+    }
+
+    while (1) {
+        osEvent evt = osMessageGet(cmd_rx_queue, osWaitForever);
+        if (evt.status == osEventMessage) {
+            rx_char(&ports[evt.value.v >> 8], (char)(evt.value.v & 0xFF));
+        }
+    }
+}
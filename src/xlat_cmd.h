@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef XLAT_CMD_H
+#define XLAT_CMD_H
+
+/*
+ * Serial command interface, for host scripts driving measurement campaigns.
+ *
+ * Line based, on USART1 (ST-LINK VCP) and USART6 (Arduino D0/D1), 115200 8N1:
+ *
+ *     [@tag] <command> [args...]\n
+ *
+ * Every reply line starts with '>', the last one is ">ok" or ">err <reason>", followed
+ * by " @tag" when the command was tagged. Anything else on USART1 (measurement CSV,
+ * '#' comments) is asynchronous output and can be skipped by the host.
+ * Send "help" for the list of commands.
+ *
+ * Samples come either as text or as capture blocks (see xlat_capture.h) in hex,
+ * 32 bytes per line; "xxd -r -p" turns these into a file for tools/xlat_capture_decode.
+ */
+
+#define XLAT_CMD_LINE_LEN       96
+#define XLAT_CMD_MAX_ARGS       8
+#define XLAT_CMD_RX_QUEUE_LEN   128
+
+// Before the scheduler starts
+void xlat_cmd_init(void);
+void xlat_cmd_task(void const * argument);
+
+#endif //XLAT_CMD_H
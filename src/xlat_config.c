@@ -22,16 +22,18 @@
 #include <stdio.h>
 
 // Configuration state
-static enum xlat_mode current_mode = XLAT_MODE_MOUSE_CLICK;
+XLAT_DTCM_DATA static enum xlat_mode current_mode = XLAT_MODE_MOUSE_CLICK;
 static bool auto_trigger_level_high = true;
 static uint32_t auto_trigger_interval_ms = 300;
+static uint32_t auto_trigger_pressed_ms = AUTO_TRIGGER_PRESSED_PERIOD_MS;
 static uint8_t auto_trigger_output_pin = 11;
+static bool quiet_mode = false;
 
-uint8_t button_mask[REPORT_LEN];
-uint8_t motion_mask[REPORT_LEN];
+XLAT_DTCM_BSS uint8_t button_mask[REPORT_LEN];
+XLAT_DTCM_BSS uint8_t motion_mask[REPORT_LEN];
 uint16_t button_bits;
 uint16_t motion_bits;
-uint8_t report_id;
+XLAT_DTCM_BSS uint8_t report_id;
 bool keyboard_usage_page_found = false;
 
 // The Razer optical switches will constantly trigger the GPIO interrupt, while pressed
@@ -43,7 +45,7 @@ bool keyboard_usage_page_found = false;
 //
 // Therefore, take a large enough time window to debounce the GPIO interrupt.
 #define GPIO_IRQ_HOLDOFF_US (100 * 1000)  // 100ms;
-static uint32_t gpio_irq_holdoff_us = GPIO_IRQ_HOLDOFF_US;
+XLAT_DTCM_DATA static uint32_t gpio_irq_holdoff_us = GPIO_IRQ_HOLDOFF_US;
 
 // Mode configuration
 void xlat_mode_set(enum xlat_mode mode)
@@ -51,7 +53,7 @@ void xlat_mode_set(enum xlat_mode mode)
     current_mode = mode;
 }
 
-enum xlat_mode xlat_mode_get(void)
+XLAT_ITCM_FUNC enum xlat_mode xlat_mode_get(void)
 {
     return current_mode;
 }
@@ -83,6 +85,24 @@ uint32_t xlat_auto_trigger_interval_ms_get(void)
     return auto_trigger_interval_ms;
 }
 
+// Auto-trigger press duration configuration
+void xlat_auto_trigger_pressed_ms_set(uint32_t ms)
+{
+    if (ms < AUTO_TRIGGER_PRESSED_MIN_MS) {
+        ms = AUTO_TRIGGER_PRESSED_MIN_MS;
+    }
+    auto_trigger_pressed_ms = ms;
+}
+
+uint32_t xlat_auto_trigger_pressed_ms_get(void)
+{
+    // The button is always released before the next press
+    if (auto_trigger_pressed_ms > auto_trigger_interval_ms - AUTO_TRIGGER_PRESSED_MIN_MS) {
+        return auto_trigger_interval_ms - AUTO_TRIGGER_PRESSED_MIN_MS;
+    }
+    return auto_trigger_pressed_ms;
+}
+
 // Auto-trigger output configuration
 void xlat_auto_trigger_output_set(uint8_t pin)
 {
@@ -97,6 +117,17 @@ uint8_t xlat_auto_trigger_output_get(void)
     return auto_trigger_output_pin;
 } 
 
+// Quiet mode configuration
+void xlat_quiet_mode_set(bool enable)
+{
+    quiet_mode = enable;
+}
+
+bool xlat_quiet_mode_is_enabled(void)
+{
+    return quiet_mode;
+}
+
 
 void xlat_gpio_irq_holdoff_us_set(uint32_t us)
 {
@@ -104,7 +135,7 @@ void xlat_gpio_irq_holdoff_us_set(uint32_t us)
 }
 
 
-uint32_t xlat_gpio_irq_holdoff_us_get(void)
+XLAT_ITCM_FUNC uint32_t xlat_gpio_irq_holdoff_us_get(void)
 {
     return gpio_irq_holdoff_us;
 }
@@ -119,16 +150,16 @@ uint16_t * xlat_motion_bits_get(void)
     return &motion_bits;
 }
 
-uint8_t * xlat_button_mask_get(void)
+XLAT_ITCM_FUNC uint8_t * xlat_button_mask_get(void)
 {
     return button_mask;
 }
 
-uint8_t * xlat_motion_mask_get(void)
+XLAT_ITCM_FUNC uint8_t * xlat_motion_mask_get(void)
 {
     return motion_mask;
 }
-uint8_t xlat_report_id_get(void)
+XLAT_ITCM_FUNC uint8_t xlat_report_id_get(void)
 {
     return report_id;
 }
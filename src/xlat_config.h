@@ -58,6 +58,18 @@ void xlat_auto_trigger_interval_ms_set(uint32_t ms);
  */
 uint32_t xlat_auto_trigger_interval_ms_get(void);
 
+/**
+ * @brief Set how long the auto-trigger holds the button down
+ * @param ms The press duration in milliseconds, at least AUTO_TRIGGER_PRESSED_MIN_MS
+ */
+void xlat_auto_trigger_pressed_ms_set(uint32_t ms);
+
+/**
+ * @brief Get the auto-trigger press duration
+ * @return The press duration in milliseconds, always shorter than the interval
+ */
+uint32_t xlat_auto_trigger_pressed_ms_get(void);
+
 /**
  * @brief Set the auto-trigger output pin
  * @param pin The pin number (6 or 11)
@@ -70,6 +82,18 @@ void xlat_auto_trigger_output_set(uint8_t pin);
  */
 uint8_t xlat_auto_trigger_output_get(void);
 
+/**
+ * @brief Enable or disable the quiet mode for auto-trigger runs
+ * @param enable true to pause the GUI while waiting for each report
+ */
+void xlat_quiet_mode_set(bool enable);
+
+/**
+ * @brief Get the quiet mode setting
+ * @return true if the GUI is paused while waiting for each report
+ */
+bool xlat_quiet_mode_is_enabled(void);
+
 /**
  * @brief Set the GPIO IRQ holdoff time
  * @param us The holdoff time in microseconds
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "main.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "xlat.h"
+#include "xlat_diag.h"
+#include "xlat_log.h"
+#include "xlat_trace.h"
+#include "stdio_glue.h"
+#include "usb_device.h"
+#include "usb_proxy.h"
+#include "xlat_sdlog.h"
+
+_Static_assert(XLAT_DIAG_TASK_NAME_LEN >= configMAX_TASK_NAME_LEN, "task names don't fit");
+
+static const char * const isr_names[XLAT_DIAG_ISR_MAX] = {
+    [XLAT_DIAG_ISR_EXTI] = "EXTI15_10",
+    [XLAT_DIAG_ISR_OTG_HS] = "OTG_HS",
+};
+
+volatile uint32_t xlat_diag_isr_cycles[XLAT_DIAG_ISR_MAX];
+
+static struct xlat_diag diag;
+
+// Counters at the previous update, the CPU load is computed over the interval in between
+static TaskStatus_t task_status[XLAT_DIAG_MAX_TASKS];
+static uint32_t prev_task_number[XLAT_DIAG_MAX_TASKS];
+static uint32_t prev_task_runtime[XLAT_DIAG_MAX_TASKS];
+static uint8_t prev_task_count = 0;
+static uint32_t prev_total_runtime = 0;
+static uint32_t prev_isr_cycles[XLAT_DIAG_ISR_MAX];
+
+static uint32_t prev_runtime_get(uint32_t task_number)
+{
+    for (uint8_t i = 0; i < prev_task_count; i++) {
+        if (prev_task_number[i] == task_number) {
+            return prev_task_runtime[i];
+        }
+    }
+    return 0;
+}
+
+void xlat_diag_init(void)
+{
+    // Enable the DWT cycle counter for the interrupt timing
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55; // unlock DWT access on the Cortex-M7
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+void xlat_diag_update(void)
+{
+    uint32_t total_runtime;
+    UBaseType_t count = uxTaskGetSystemState(task_status, XLAT_DIAG_MAX_TASKS, &total_runtime);
+
+    // Both counters wrap, unsigned deltas are fine as long as updates are less than ~70 minutes apart
+    uint32_t period = total_runtime - prev_total_runtime;
+    prev_total_runtime = total_runtime;
+    diag.period_us = period;
+
+    diag.task_count = (uint8_t)count;
+    for (UBaseType_t i = 0; i < count; i++) {
+        TaskStatus_t *ts = &task_status[i];
+        struct xlat_diag_task *task = &diag.tasks[i];
+
+        strncpy(task->name, ts->pcTaskName, sizeof(task->name) - 1);
+        task->name[sizeof(task->name) - 1] = '\0';
+        task->stack_free_min = ts->usStackHighWaterMark * sizeof(StackType_t);
+
+        uint32_t runtime = ts->ulRunTimeCounter - prev_runtime_get(ts->xTaskNumber);
+        task->cpu_permille = period ? (uint16_t)((uint64_t)runtime * 1000 / period) : 0;
+    }
+    for (UBaseType_t i = 0; i < count; i++) {
+        prev_task_number[i] = task_status[i].xTaskNumber;
+        prev_task_runtime[i] = task_status[i].ulRunTimeCounter;
+    }
+    prev_task_count = (uint8_t)count;
+
+    uint64_t period_cycles = (uint64_t)period * (SystemCoreClock / 1000000);
+    for (int i = 0; i < XLAT_DIAG_ISR_MAX; i++) {
+        uint32_t cycles = xlat_diag_isr_cycles[i];
+        diag.isr_permille[i] = period_cycles ? (uint16_t)((uint64_t)(cycles - prev_isr_cycles[i]) * 1000 / period_cycles) : 0;
+        prev_isr_cycles[i] = cycles;
+    }
+
+    diag.heap_free = xPortGetFreeHeapSize();
+    diag.heap_free_min = xPortGetMinimumEverFreeHeapSize();
+    diag.hid_event_drops = xlat_hid_event_drop_count_get();
+    diag.log_overruns = xlat_log_overrun_count_get();
+    diag.trace_drops = xlat_trace_drop_count_get();
+    diag.cdc_drops = usb_cdc_drop_count_get();
+
+    struct xlat_sdlog_stats sdlog;
+    xlat_sdlog_stats_get(&sdlog);
+    diag.sdlog_drops = sdlog.drops;
+
+    struct usb_proxy_stats proxy;
+    usb_proxy_stats_get(&proxy);
+    diag.proxy_forwarded = proxy.forwarded;
+    diag.proxy_coalesced = proxy.coalesced;
+    diag.proxy_delay_avg_us = proxy.delay_avg_us;
+    diag.proxy_delay_max_us = proxy.delay_max_us;
+}
+
+const struct xlat_diag *xlat_diag_get(void)
+{
+    return &diag;
+}
+
+void xlat_diag_lvgl_mem_set(uint32_t total, uint32_t used, uint32_t max_used, uint8_t frag_pct)
+{
+    diag.lvgl_mem_total = total;
+    diag.lvgl_mem_used = used;
+    diag.lvgl_mem_max_used = max_used;
+    diag.lvgl_mem_frag_pct = frag_pct;
+}
+
+void xlat_diag_print(void)
+{
+    // Comment lines, so they can be mixed with the CSV output
+    char buf[80];
+
+    snprintf(buf, sizeof(buf), "# diag: over %lu ms\n", diag.period_us / 1000);
+    vcp_writestr(buf);
+    for (uint8_t i = 0; i < diag.task_count; i++) {
+        snprintf(buf, sizeof(buf), "#   task %-16s cpu %3u.%u %%, stack free %5lu B\n", diag.tasks[i].name,
+                 diag.tasks[i].cpu_permille / 10, diag.tasks[i].cpu_permille % 10, diag.tasks[i].stack_free_min);
+        vcp_writestr(buf);
+    }
+    for (int i = 0; i < XLAT_DIAG_ISR_MAX; i++) {
+        snprintf(buf, sizeof(buf), "#   isr  %-16s cpu %3u.%u %%\n", isr_names[i],
+                 diag.isr_permille[i] / 10, diag.isr_permille[i] % 10);
+        vcp_writestr(buf);
+    }
+    snprintf(buf, sizeof(buf), "#   heap free %u B, min ever %u B of %u B\n",
+             diag.heap_free, diag.heap_free_min, configTOTAL_HEAP_SIZE);
+    vcp_writestr(buf);
+    if (diag.lvgl_mem_total) {
+        snprintf(buf, sizeof(buf), "#   lvgl mem used %lu B, max %lu B of %lu B, frag %u %%\n",
+                 diag.lvgl_mem_used, diag.lvgl_mem_max_used, diag.lvgl_mem_total, diag.lvgl_mem_frag_pct);
+        vcp_writestr(buf);
+    }
+    snprintf(buf, sizeof(buf), "#   drops: hid events %lu, log %lu, trace %lu, usb cdc %lu, sd log %lu\n",
+             diag.hid_event_drops, diag.log_overruns, diag.trace_drops, diag.cdc_drops, diag.sdlog_drops);
+    vcp_writestr(buf);
+    snprintf(buf, sizeof(buf), "#   hid proxy: %lu reports, %lu coalesced, added delay avg %lu us, max %lu us\n",
+             diag.proxy_forwarded, diag.proxy_coalesced, diag.proxy_delay_avg_us, diag.proxy_delay_max_us);
+    vcp_writestr(buf);
+}
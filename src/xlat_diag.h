@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef XLAT_DIAG_H
+#define XLAT_DIAG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Runtime diagnostics: CPU load per task and per interrupt, stack and heap headroom,
+ * and the drop counters of the event queues and rings.
+ *
+ * Task CPU time comes from the FreeRTOS run time stats, clocked by the 1 MHz TIM2 counter.
+ * Interrupt time is measured with the DWT cycle counter in the handlers that matter,
+ * see XLAT_DIAG_ISR_ENTER()/XLAT_DIAG_ISR_EXIT(). It is also included in the time of
+ * the task that was interrupted.
+ */
+
+#define XLAT_DIAG_MAX_TASKS     10
+#define XLAT_DIAG_TASK_NAME_LEN 16  // configMAX_TASK_NAME_LEN
+
+enum xlat_diag_isr {
+    XLAT_DIAG_ISR_EXTI,     // measurement input (and touch)
+    XLAT_DIAG_ISR_OTG_HS,   // USB host
+    XLAT_DIAG_ISR_MAX,
+};
+
+struct xlat_diag_task {
+    char name[XLAT_DIAG_TASK_NAME_LEN];
+    uint16_t cpu_permille;      // since the previous xlat_diag_update()
+    uint32_t stack_free_min;    // bytes, lowest ever
+};
+
+struct xlat_diag {
+    uint32_t period_us;         // time covered by the CPU load numbers
+    uint8_t task_count;
+    struct xlat_diag_task tasks[XLAT_DIAG_MAX_TASKS];
+    uint16_t isr_permille[XLAT_DIAG_ISR_MAX];
+    size_t heap_free;
+    size_t heap_free_min;
+    uint32_t hid_event_drops;
+    uint32_t log_overruns;
+    uint32_t trace_drops;
+    uint32_t cdc_drops;
+    uint32_t sdlog_drops;
+    // HID pass-through to the PC
+    uint32_t proxy_forwarded;
+    uint32_t proxy_coalesced;
+    uint32_t proxy_delay_avg_us;
+    uint32_t proxy_delay_max_us;
+    // LVGL heap, reported by the GUI (zero in the headless build)
+    uint32_t lvgl_mem_total;
+    uint32_t lvgl_mem_used;
+    uint32_t lvgl_mem_max_used;
+    uint8_t lvgl_mem_frag_pct;
+};
+
+extern volatile uint32_t xlat_diag_isr_cycles[XLAT_DIAG_ISR_MAX];
+
+// Wrap the body of an interrupt handler, costs two cycle counter reads
+#define XLAT_DIAG_ISR_ENTER()       uint32_t diag_isr_start = DWT->CYCCNT
+#define XLAT_DIAG_ISR_EXIT(isr)     xlat_diag_isr_cycles[(isr)] += DWT->CYCCNT - diag_isr_start
+
+void xlat_diag_init(void);
+void xlat_diag_update(void);
+const struct xlat_diag *xlat_diag_get(void);
+void xlat_diag_lvgl_mem_set(uint32_t total, uint32_t used, uint32_t max_used, uint8_t frag_pct);
+void xlat_diag_print(void);
+
+#endif //XLAT_DIAG_H
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "xlat_hist.h"
+
+// Written by the xlat task, read by the GUI: single words, no locking needed
+static uint32_t hist_bins[XLAT_HIST_BINS];
+static uint32_t hist_total = 0;
+static uint32_t hist_peak = 0;
+static uint16_t hist_last_bin = 0;
+
+void xlat_hist_reset(void)
+{
+    memset(hist_bins, 0, sizeof(hist_bins));
+    hist_total = 0;
+    hist_peak = 0;
+    hist_last_bin = 0;
+}
+
+uint16_t xlat_hist_bin_get(uint32_t latency_us)
+{
+    uint32_t bin = latency_us / XLAT_HIST_BIN_US;
+    return (bin < XLAT_HIST_BINS) ? (uint16_t)bin : (XLAT_HIST_BINS - 1);
+}
+
+uint16_t xlat_hist_add(uint32_t latency_us)
+{
+    uint16_t bin = xlat_hist_bin_get(latency_us);
+
+    hist_bins[bin]++;
+    hist_total++;
+    if (hist_bins[bin] > hist_peak) {
+        hist_peak = hist_bins[bin];
+    }
+    if (bin > hist_last_bin) {
+        hist_last_bin = bin;
+    }
+    return bin;
+}
+
+uint32_t xlat_hist_count_get(uint16_t bin)
+{
+    return (bin < XLAT_HIST_BINS) ? hist_bins[bin] : 0;
+}
+
+uint32_t xlat_hist_total_get(void)
+{
+    return hist_total;
+}
+
+uint32_t xlat_hist_peak_get(void)
+{
+    return hist_peak;
+}
+
+uint16_t xlat_hist_last_bin_get(void)
+{
+    return hist_last_bin;
+}
+
+uint16_t xlat_hist_rank_bin_get(uint32_t rank)
+{
+    uint32_t seen = 0;
+
+    for (uint16_t bin = 0; bin <= hist_last_bin; bin++) {
+        seen += hist_bins[bin];
+        if (seen > rank) {
+            return bin;
+        }
+    }
+    return hist_last_bin;
+}
+
+void xlat_hist_cumulative_get(uint32_t *below)
+{
+    below[0] = 0;
+    for (uint16_t bin = 0; bin < XLAT_HIST_BINS; bin++) {
+        below[bin + 1] = below[bin] + hist_bins[bin];
+    }
+}
+
+// Number of samples below latency_us, interpolated inside its bin
+static float below_get(const uint32_t *below, float latency_us)
+{
+    if (latency_us <= 0.0f) {
+        return 0.0f;
+    }
+    if (latency_us >= (float)(XLAT_HIST_BINS * XLAT_HIST_BIN_US)) {
+        return (float)below[XLAT_HIST_BINS];
+    }
+
+    uint16_t bin = (uint16_t)(latency_us / XLAT_HIST_BIN_US);
+    float fraction = (latency_us - (float)(bin * XLAT_HIST_BIN_US)) / XLAT_HIST_BIN_US;
+    return (float)below[bin] + fraction * (float)(below[bin + 1] - below[bin]);
+}
+
+uint32_t xlat_hist_median_get(const uint32_t *below)
+{
+    uint32_t total = below[XLAT_HIST_BINS];
+    if (total == 0) {
+        return 0;
+    }
+
+    // Where half of the samples are below, inside the first bin that reaches the middle rank
+    float half = total / 2.0f;
+    uint16_t low = 0;
+    uint16_t high = XLAT_HIST_BINS - 1;
+    while (low < high) {
+        uint16_t mid = (low + high) / 2;
+        if ((float)below[mid + 1] < half) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    float fraction = (half - (float)below[low]) / (float)(below[low + 1] - below[low]);
+    return (uint32_t)(low * XLAT_HIST_BIN_US + fraction * XLAT_HIST_BIN_US + 0.5f);
+}
+
+uint32_t xlat_hist_mad_get(const uint32_t *below, uint32_t median_us)
+{
+    float half = below[XLAT_HIST_BINS] / 2.0f;
+    uint32_t low = 0;
+    uint32_t high = XLAT_HIST_BINS * XLAT_HIST_BIN_US;
+
+    if (half == 0.0f) {
+        return 0;
+    }
+
+    // Smallest distance from the median that holds half of the samples, two lookups per step
+    while (low < high) {
+        uint32_t mid = (low + high) / 2;
+        float within = below_get(below, (float)median_us + mid) - below_get(below, (float)median_us - mid);
+        if (within >= half) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef XLAT_HIST_H
+#define XLAT_HIST_H
+
+#include <stdint.h>
+
+/*
+ * Latency histogram with fixed-width bins.
+ *
+ * Adding a sample is O(1): one bin is incremented, nothing is sorted or stored.
+ * The last bin also counts everything above the histogram range.
+ */
+
+#define XLAT_HIST_BINS      256
+#define XLAT_HIST_BIN_US    50      // 256 * 50 us = 12.8 ms range
+
+void xlat_hist_reset(void);
+uint16_t xlat_hist_add(uint32_t latency_us);        // returns the bin the sample went into
+uint16_t xlat_hist_bin_get(uint32_t latency_us);
+uint32_t xlat_hist_count_get(uint16_t bin);
+uint32_t xlat_hist_total_get(void);
+uint32_t xlat_hist_peak_get(void);                  // highest count of a single bin
+uint16_t xlat_hist_last_bin_get(void);              // highest bin with a sample in it
+uint16_t xlat_hist_rank_bin_get(uint32_t rank);     // bin of the rank-th smallest sample, from 0
+
+// Robust estimators, assuming the samples are spread evenly inside each bin. They work on
+// a snapshot of the cumulative counts (XLAT_HIST_BINS + 1 entries), taken once per update
+void xlat_hist_cumulative_get(uint32_t *below);     // below[bin]: samples in the bins before bin
+uint32_t xlat_hist_median_get(const uint32_t *below);                   // 0 when empty
+uint32_t xlat_hist_mad_get(const uint32_t *below, uint32_t median_us);  // median absolute deviation
+
+#endif //XLAT_HIST_H
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "xlat_history.h"
+
+// Written by the xlat task, read by the GUI: a torn read only affects one frame of the plot
+static struct xlat_history_span history[XLAT_HISTORY_LEVELS][XLAT_HISTORY_ENTRIES];
+static uint32_t history_count = 0;
+
+// Number of samples in one entry of a level
+static inline uint32_t level_block(uint8_t level)
+{
+    return 1UL << (2 * level);  // XLAT_HISTORY_FANOUT^level
+}
+
+_Static_assert(XLAT_HISTORY_FANOUT == 4, "level_block() assumes a fanout of 4");
+
+// Number of samples a level can hold
+static inline uint32_t level_capacity(uint8_t level)
+{
+    return XLAT_HISTORY_ENTRIES * level_block(level);
+}
+
+void xlat_history_reset(void)
+{
+    history_count = 0;
+}
+
+void xlat_history_add(uint32_t latency_us)
+{
+    uint16_t value = (latency_us > UINT16_MAX) ? UINT16_MAX : (uint16_t)latency_us;
+
+    for (uint8_t level = 0; level < XLAT_HISTORY_LEVELS; level++) {
+        uint32_t idx = history_count >> (2 * level);
+        if (idx >= XLAT_HISTORY_ENTRIES) {
+            continue;
+        }
+
+        struct xlat_history_span *entry = &history[level][idx];
+        if ((history_count & (level_block(level) - 1)) == 0) {
+            // first sample of this block
+            entry->min = value;
+            entry->max = value;
+        } else {
+            if (value < entry->min) {
+                entry->min = value;
+            }
+            if (value > entry->max) {
+                entry->max = value;
+            }
+        }
+    }
+
+    history_count++;
+}
+
+uint32_t xlat_history_count_get(void)
+{
+    return history_count;
+}
+
+bool xlat_history_span_get(uint32_t first, uint32_t last, struct xlat_history_span *span)
+{
+    if (last > history_count) {
+        last = history_count;
+    }
+    if (last > level_capacity(XLAT_HISTORY_LEVELS - 1)) {
+        last = level_capacity(XLAT_HISTORY_LEVELS - 1);
+    }
+    if (first >= last) {
+        return false;
+    }
+
+    // Coarsest level that still resolves the range, and that holds all of it
+    uint8_t level = 0;
+    while ((level < XLAT_HISTORY_LEVELS - 1) && (level_block(level + 1) <= (last - first))) {
+        level++;
+    }
+    while (last > level_capacity(level)) {
+        level++;
+    }
+
+    // At most FANOUT + 1 entries, the ones at the edges may reach slightly outside the range
+    uint32_t idx = first >> (2 * level);
+    uint32_t end = (last - 1) >> (2 * level);
+    *span = history[level][idx];
+    for (idx++; idx <= end; idx++) {
+        if (history[level][idx].min < span->min) {
+            span->min = history[level][idx].min;
+        }
+        if (history[level][idx].max > span->max) {
+            span->max = history[level][idx].max;
+        }
+    }
+    return true;
+}
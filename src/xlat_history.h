@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef XLAT_HISTORY_H
+#define XLAT_HISTORY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Full-run latency history, kept as a min/max pyramid.
+ *
+ * Level k stores the min and max of every block of XLAT_HISTORY_FANOUT^k samples,
+ * so a plot can fetch the envelope of any sample range from a handful of entries,
+ * whatever the zoom. Each level is updated in place when a sample is added.
+ *
+ * Levels are fixed size: once a level is full it is no longer used and coarser
+ * levels take over. The top level covers 1024 * 4^5 = ~1M samples.
+ */
+
+#define XLAT_HISTORY_LEVELS     6
+#define XLAT_HISTORY_FANOUT     4       // samples per entry grows by this factor per level
+#define XLAT_HISTORY_ENTRIES    1024    // entries per level
+
+struct xlat_history_span {
+    uint16_t min;   // us, saturated
+    uint16_t max;
+};
+
+void xlat_history_reset(void);
+void xlat_history_add(uint32_t latency_us);
+uint32_t xlat_history_count_get(void);
+
+// Envelope of samples [first, last), returns false if there is none
+bool xlat_history_span_get(uint32_t first, uint32_t last, struct xlat_history_span *span);
+
+#endif //XLAT_HISTORY_H
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "main.h"
+#include "cmsis_os.h"
+#include "xlat_log.h"
+
+#define XLAT_LOG_DRAIN_PERIOD_MS 10
+
+struct xlat_log_record {
+    const char *fmt;
+    uint32_t args[XLAT_LOG_MAX_ARGS];
+};
+
+static struct xlat_log_record log_ring[XLAT_LOG_RING_SIZE];
+static volatile uint32_t log_head = 0; // written by producers
+static volatile uint32_t log_tail = 0; // written by the log task
+static volatile uint32_t log_overruns = 0;
+
+void xlat_log_add(const char *fmt, const uint32_t *args, uint32_t nargs)
+{
+    // Safe from both task and ISR context (only masks interrupts up to MAX_SYSCALL)
+    UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+
+    if (log_head - log_tail >= XLAT_LOG_RING_SIZE) {
+        // Ring is full, drop the newest record
+        log_overruns++;
+    } else {
+        struct xlat_log_record *rec = &log_ring[log_head % XLAT_LOG_RING_SIZE];
+        rec->fmt = fmt;
+        memcpy(rec->args, args, nargs * sizeof(uint32_t));
+        log_head++;
+    }
+
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+}
+
+uint32_t xlat_log_overrun_count_get(void)
+{
+    return log_overruns;
+}
+
+/**
+  * @brief  Formats the queued log records, at low priority
+  * @param  argument: Not used
+  * @retval None
+  */
+void xlat_log_task(void const *argument)
+{
+    (void)argument;
+    uint32_t reported_overruns = 0;
+
+    for (;;) {
+        while (log_tail != log_head) {
+            // Copy the record out first, so the slot can be reused while printing
+            struct xlat_log_record rec = log_ring[log_tail % XLAT_LOG_RING_SIZE];
+            __DMB();
+            log_tail++;
+
+            printf(rec.fmt, rec.args[0], rec.args[1], rec.args[2], rec.args[3]);
+        }
+
+        if (reported_overruns != log_overruns) {
+            printf("[log] %lu records dropped\n", log_overruns - reported_overruns);
+            reported_overruns = log_overruns;
+        }
+
+        osDelay(XLAT_LOG_DRAIN_PERIOD_MS);
+    }
+}
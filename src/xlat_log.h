@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef XLAT_LOG_H
+#define XLAT_LOG_H
+
+#include <stdint.h>
+
+/*
+ * Deferred logging for hot paths.
+ *
+ * xlat_log() only stores the format string pointer and up to XLAT_LOG_MAX_ARGS
+ * raw 32-bit arguments in a ring; the text is formatted with printf later, by
+ * the low-priority log task. The format string must be a literal, and the
+ * arguments must be integers (no "%s", no floats).
+ */
+
+#ifndef XLAT_LOG_RING_SIZE
+#define XLAT_LOG_RING_SIZE  32  // records, power of 2
+#endif
+#define XLAT_LOG_MAX_ARGS   4
+
+#define xlat_log(fmt, ...) do { \
+    const uint32_t _xlat_log_args[] = { 0, ##__VA_ARGS__ }; \
+    _Static_assert(sizeof(_xlat_log_args) / sizeof(uint32_t) - 1 <= XLAT_LOG_MAX_ARGS, "too many log arguments"); \
+    xlat_log_add((fmt), &_xlat_log_args[1], sizeof(_xlat_log_args) / sizeof(uint32_t) - 1); \
+} while (0)
+
+void xlat_log_add(const char *fmt, const uint32_t *args, uint32_t nargs); // task or ISR context
+uint32_t xlat_log_overrun_count_get(void);
+void xlat_log_task(void const *argument);
+
+#endif //XLAT_LOG_H
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <math.h>
+
+#include "xlat_robust.h"
+
+static uint16_t k_x10 = XLAT_ROBUST_K_X10_DEFAULT;
+
+// Written by the xlat task, read by the GUI and the command task
+static uint32_t median_us = 0;
+static uint32_t mad_us = 0;
+static uint32_t sample_count = 0;
+static uint32_t outlier_count = 0;
+static bool last_outlier = false;
+
+// Only used by the xlat task, in xlat_robust_add()
+static uint32_t hist_below[XLAT_HIST_BINS + 1];
+
+static uint64_t inlier_sum = 0;
+static uint64_t inlier_sum_sq = 0;
+static uint32_t inlier_count = 0;
+
+void xlat_robust_reset(void)
+{
+    median_us = 0;
+    mad_us = 0;
+    sample_count = 0;
+    outlier_count = 0;
+    last_outlier = false;
+    inlier_sum = 0;
+    inlier_sum_sq = 0;
+    inlier_count = 0;
+}
+
+bool xlat_robust_add(uint32_t latency_us)
+{
+    // One pass over the histogram, shared by the median and the MAD
+    xlat_hist_cumulative_get(hist_below);
+    median_us = xlat_hist_median_get(hist_below);
+    mad_us = xlat_hist_mad_get(hist_below, median_us);
+    sample_count++;
+
+    uint32_t mad = (mad_us < XLAT_ROBUST_MAD_MIN_US) ? XLAT_ROBUST_MAD_MIN_US : mad_us;
+    uint32_t deviation = (latency_us > median_us) ? (latency_us - median_us) : (median_us - latency_us);
+
+    last_outlier = (sample_count > XLAT_ROBUST_MIN_SAMPLES) && ((uint64_t)deviation * 10 > (uint64_t)mad * k_x10);
+    if (last_outlier) {
+        outlier_count++;
+    } else {
+        inlier_sum += latency_us;
+        inlier_sum_sq += (uint64_t)latency_us * latency_us;
+        inlier_count++;
+    }
+    return last_outlier;
+}
+
+void xlat_robust_k_x10_set(uint16_t k)
+{
+    if (k < 10) {
+        k = 10;
+    }
+    k_x10 = k;
+}
+
+uint16_t xlat_robust_k_x10_get(void)
+{
+    return k_x10;
+}
+
+uint32_t xlat_robust_median_get(void)
+{
+    return median_us;
+}
+
+uint32_t xlat_robust_mad_get(void)
+{
+    return mad_us;
+}
+
+uint32_t xlat_robust_outlier_count_get(void)
+{
+    return outlier_count;
+}
+
+bool xlat_robust_last_outlier_get(void)
+{
+    return last_outlier;
+}
+
+uint32_t xlat_robust_inlier_count_get(void)
+{
+    return inlier_count;
+}
+
+uint32_t xlat_robust_inlier_average_get(void)
+{
+    if (inlier_count == 0) {
+        return 0;
+    }
+    return (uint32_t)(inlier_sum / inlier_count);
+}
+
+uint32_t xlat_robust_inlier_standard_deviation_get(void)
+{
+    if (inlier_count == 0) {
+        return 0;
+    }
+    // In double: the integer averages would inflate the variance of tight distributions
+    double avg = (double)inlier_sum / inlier_count;
+    double variance = (double)inlier_sum_sq / inlier_count - avg * avg;
+    return (variance > 0.0) ? (uint32_t)sqrt(variance) : 0;
+}
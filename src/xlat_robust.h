@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef XLAT_ROBUST_H
+#define XLAT_ROBUST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "xlat_hist.h"
+
+/*
+ * Robust statistics of the GPIO -> USB latency: median, median absolute deviation (MAD),
+ * and the average and stdev with the outliers left out.
+ *
+ * The median and MAD come from the latency histogram, so they are resolved to a fraction
+ * of XLAT_HIST_BIN_US. They are updated by the xlat task after every sample, which is then
+ * flagged as an outlier when it is more than k * MAD away from the median. A sample is
+ * flagged once, against the distribution at the time it came in: the first
+ * XLAT_ROBUST_MIN_SAMPLES samples of a run are never outliers.
+ */
+
+#define XLAT_ROBUST_K_X10_DEFAULT   50      // k = 5.0, about 3.4 sigma for a normal distribution
+#define XLAT_ROBUST_MIN_SAMPLES     20
+#define XLAT_ROBUST_MAD_MIN_US      (XLAT_HIST_BIN_US / 4)
+
+void xlat_robust_reset(void);
+bool xlat_robust_add(uint32_t latency_us);     // after xlat_hist_add(), returns true for an outlier
+
+void xlat_robust_k_x10_set(uint16_t k_x10);    // k in tenths, at least 10
+uint16_t xlat_robust_k_x10_get(void);
+
+uint32_t xlat_robust_median_get(void);
+uint32_t xlat_robust_mad_get(void);
+uint32_t xlat_robust_outlier_count_get(void);
+bool xlat_robust_last_outlier_get(void);
+
+// "Outliers excluded" view
+uint32_t xlat_robust_inlier_count_get(void);
+uint32_t xlat_robust_inlier_average_get(void);
+uint32_t xlat_robust_inlier_standard_deviation_get(void);
+
+#endif //XLAT_ROBUST_H
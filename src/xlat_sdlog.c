@@ -0,0 +1,492 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "xlat_sdlog.h"
+#include "xlat.h"
+#include "xlat_config.h"
+#include "usb_task.h"
+
+#ifdef XLAT_SDLOG_HOST
+// Host build: single threaded
+#define SDLOG_LOCK()        ((void)0)
+#define SDLOG_UNLOCK()      ((void)0)
+#else
+#include "cmsis_os.h"
+// Only tasks log, the scheduler lock keeps the measurement interrupt enabled while a
+// run's info blocks are encoded
+#define SDLOG_LOCK()        vTaskSuspendAll()
+#define SDLOG_UNLOCK()      xTaskResumeAll()
+#endif
+
+struct sdlog_batch {
+    struct xlat_capture_block blocks[XLAT_SDLOG_BATCH_BLOCKS];
+    uint8_t used;               // complete blocks, blocks[used] is being filled when its length isn't 0
+    volatile bool ready;        // handed to the logger task
+} __attribute__((aligned(32)));
+
+static struct sdlog_batch batches[2];
+static uint8_t batch_fill = 0;  // batch the xlat task appends to
+
+static struct xlat_blockdev *dev = NULL;
+static uint32_t file_start;
+static uint32_t file_blocks = 0;
+static uint32_t next_seq;
+static uint32_t run;
+static uint32_t run_samples = 0;
+static uint16_t info_records = 0;   // records of the run's info already queued
+static uint32_t last_write_ms = 0;
+
+static struct xlat_sdlog_stats stats;
+
+// Mount only, block reads go through here
+static uint8_t scratch[XLAT_BLOCK_SIZE] __attribute__((aligned(32)));
+
+static inline uint16_t rd16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t rd32(const uint8_t *p)
+{
+    return rd16(p) | ((uint32_t)rd16(p + 2) << 16);
+}
+
+static uint32_t fat_next(struct xlat_blockdev *bd, uint32_t fat_lba, uint32_t cluster, uint32_t *cached_lba)
+{
+    uint32_t lba = fat_lba + cluster / (XLAT_BLOCK_SIZE / 4);
+
+    if ((lba != *cached_lba) && !bd->read(bd, lba, scratch, 1)) {
+        *cached_lba = UINT32_MAX;
+        return 0;
+    }
+    *cached_lba = lba;
+    return rd32(&scratch[(cluster % (XLAT_BLOCK_SIZE / 4)) * 4]) & 0x0FFFFFFF;
+}
+
+bool xlat_sdlog_file_find(struct xlat_blockdev *bd, uint32_t *start_lba, uint32_t *block_count)
+{
+    uint32_t part_lba = 0;
+    uint32_t cached_lba = UINT32_MAX;
+
+    if (!bd->read(bd, 0, scratch, 1) || (rd16(&scratch[510]) != 0xAA55)) {
+        return false;
+    }
+
+    // No FAT boot sector at block 0: an MBR, use the first partition
+    if ((rd16(&scratch[11]) != XLAT_BLOCK_SIZE) || (scratch[13] == 0) || (scratch[16] == 0)) {
+        part_lba = rd32(&scratch[446 + 8]);
+        if (!bd->read(bd, part_lba, scratch, 1)) {
+            return false;
+        }
+    }
+
+    uint32_t sectors_per_cluster = scratch[13];
+    uint32_t fat_lba = part_lba + rd16(&scratch[14]);
+    uint32_t fat_size = rd32(&scratch[36]);
+    uint32_t data_lba = fat_lba + scratch[16] * fat_size;
+    uint32_t cluster = rd32(&scratch[44]);
+
+    // FAT32 only: no 16-bit FAT size, no fixed root directory
+    if ((rd16(&scratch[11]) != XLAT_BLOCK_SIZE) || (sectors_per_cluster == 0) || (rd16(&scratch[22]) != 0) ||
+        (rd16(&scratch[17]) != 0) || (fat_size == 0)) {
+        printf("SD log: not a FAT32 volume\n");
+        return false;
+    }
+
+    // Root directory
+    uint32_t file_cluster = 0;
+    uint32_t file_size = 0;
+    bool found = false;
+    bool end = false;
+    while (!found && !end && (cluster >= 2) && (cluster < 0x0FFFFFF8)) {
+        for (uint32_t s = 0; (s < sectors_per_cluster) && !found && !end; s++) {
+            cached_lba = UINT32_MAX;
+            if (!bd->read(bd, data_lba + (cluster - 2) * sectors_per_cluster + s, scratch, 1)) {
+                return false;
+            }
+            for (uint32_t e = 0; e < (XLAT_BLOCK_SIZE / 32); e++) {
+                const uint8_t *d = &scratch[e * 32];
+                if (d[0] == 0x00) {
+                    end = true;
+                    break;
+                }
+                // Skip deleted entries, long names, volume labels and directories
+                if ((d[0] == 0xE5) || (d[11] & 0x18) || ((d[11] & 0x0F) == 0x0F)) {
+                    continue;
+                }
+                if (!memcmp(d, XLAT_SDLOG_FILE_NAME, 11)) {
+                    file_cluster = ((uint32_t)rd16(&d[20]) << 16) | rd16(&d[26]);
+                    file_size = rd32(&d[28]);
+                    found = true;
+                    break;
+                }
+            }
+        }
+        if (!found && !end) {
+            cluster = fat_next(bd, fat_lba, cluster, &cached_lba);
+        }
+    }
+
+    if (!found || (file_cluster < 2) || (file_size < sizeof(batches[0].blocks))) {
+        printf("SD log: no XLATLOG.BIN in the root directory\n");
+        return false;
+    }
+
+    // The logger writes blocks straight into the file's clusters, they must be in one piece
+    uint32_t cluster_size = sectors_per_cluster * XLAT_BLOCK_SIZE;
+    uint32_t clusters = (file_size + cluster_size - 1) / cluster_size;
+    cached_lba = UINT32_MAX;
+    for (uint32_t i = 0; (i + 1) < clusters; i++) {
+        if (fat_next(bd, fat_lba, file_cluster + i, &cached_lba) != (file_cluster + i + 1)) {
+            printf("SD log: XLATLOG.BIN is fragmented\n");
+            return false;
+        }
+    }
+
+    *start_lba = data_lba + (file_cluster - 2) * sectors_per_cluster;
+    *block_count = file_size / XLAT_BLOCK_SIZE;
+    return true;
+}
+
+// Block i of the file was written in the current lap, right after block 0
+static bool block_in_lap(struct xlat_blockdev *bd, uint32_t start_lba, uint32_t i, uint32_t seq0)
+{
+    const struct xlat_capture_block *blk = (const struct xlat_capture_block *)scratch;
+
+    return bd->read(bd, start_lba + i, scratch, 1) && xlat_capture_block_check(blk) && (blk->seq == (seq0 + i));
+}
+
+bool xlat_sdlog_mount(struct xlat_blockdev *bd, uint32_t start_lba, uint32_t block_count)
+{
+    const struct xlat_capture_block *blk = (const struct xlat_capture_block *)scratch;
+
+    if (block_count < XLAT_SDLOG_BATCH_BLOCKS) {
+        return false;
+    }
+
+    next_seq = 0;
+    run = 1;
+    if (!bd->read(bd, start_lba, scratch, 1)) {
+        return false;
+    }
+
+    uint32_t seq0 = blk->seq;
+    if (((seq0 % block_count) == 0) && block_in_lap(bd, start_lba, 0, seq0)) {
+        // Blocks [0, head) are from the current lap, the rest is older or never written:
+        // binary search for the head
+        uint32_t lo = 1;
+        uint32_t hi = block_count;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (block_in_lap(bd, start_lba, mid, seq0)) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        next_seq = seq0 + lo;
+
+        if (!bd->read(bd, start_lba + lo - 1, scratch, 1)) {
+            return false;
+        }
+        run = blk->run + 1;
+    }
+
+    SDLOG_LOCK();
+    memset(batches, 0, sizeof(batches));
+    batch_fill = 0;
+    run_samples = 0;
+    info_records = 0;
+    dev = bd;
+    file_start = start_lba;
+    file_blocks = block_count;
+    SDLOG_UNLOCK();
+    return true;
+}
+
+// With the lock held
+static void batch_submit(void)
+{
+    struct sdlog_batch *b = &batches[batch_fill];
+
+    if (b->ready) {
+        return;
+    }
+    if ((b->used < XLAT_SDLOG_BATCH_BLOCKS) && b->blocks[b->used].length) {
+        b->used++;
+    }
+    if (b->used) {
+        b->ready = true;
+        batch_fill ^= 1;
+    }
+}
+
+static void batch_write(struct sdlog_batch *b)
+{
+    uint32_t n = b->used;
+
+    for (uint32_t i = 0; i < n; i++) {
+        xlat_capture_block_seal(&b->blocks[i], next_seq + i);
+    }
+
+    // One multi-block write, two when the batch wraps around the end of the file
+    uint32_t pos = next_seq % file_blocks;
+    uint32_t first = ((file_blocks - pos) < n) ? (file_blocks - pos) : n;
+    bool ok = dev->write(dev, file_start + pos, b->blocks, first);
+    if (ok && (first < n)) {
+        ok = dev->write(dev, file_start, &b->blocks[first], n - first);
+    }
+    // A failed batch is dropped and the next one is written in its place: the file has no
+    // holes, the binary search in xlat_sdlog_mount() relies on it
+    if (ok) {
+        next_seq += n;
+    }
+
+    SDLOG_LOCK();
+    if (ok) {
+        stats.blocks_written += n;
+    } else {
+        stats.write_errors++;
+    }
+    for (uint32_t i = 0; i < XLAT_SDLOG_BATCH_BLOCKS; i++) {
+        b->blocks[i].length = 0;
+    }
+    b->used = 0;
+    b->ready = false;
+    SDLOG_UNLOCK();
+}
+
+// With the lock held: close the block being filled, NULL when both batches wait for the card
+static struct xlat_capture_block *block_next(void)
+{
+    struct sdlog_batch *b = &batches[batch_fill];
+
+    if (++b->used == XLAT_SDLOG_BATCH_BLOCKS) {
+        b->ready = true;
+        batch_fill ^= 1;
+        b = &batches[batch_fill];
+        if (b->ready) {
+            return NULL;
+        }
+    }
+    return &b->blocks[b->used];
+}
+
+// With the lock held: the block to append to, a new one when the type changes
+static struct xlat_capture_block *block_get(enum xlat_capture_block_type type)
+{
+    struct sdlog_batch *b = &batches[batch_fill];
+    struct xlat_capture_block *blk = &b->blocks[b->used];
+
+    if (b->ready) {
+        return NULL;
+    }
+    if (blk->length && (blk->type != type)) {
+        blk = block_next();
+    }
+    if (blk && !blk->length) {
+        xlat_capture_block_init(blk, type, run);
+    }
+    return blk;
+}
+
+// With the lock held
+static bool record_add(enum xlat_capture_tag tag, const void *data, uint16_t len)
+{
+    struct xlat_capture_block *blk = block_get(XLAT_CAPTURE_BLOCK_INFO);
+
+    if (blk && !xlat_capture_record_put(blk, tag, data, len)) {
+        blk = block_next();
+        if (blk) {
+            xlat_capture_block_init(blk, XLAT_CAPTURE_BLOCK_INFO, run);
+            xlat_capture_record_put(blk, tag, data, len);
+        }
+    }
+    return blk != NULL;
+}
+
+// With the lock held: the info records already queued are skipped, so that an info cut
+// short by full batches is completed with the next sample instead of written twice
+static bool info_record_add(uint16_t *index, enum xlat_capture_tag tag, const void *data, uint16_t len)
+{
+    if ((*index)++ < info_records) {
+        return true;
+    }
+    if (!record_add(tag, data, len)) {
+        return false;
+    }
+    info_records++;
+    return true;
+}
+
+// With the lock held: what the decoder needs to know about the run, before its first sample
+static bool info_add(void)
+{
+    const char *strings[] = {
+#ifdef APP_VERSION_FULL // not in the simulator
+        [XLAT_CAPTURE_TAG_FIRMWARE] = APP_VERSION_FULL,
+#endif
+        [XLAT_CAPTURE_TAG_MANUFACTURER] = usb_host_get_manuf_string(),
+        [XLAT_CAPTURE_TAG_PRODUCT] = usb_host_get_product_string(),
+        [XLAT_CAPTURE_TAG_SERIAL] = usb_host_get_serial_string(),
+        [XLAT_CAPTURE_TAG_VIDPID] = usb_host_get_vidpid_string(),
+    };
+    struct xlat_capture_settings settings = {
+        .mode = xlat_mode_get(),
+        .trigger_level_high = xlat_auto_trigger_level_is_high(),
+        .trigger_output = xlat_auto_trigger_output_get(),
+        .quiet_mode = xlat_quiet_mode_is_enabled(),
+        .trigger_interval_ms = xlat_auto_trigger_interval_ms_get(),
+        .gpio_irq_holdoff_us = xlat_gpio_irq_holdoff_us_get(),
+        .button_bits = *xlat_button_bits_get(),
+        .motion_bits = *xlat_motion_bits_get(),
+        .report_id = xlat_report_id_get(),
+        .keyboard_found = xlat_keyboard_usage_page_found_get(),
+    };
+    uint16_t index = 0;
+    bool ok = info_record_add(&index, XLAT_CAPTURE_TAG_SETTINGS, &settings, sizeof(settings)) &&
+              info_record_add(&index, XLAT_CAPTURE_TAG_DEVICE_DESC, usb_host_get_device_descriptor(), 18);
+
+    for (size_t tag = 0; ok && (tag < (sizeof(strings) / sizeof(strings[0]))); tag++) {
+        if (strings[tag] && strings[tag][0]) {
+            ok = info_record_add(&index, tag, strings[tag], strlen(strings[tag]));
+        }
+    }
+
+    const uint8_t *desc;
+    uint16_t desc_len = xlat_hid_report_desc_get(&desc);
+    uint8_t chunk[2 + XLAT_CAPTURE_DESC_CHUNK];
+    for (uint16_t offset = 0; ok && (offset < desc_len); offset += XLAT_CAPTURE_DESC_CHUNK) {
+        uint16_t n = ((desc_len - offset) < XLAT_CAPTURE_DESC_CHUNK) ? (desc_len - offset) : XLAT_CAPTURE_DESC_CHUNK;
+        chunk[0] = (uint8_t)offset;
+        chunk[1] = (uint8_t)(offset >> 8);
+        memcpy(&chunk[2], &desc[offset], n);
+        ok = info_record_add(&index, XLAT_CAPTURE_TAG_REPORT_DESC, chunk, 2 + n);
+    }
+    return ok;
+}
+
+void xlat_sdlog_add(uint32_t timestamp_us, uint32_t latency_us, bool quiet)
+{
+    if (!file_blocks) {
+        return;
+    }
+
+    SDLOG_LOCK();
+    // When both batches are waiting for the card the sample is lost, the rest of the info
+    // is tried again with the next one
+    struct xlat_capture_block *blk = NULL;
+    if (run_samples || info_add()) {
+        blk = block_get(XLAT_CAPTURE_BLOCK_SAMPLES);
+    }
+    if (blk && !xlat_capture_sample_put(blk, timestamp_us, latency_us, quiet)) {
+        blk = block_next();
+        if (blk) {
+            xlat_capture_block_init(blk, XLAT_CAPTURE_BLOCK_SAMPLES, run);
+            xlat_capture_sample_put(blk, timestamp_us, latency_us, quiet);
+        }
+    }
+    if (blk) {
+        run_samples++;
+    } else {
+        stats.drops++;
+    }
+    SDLOG_UNLOCK();
+}
+
+void xlat_sdlog_run_end(void)
+{
+    SDLOG_LOCK();
+    if (run_samples) {
+        batch_submit();
+        run++;
+        run_samples = 0;
+        info_records = 0;
+    }
+    SDLOG_UNLOCK();
+}
+
+void xlat_sdlog_process(uint32_t now_ms)
+{
+    if (!file_blocks) {
+        return;
+    }
+
+    // Don't keep samples in RAM for long, a partial batch is written after a while
+    if ((now_ms - last_write_ms) >= XLAT_SDLOG_FLUSH_MS) {
+        SDLOG_LOCK();
+        batch_submit();
+        SDLOG_UNLOCK();
+        last_write_ms = now_ms;
+    }
+
+    // When both are ready, the one the xlat task appends to next was submitted first
+    SDLOG_LOCK();
+    uint8_t first = batch_fill;
+    SDLOG_UNLOCK();
+    for (uint8_t i = 0; i < 2; i++) {
+        struct sdlog_batch *b = &batches[first ^ i];
+        if (b->ready) {
+            batch_write(b);
+            last_write_ms = now_ms;
+        }
+    }
+}
+
+void xlat_sdlog_stats_get(struct xlat_sdlog_stats *out)
+{
+    SDLOG_LOCK();
+    *out = stats;
+    out->mounted = (file_blocks != 0);
+    out->file_blocks = file_blocks;
+    out->run = run;
+    SDLOG_UNLOCK();
+}
+
+#ifndef XLAT_SDLOG_HOST
+
+void xlat_sdlog_task(void const *argument)
+{
+    (void) argument;
+    static struct xlat_blockdev sd;
+    uint32_t start_lba;
+    uint32_t block_count;
+
+    while (!xlat_initialized) {
+        osDelay(10);
+    }
+
+    // The card is only looked for at boot
+    if (!xlat_blockdev_sd_init(&sd) || !xlat_sdlog_file_find(&sd, &start_lba, &block_count) ||
+        !xlat_sdlog_mount(&sd, start_lba, block_count)) {
+        printf("SD log: off\n");
+        vTaskSuspend(NULL);
+    }
+    printf("SD log: %lu blocks, run %lu\n", block_count, run);
+
+    while (1) {
+        osDelay(XLAT_SDLOG_POLL_MS);
+        xlat_sdlog_process(xTaskGetTickCount() * portTICK_PERIOD_MS);
+    }
+}
+
+#endif
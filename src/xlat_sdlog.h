@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef XLAT_SDLOG_H
+#define XLAT_SDLOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "xlat_blockdev.h"
+#include "xlat_capture.h"
+
+/*
+ * Run logger: every sample is streamed to a preallocated file on the microSD card.
+ *
+ * The card must hold a contiguous XLATLOG.BIN in the root directory of its first FAT32
+ * partition, created on a PC, e.g. "fsutil file createnew E:\XLATLOG.BIN 1073741824"
+ * or "fallocate -l 1G XLATLOG.BIN". The logger never touches the file system: it only
+ * writes blocks inside the file, so its size and clusters never change.
+ *
+ * The file is a ring of capture blocks (see xlat_capture.h), each run starts with the
+ * device and settings info. Samples are encoded into a block in RAM by the xlat task;
+ * full batches of blocks are written by the logger task with one multi-block DMA write.
+ * After a power loss the write position is recovered from the sequence numbers, at most
+ * the last batch is lost.
+ */
+
+#define XLAT_SDLOG_FILE_NAME        "XLATLOG BIN"   // 8.3, space padded
+#define XLAT_SDLOG_BATCH_BLOCKS     8               // blocks per write, two batches are buffered
+#define XLAT_SDLOG_FLUSH_MS         5000            // longest time a sample waits in RAM
+#define XLAT_SDLOG_POLL_MS          20
+
+// Block seq is at position seq % file blocks, runs count up across power cycles
+_Static_assert(XLAT_CAPTURE_BLOCK_SIZE == XLAT_BLOCK_SIZE, "log blocks must be one card block");
+
+struct xlat_sdlog_stats {
+    bool mounted;
+    uint32_t file_blocks;
+    uint32_t run;
+    uint32_t blocks_written;
+    uint32_t drops;             // samples lost because both batches were waiting for the card
+    uint32_t write_errors;
+};
+
+// Locate XLATLOG.BIN on a FAT32 volume, the file must be contiguous
+bool xlat_sdlog_file_find(struct xlat_blockdev *bd, uint32_t *start_lba, uint32_t *block_count);
+// Recover the write position and start logging to [start_lba, start_lba + block_count)
+bool xlat_sdlog_mount(struct xlat_blockdev *bd, uint32_t start_lba, uint32_t block_count);
+
+// xlat task (and whoever resets the statistics), never block
+void xlat_sdlog_add(uint32_t timestamp_us, uint32_t latency_us, bool quiet);
+void xlat_sdlog_run_end(void);
+
+// Logger task: writes the ready batches, and a partial one when data waited XLAT_SDLOG_FLUSH_MS
+void xlat_sdlog_process(uint32_t now_ms);
+void xlat_sdlog_task(void const *argument);
+
+void xlat_sdlog_stats_get(struct xlat_sdlog_stats *stats);
+
+#endif //XLAT_SDLOG_H
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "main.h"
+#include "xlat_sdram.h"
+#include "xlat_trace.h"
+
+struct sdram_pool {
+    const char *name;
+    uint32_t start;
+    uint32_t size;
+    uint32_t next;              // arena
+};
+
+struct sdram_region {
+    const char *name;
+    enum xlat_sdram_pool pool;
+    uint32_t size;
+    uint32_t align;
+    uint32_t address;
+};
+
+static struct sdram_pool pools[XLAT_SDRAM_POOL_MAX] = {
+    [XLAT_SDRAM_POOL_WT] = { "write-through", HW_SDRAM_WT_ADDRESS, HW_SDRAM_WT_SIZE },
+    [XLAT_SDRAM_POOL_WB] = { "write-back", HW_SDRAM_WT_ADDRESS + HW_SDRAM_WT_SIZE,
+                             HW_SDRAM_SIZE - HW_SDRAM_WT_SIZE - HW_SDRAM_NC_SIZE },
+    [XLAT_SDRAM_POOL_NC] = { "not cached", HW_SDRAM_NC_ADDRESS, HW_SDRAM_NC_SIZE },
+};
+
+static struct sdram_region regions[XLAT_SDRAM_REGION_MAX] = {
+    [XLAT_SDRAM_FRAMEBUFFERS] = { "framebuffers", XLAT_SDRAM_POOL_WT, XLAT_SDRAM_FRAMEBUFFERS_SIZE, 32 },
+#if defined(XLAT_LVGL_HEAP_SDRAM) && XLAT_LVGL_HEAP_SDRAM
+    [XLAT_SDRAM_LVGL_HEAP] = { "lvgl heap", XLAT_SDRAM_POOL_WB, XLAT_SDRAM_LVGL_HEAP_SIZE, 32 },
+#else
+    [XLAT_SDRAM_LVGL_HEAP] = { "lvgl heap", XLAT_SDRAM_POOL_WB, 0, 32 },
+#endif
+#if defined(XLAT_TRACE_ENABLED) && XLAT_TRACE_ENABLED
+    [XLAT_SDRAM_TRACE] = { "trace", XLAT_SDRAM_POOL_NC, XLAT_TRACE_BUFFER_SIZE, 32 },
+#else
+    [XLAT_SDRAM_TRACE] = { "trace", XLAT_SDRAM_POOL_NC, 0, 32 },
+#endif
+};
+
+// With the arena locked, or before the scheduler runs
+static uint32_t pool_take(struct sdram_pool *p, uint32_t size, uint32_t align)
+{
+    uint32_t address = (p->next + align - 1) & ~(align - 1);
+
+    if ((address + size) > (p->start + p->size)) {
+        return 0;
+    }
+    p->next = address + size;
+    return address;
+}
+
+void xlat_sdram_init(void)
+{
+    for (int i = 0; i < XLAT_SDRAM_POOL_MAX; i++) {
+        pools[i].next = pools[i].start;
+    }
+
+    printf("SDRAM budgets:\n");
+    for (int i = 0; i < XLAT_SDRAM_REGION_MAX; i++) {
+        struct sdram_region *r = &regions[i];
+        if (!r->size) {
+            continue;
+        }
+        r->address = pool_take(&pools[r->pool], r->size, r->align);
+        if (!r->address) {
+            // The budgets are fixed, this is a build configuration error
+            printf("  %-13s %7lu kB does not fit the %s pool\n", r->name, r->size / 1024, pools[r->pool].name);
+            Error_Handler();
+        }
+        printf("  %-13s %7lu kB at 0x%08lx, %s\n", r->name, r->size / 1024, r->address, pools[r->pool].name);
+    }
+    for (int i = 0; i < XLAT_SDRAM_POOL_MAX; i++) {
+        if (pools[i].size) {
+            printf("  free          %7lu kB, %s\n", xlat_sdram_free_get(i) / 1024, pools[i].name);
+        }
+    }
+}
+
+void *xlat_sdram_region_get(enum xlat_sdram_region region, uint32_t *size)
+{
+    if (size) {
+        *size = regions[region].size;
+    }
+    return (void *)regions[region].address;
+}
+
+void *xlat_sdram_alloc(enum xlat_sdram_pool pool, uint32_t size, uint32_t align, const char *name)
+{
+    vTaskSuspendAll();
+    uint32_t address = pool_take(&pools[pool], size, align ? align : 4);
+    xTaskResumeAll();
+
+    if (address) {
+        printf("SDRAM: %s, %lu kB at 0x%08lx\n", name, size / 1024, address);
+    } else {
+        printf("SDRAM: %s, %lu kB don't fit the %s pool\n", name, size / 1024, pools[pool].name);
+    }
+    return (void *)address;
+}
+
+uint32_t xlat_sdram_free_get(enum xlat_sdram_pool pool)
+{
+    return pools[pool].start + pools[pool].size - pools[pool].next;
+}
+
+void *xlat_sdram_lvgl_heap_get(size_t size)
+{
+    uint32_t budget;
+    void *heap = xlat_sdram_region_get(XLAT_SDRAM_LVGL_HEAP, &budget);
+
+    if (size > budget) {
+        Error_Handler();
+    }
+    return heap;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef XLAT_SDRAM_H
+#define XLAT_SDRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hardware_config.h"
+
+/*
+ * SDRAM layout: one pool per cache attribute (see the MPU setup in hardware_config.h).
+ *
+ * Every user gets a fixed region out of its pool, laid out by xlat_sdram_init() and
+ * printed at boot. What is left of a pool is an arena for xlat_sdram_alloc(), memory
+ * that is never given back: the sample store (xlat_store.c) is allocated from it.
+ */
+
+enum xlat_sdram_pool {
+    XLAT_SDRAM_POOL_WT,         // write-through, for what the LTDC or DMA2D read
+    XLAT_SDRAM_POOL_WB,         // write-back, the default
+    XLAT_SDRAM_POOL_NC,         // not cacheable
+    XLAT_SDRAM_POOL_MAX,
+};
+
+enum xlat_sdram_region {
+    XLAT_SDRAM_FRAMEBUFFERS,    // render buffer + 2 LTDC scan-out buffers
+    XLAT_SDRAM_LVGL_HEAP,       // only with XLAT_LVGL_HEAP_SDRAM
+    XLAT_SDRAM_TRACE,           // RTT buffer of the pipeline trace, only with XLAT_TRACE_ENABLED
+    XLAT_SDRAM_REGION_MAX,
+};
+
+// Budgets
+#define XLAT_SDRAM_FRAMEBUFFERS_SIZE    HW_SDRAM_WT_SIZE
+#if defined(XLAT_HEADLESS) && XLAT_HEADLESS
+#define XLAT_SDRAM_SAMPLE_STORE_SIZE    (7 * 1024 * 1024)     // from the write-back arena
+#else
+#define XLAT_SDRAM_SAMPLE_STORE_SIZE    (6 * 1024 * 1024)
+#endif
+#define XLAT_SDRAM_LVGL_HEAP_SIZE       (256 * 1024)
+
+// Right after the SDRAM is up, before any other call
+void xlat_sdram_init(void);
+
+// Start of the region, NULL when its budget is 0 in this build
+void *xlat_sdram_region_get(enum xlat_sdram_region region, uint32_t *size);
+
+// From the arena of a pool, NULL when it doesn't fit. Not for interrupts.
+void *xlat_sdram_alloc(enum xlat_sdram_pool pool, uint32_t size, uint32_t align, const char *name);
+uint32_t xlat_sdram_free_get(enum xlat_sdram_pool pool);
+
+// LV_MEM_POOL_ALLOC, see lv_conf.h
+void *xlat_sdram_lvgl_heap_get(size_t size);
+
+#endif //XLAT_SDRAM_H
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <math.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <main.h>
+#include "xlat_store.h"
+#include "xlat_config.h"
+#include "xlat_sdram.h"
+
+static struct xlat_sample *store;
+static uint32_t store_capacity;
+
+// Index of the next sample. Indexes only grow, the slot is index % store_capacity
+static uint32_t store_next = 0;
+
+// Completed runs, a ring of XLAT_STORE_MAX_RUNS
+static struct xlat_run runs[XLAT_STORE_MAX_RUNS];
+static uint8_t runs_first = 0;
+static uint8_t runs_count = 0;
+static uint32_t runs_number = 0;
+static volatile uint32_t generation = 0;
+
+// Run being recorded
+static uint32_t current_first = 0;
+static uint32_t current_min;
+static uint32_t current_max;
+static uint64_t current_sum;
+static uint64_t current_sum_sq;
+
+static void current_start(void)
+{
+    current_first = store_next;
+    current_min = UINT32_MAX;
+    current_max = 0;
+    current_sum = 0;
+    current_sum_sq = 0;
+}
+
+static void run_drop_oldest(void)
+{
+    runs_first = (runs_first + 1) % XLAT_STORE_MAX_RUNS;
+    runs_count--;
+    generation++;
+}
+
+// A run is dropped as soon as its first sample is overwritten
+static void runs_drop_overwritten(void)
+{
+    while (runs_count && ((store_next - runs[runs_first].first) > store_capacity)) {
+        run_drop_oldest();
+    }
+}
+
+void xlat_store_init(void)
+{
+    // Whatever is left of the write-back pool after the fixed regions, laid out at boot
+    store = xlat_sdram_alloc(XLAT_SDRAM_POOL_WB, XLAT_SDRAM_SAMPLE_STORE_SIZE, 32, "sample store");
+    if (store == NULL) {
+        // The budgets are fixed, this is a build configuration error
+        Error_Handler();
+    }
+    store_capacity = XLAT_SDRAM_SAMPLE_STORE_SIZE / sizeof(struct xlat_sample);
+    store_next = 0;
+    runs_count = 0;
+    current_start();
+}
+
+void xlat_store_add(uint32_t timestamp_us, uint32_t latency_us, bool quiet, bool outlier)
+{
+    taskENTER_CRITICAL();
+
+    struct xlat_sample *sample = &store[store_next % store_capacity];
+    sample->timestamp_us = timestamp_us;
+    sample->latency_us = (latency_us > XLAT_SAMPLE_LATENCY_MAX_US) ? XLAT_SAMPLE_LATENCY_MAX_US : latency_us;
+    sample->quiet = quiet;
+    sample->outlier = outlier;
+    store_next++;
+
+    if (latency_us < current_min) {
+        current_min = latency_us;
+    }
+    if (latency_us > current_max) {
+        current_max = latency_us;
+    }
+    current_sum += latency_us;
+    current_sum_sq += (uint64_t)latency_us * latency_us;
+
+    runs_drop_overwritten();
+
+    taskEXIT_CRITICAL();
+}
+
+void xlat_store_run_close(void)
+{
+    // Only the totals are taken with the interrupts masked, the divisions and the square
+    // root (double, in software) must not delay the measurement interrupt
+    taskENTER_CRITICAL();
+    uint32_t first = current_first;
+    uint32_t next = store_next;
+    uint32_t min = current_min;
+    uint32_t max = current_max;
+    uint64_t sum = current_sum;
+    uint64_t sum_sq = current_sum_sq;
+    current_start();
+    taskEXIT_CRITICAL();
+
+    uint32_t count = next - first;
+    if (!count) {
+        return;
+    }
+
+    // Only the samples still in the store are part of the run, the statistics cover all of them
+    struct xlat_run run = {
+        .first = (count > store_capacity) ? (next - store_capacity) : first,
+        .mode = xlat_mode_get(),
+        .min_us = min,
+        .max_us = max,
+    };
+    run.count = next - run.first;
+
+    double avg = (double)sum / count;
+    double variance = (double)sum_sq / count - avg * avg;
+    run.avg_us = (uint32_t)avg;
+    run.stdev_us = (variance > 0.0) ? (uint32_t)sqrt(variance) : 0;
+
+    taskENTER_CRITICAL();
+    if (runs_count == XLAT_STORE_MAX_RUNS) {
+        run_drop_oldest();
+    }
+    run.number = ++runs_number;
+    runs[(runs_first + runs_count) % XLAT_STORE_MAX_RUNS] = run;
+    runs_count++;
+    generation++;
+    // The next run may have filled the store in the meantime
+    runs_drop_overwritten();
+    taskEXIT_CRITICAL();
+}
+
+uint32_t xlat_store_generation_get(void)
+{
+    return generation;
+}
+
+uint8_t xlat_store_runs_get(struct xlat_run *out, uint8_t max)
+{
+    taskENTER_CRITICAL();
+    uint8_t n = (runs_count < max) ? runs_count : max;
+    for (uint8_t i = 0; i < n; i++) {
+        out[i] = runs[(runs_first + i) % XLAT_STORE_MAX_RUNS];
+    }
+    taskEXIT_CRITICAL();
+    return n;
+}
+
+bool xlat_store_sample_get(uint32_t index, struct xlat_sample *sample)
+{
+    // Under the writer's lock: the slot may be overwritten at any time
+    taskENTER_CRITICAL();
+    uint32_t age = store_next - index;
+    bool valid = (age != 0) && (age <= store_capacity);
+    if (valid) {
+        *sample = store[index % store_capacity];
+    }
+    taskEXIT_CRITICAL();
+    return valid;
+}
+
+uint32_t xlat_store_next_get(void)
+{
+    return store_next;
+}
+
+uint32_t xlat_store_run_first_get(uint32_t index)
+{
+    uint32_t first = index;
+
+    taskENTER_CRITICAL();
+    if ((index - current_first) < (store_next - current_first)) {
+        first = current_first;
+    } else {
+        // Newest first, the sample is usually in the run that was just closed
+        for (uint8_t i = runs_count; i > 0; i--) {
+            struct xlat_run *run = &runs[(runs_first + i - 1) % XLAT_STORE_MAX_RUNS];
+            if ((index - run->first) < run->count) {
+                first = run->first;
+                break;
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return first;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef XLAT_STORE_H
+#define XLAT_STORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Per-sample store, split into runs.
+ *
+ * Every GPIO -> USB measurement is appended to a ring buffer in SDRAM. A run ends
+ * when the statistics are reset (clear button, device disconnect, mode change...),
+ * the completed runs are what the USB mass-storage volume exposes as files.
+ * When the ring wraps, the oldest runs are dropped.
+ */
+
+#define XLAT_STORE_MAX_RUNS     16
+#define XLAT_SAMPLE_LATENCY_MAX_US  ((1UL << 30) - 1)
+
+struct xlat_sample {
+    uint32_t timestamp_us;      // input edge, 1 MHz counter
+    uint32_t latency_us : 30;
+    uint32_t quiet : 1;
+    uint32_t outlier : 1;       // see xlat_robust.h
+};
+
+struct xlat_run {
+    uint32_t number;            // counts up from 1 since boot
+    uint32_t first;             // store index of the first sample
+    uint32_t count;
+    uint8_t mode;               // enum xlat_mode
+    uint32_t avg_us;
+    uint32_t stdev_us;
+    uint32_t min_us;
+    uint32_t max_us;
+};
+
+void xlat_store_init(void);
+void xlat_store_add(uint32_t timestamp_us, uint32_t latency_us, bool quiet, bool outlier);
+void xlat_store_run_close(void);
+uint32_t xlat_store_generation_get(void);       // changes whenever a run is completed or dropped
+uint8_t xlat_store_runs_get(struct xlat_run *runs, uint8_t max);   // completed runs, oldest first
+bool xlat_store_sample_get(uint32_t index, struct xlat_sample *sample);    // false once overwritten
+uint32_t xlat_store_next_get(void);                         // index of the next sample to be added
+uint32_t xlat_store_run_first_get(uint32_t index);          // first index of the run holding index
+
+#endif //XLAT_STORE_H
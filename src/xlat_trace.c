@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "xlat_trace.h"
+
+#if defined(XLAT_TRACE_ENABLED) && XLAT_TRACE_ENABLED
+
+#include "main.h"
+#include "SEGGER_RTT.h"
+#include "xlat_sdram.h"
+
+static volatile uint32_t trace_drops = 0;
+
+void xlat_trace_init(void)
+{
+    // Enable the DWT cycle counter
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55; // unlock DWT access on the Cortex-M7
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    // Never block the caller: when the host doesn't keep up, records are dropped.
+    // The buffer is not cached, the probe reads it behind the CPU's back
+    uint32_t size;
+    void *buffer = xlat_sdram_region_get(XLAT_SDRAM_TRACE, &size);
+    SEGGER_RTT_ConfigUpBuffer(XLAT_TRACE_RTT_CHANNEL, "xlat_trace", buffer, size, SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+
+    xlat_trace(XLAT_TRACE_ID_INIT, 0, (uint16_t)(SystemCoreClock / 1000000));
+}
+
+void xlat_trace(uint8_t id, uint8_t arg8, uint16_t arg16)
+{
+    // Take the timestamp first, the RTT write itself is not free
+    struct xlat_trace_record rec = {
+        .cycles = DWT->CYCCNT,
+        .id = id,
+        .arg8 = arg8,
+        .arg16 = arg16,
+    };
+
+    if (SEGGER_RTT_Write(XLAT_TRACE_RTT_CHANNEL, &rec, sizeof(rec)) != sizeof(rec)) {
+        trace_drops++;
+    }
+}
+
+uint32_t xlat_trace_drop_count_get(void)
+{
+    return trace_drops;
+}
+
+#endif
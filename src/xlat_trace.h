@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef XLAT_TRACE_H
+#define XLAT_TRACE_H
+
+#include <stdint.h>
+
+/*
+ * Binary pipeline trace, written to a dedicated RTT up-channel.
+ *
+ * Every record is 8 bytes: the DWT cycle counter at the time of the event,
+ * a record ID and two small arguments. Decode with tools/xlat_trace_decode.py.
+ * Enable with -DXLAT_TRACE=ON, otherwise all trace points compile to nothing.
+ */
+
+#define XLAT_TRACE_RTT_CHANNEL  1
+#define XLAT_TRACE_BUFFER_SIZE  (64 * 1024)    // in SDRAM, see xlat_sdram.h
+
+enum xlat_trace_id {
+    XLAT_TRACE_ID_INIT = 0,     // arg16: CPU clock in MHz
+    XLAT_TRACE_ID_EXTI,         // button edge interrupt entry
+    XLAT_TRACE_ID_OTG_IRQ,      // OTG_HS interrupt entry
+    XLAT_TRACE_ID_HID_REPORT,   // HID report callback, arg8: dev_addr, arg16: report length
+    XLAT_TRACE_ID_HID_EVENT,    // relevant transition queued, arg8: changed bits
+    XLAT_TRACE_ID_XLAT_EVENT,   // xlat task picked up the event, arg8: changed bits
+    XLAT_TRACE_ID_MEASUREMENT,  // measurement added, arg8: quiet, arg16: latency in us (saturated)
+    XLAT_TRACE_ID_GFX_UPDATE,   // gfx task processed the measurement
+    XLAT_TRACE_ID_GFX_FLUSH,    // display flush started, arg16: number of lines
+    XLAT_TRACE_ID_TASK_IN,      // context switch, arg8: task number
+    XLAT_TRACE_ID_TASK_OUT,     // context switch, arg8: task number
+};
+
+struct __attribute__((packed)) xlat_trace_record {
+    uint32_t cycles;    // DWT->CYCCNT
+    uint8_t id;         // enum xlat_trace_id
+    uint8_t arg8;
+    uint16_t arg16;
+};
+
+#if defined(XLAT_TRACE_ENABLED) && XLAT_TRACE_ENABLED
+
+void xlat_trace_init(void);
+void xlat_trace(uint8_t id, uint8_t arg8, uint16_t arg16);
+uint32_t xlat_trace_drop_count_get(void);
+
+#define XLAT_TRACE(id, arg8, arg16) xlat_trace((id), (arg8), (arg16))
+
+#else
+
+#define xlat_trace_init()           ((void)0)
+#define xlat_trace_drop_count_get() (0UL)
+#define XLAT_TRACE(id, arg8, arg16) ((void)0)
+
+#endif
+
+#endif //XLAT_TRACE_H
@@ -3,6 +3,7 @@
 #include <SDL2/SDL.h>
 #include "lvgl.h"
 #include "../src/gfx_main.h"
+#include "../src/xlat_sdlog.h"
 #include "stubs/main.h"
 
 #include "lv_drivers/sdl/sdl.h"
@@ -39,8 +40,16 @@ void lv_app_init(void)
     printf("mouse_indev: %p\n", mouse_indev);
 }
 
+// The SD card logger runs against a block device in RAM
+#define RAM_DISK_BLOCKS 2048
+static uint8_t ram_disk[RAM_DISK_BLOCKS * XLAT_BLOCK_SIZE] __attribute__((aligned(32)));
+
 int main()
 {
+    static struct xlat_blockdev ram_bd;
+    xlat_blockdev_ram_init(&ram_bd, ram_disk, RAM_DISK_BLOCKS);
+    xlat_sdlog_mount(&ram_bd, 0, RAM_DISK_BLOCKS);
+
     /* initialize lvgl */
     lv_init();
 
@@ -75,6 +84,7 @@ int main()
         lastTick = current;
 
         gfx_task(NULL);
+        xlat_sdlog_process(current);
     }
 
     return 0;
@@ -97,3 +107,9 @@ const char * usb_host_get_vidpid_string(void)
 {
     return "1234:5678";
 }
+
+const uint8_t * usb_host_get_device_descriptor(void)
+{
+    static const uint8_t desc[18] = { 18, 1, 0x00, 0x02, 0, 0, 0, 64, 0x34, 0x12, 0x78, 0x56, 0x00, 0x01, 1, 2, 3, 1 };
+    return desc;
+}
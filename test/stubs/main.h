@@ -10,7 +10,13 @@
 #include "../src/xlat.h"  // Include the original header for enums
 
 // Defines
+#define osOK 0
+#define osErrorTimeout -1
+#define osErrorParameter -2
+#define osErrorNoMemory -3
 #define osEventMessage 0x10
+#define osEventTimeout 0x20
+#define osWaitForever 0xFFFFFFFF
 #define portMAX_DELAY ( TickType_t ) 0xffffffffUL
 
 // Types
@@ -69,6 +75,7 @@ const char* usb_host_get_manuf_string(void);
 const char* usb_host_get_product_string(void);
 const char* usb_host_get_serial_string(void);
 const char * usb_host_get_vidpid_string(void);
+const uint8_t * usb_host_get_device_descriptor(void);
 
 
 // Other stugbs
@@ -4,15 +4,11 @@
 #include <stdlib.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <errno.h>
+#include <time.h>
 #include "main.h"
-
-// OS status definitions
-#define osOK 0
-#define osErrorTimeout -1
-#define osErrorParameter -2
-#define osErrorNoMemory -3
-#define osEventMessage 0x10
-#define osEventTimeout 0x20
+#include "../src/xlat_diag.h"
+#include "../src/xlat_sdlog.h"
 
 // Message queue implementation
 typedef struct message_node {
@@ -24,8 +20,12 @@ typedef struct {
     message_node_t *head;
     message_node_t *tail;
     pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
 } message_queue_t;
 
+// Longest finite osMessageGet() wait, the deadline must fit a 32-bit time_t
+#define MESSAGE_WAIT_MAX_MS (24 * 60 * 60 * 1000)
+
 static message_queue_t message_queues[10]; // Support up to 10 different queues
 static bool queues_initialized = false;
 
@@ -44,6 +44,7 @@ static void init_queues(void) {
             message_queues[i].head = NULL;
             message_queues[i].tail = NULL;
             pthread_mutex_init(&message_queues[i].mutex, NULL);
+            pthread_cond_init(&message_queues[i].not_empty, NULL);
         }
         queues_initialized = true;
     }
@@ -119,6 +120,7 @@ osStatus osMessagePut (osMessageQId queue_id, uint32_t info, uint32_t millisec)
         message_queues[queue_id].tail = node;
     }
 
+    pthread_cond_signal(&message_queues[queue_id].not_empty);
     pthread_mutex_unlock(&message_queues[queue_id].mutex);
     
     printf("osMessagePut: info=%lu\n", (unsigned long)info);
@@ -139,7 +141,25 @@ osEvent osMessageGet (osMessageQId queue_id, uint32_t millisec) {
     }
 
     pthread_mutex_lock(&message_queues[queue_id].mutex);
-    
+
+    // Nothing to receive: wait like the RTOS would, so callers don't spin
+    if (millisec == osWaitForever) {
+        while (!message_queues[queue_id].head) {
+            pthread_cond_wait(&message_queues[queue_id].not_empty, &message_queues[queue_id].mutex);
+        }
+    } else if (millisec > 0) {
+        struct timespec deadline;
+        uint64_t ms = (millisec < MESSAGE_WAIT_MAX_MS) ? millisec : MESSAGE_WAIT_MAX_MS;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        uint64_t nsec = (uint64_t)deadline.tv_nsec + ms * 1000000;
+        deadline.tv_sec += nsec / 1000000000;
+        deadline.tv_nsec = nsec % 1000000000;
+        while (!message_queues[queue_id].head &&
+               (pthread_cond_timedwait(&message_queues[queue_id].not_empty, &message_queues[queue_id].mutex,
+                                       &deadline) != ETIMEDOUT)) {
+        }
+    }
+
     if (message_queues[queue_id].head) {
         message_node_t *node = message_queues[queue_id].head;
         event.value.p = (void *)node->info;
@@ -156,7 +176,7 @@ osEvent osMessageGet (osMessageQId queue_id, uint32_t millisec) {
     }
     
     pthread_mutex_unlock(&message_queues[queue_id].mutex);
-    
+
     printf("osMessageGet: status=%d\n", event.status);
     return event;
 }
@@ -238,16 +258,40 @@ uint32_t xlat_latency_count_get(enum latency_type type) {
     return 0;
 }
 
+uint32_t xlat_latency_variance_get(enum latency_type type) {
+    printf("[stub] xlat_latency_variance_get\n");
+    return 0;
+}
+
 void xlat_latency_reset(void) {
     printf("[stub] xlat_latency_reset\n");
+    xlat_sdlog_run_end();
 }
 
 void xlat_auto_trigger_turn_off_action(void) {
     printf("[stub] xlat_auto_trigger_turn_off_action\n");
 }
 
+void xlat_auto_trigger_desync_sof(void) {
+}
+
 void xlat_auto_trigger_action(void) {
     printf("[stub] xlat_auto_trigger_action\n");
+    // A fake measurement for the SD card logger
+    xlat_sdlog_add(xlat_counter_1mhz_get(), 1000 + rand() % 500, false);
+}
+
+void xlat_quiet_window_start(void) {
+    printf("[stub] xlat_quiet_window_start\n");
+}
+
+bool xlat_quiet_window_active(void) {
+    return false;
+}
+
+uint16_t xlat_hid_report_desc_get(const uint8_t **desc) {
+    *desc = NULL;
+    return 0;
 }
 
 uint32_t xlat_counter_1mhz_get(void) {
@@ -260,8 +304,33 @@ void xlat_print_measurement(void) {
 }
 
 
+// Stubs for the diagnostics tab:
+static struct xlat_diag diag_stub;
+
+void xlat_diag_update(void) {
+}
+
+const struct xlat_diag *xlat_diag_get(void) {
+    return &diag_stub;
+}
+
+void xlat_diag_lvgl_mem_set(uint32_t total, uint32_t used, uint32_t max_used, uint8_t frag_pct) {
+    diag_stub.lvgl_mem_total = total;
+    diag_stub.lvgl_mem_used = used;
+    diag_stub.lvgl_mem_max_used = max_used;
+    diag_stub.lvgl_mem_frag_pct = frag_pct;
+}
+
+void xlat_diag_print(void) {
+    printf("[stub] xlat_diag_print\n");
+}
+
+
 // Other stubs:
 
+void tft_swap_wait(void) {
+}
+
 void tft_init(void) {
     printf("[stub] tft_init\n");
 }
@@ -0,0 +1,72 @@
+#include <stdlib.h>
+
+#include "fakes.h"
+#include "xlat.h"
+#include "xlat_sdram.h"
+#include "usb_task.h"
+
+uint32_t fake_latency_count = 0;
+uint32_t fake_latency_variance = 0;
+
+// xlat.c
+
+uint32_t xlat_latency_count_get(enum latency_type type)
+{
+    (void) type;
+    return fake_latency_count;
+}
+
+uint32_t xlat_latency_variance_get(enum latency_type type)
+{
+    (void) type;
+    return fake_latency_variance;
+}
+
+uint16_t xlat_hid_report_desc_get(const uint8_t **desc)
+{
+    // Longer than a record, so that it is split into chunks
+    static uint8_t report_desc[300];
+
+    for (uint16_t i = 0; i < sizeof(report_desc); i++) {
+        report_desc[i] = (uint8_t)i;
+    }
+    *desc = report_desc;
+    return sizeof(report_desc);
+}
+
+// xlat_sdram.c: the arena is the host heap
+
+void *xlat_sdram_alloc(enum xlat_sdram_pool pool, uint32_t size, uint32_t align, const char *name)
+{
+    (void) pool;
+    (void) name;
+    return aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+// usb_task.c
+
+const char *usb_host_get_manuf_string(void)
+{
+    return "Finalmouse";
+}
+
+const char *usb_host_get_product_string(void)
+{
+    return "Test mouse";
+}
+
+const char *usb_host_get_serial_string(void)
+{
+    return "";
+}
+
+const char *usb_host_get_vidpid_string(void)
+{
+    return "361D:0100";
+}
+
+const uint8_t *usb_host_get_device_descriptor(void)
+{
+    static const uint8_t desc[18] = {18, 1, 0x00, 0x02};
+    return desc;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdint.h>
+
+// Fakes of what the modules under test call outside of themselves (fakes.c),
+// the tests set these to the values the module should see
+
+extern uint32_t fake_latency_count;
+extern uint32_t fake_latency_variance;
@@ -0,0 +1,3 @@
+#pragma once
+
+// The unit tests are single threaded, see task.h
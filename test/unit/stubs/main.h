@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// What the modules under test use from the firmware's main.h
+static inline void Error_Handler(void)
+{
+    fprintf(stderr, "Error_Handler()\n");
+    abort();
+}
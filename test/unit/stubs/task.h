@@ -0,0 +1,5 @@
+#pragma once
+
+// No interrupts in the unit tests, the critical sections have nothing to keep out
+#define taskENTER_CRITICAL()    ((void)0)
+#define taskEXIT_CRITICAL()     ((void)0)
@@ -0,0 +1,125 @@
+#include "unit.h"
+#include "fakes.h"
+#include "xlat.h"
+#include "xlat_autostop.h"
+#include "xlat_hist.h"
+
+static const struct xlat_autostop_config mean_only = {
+    .enabled = true,
+    .level_pct = 95,
+    .mean_half_width_us = 20,
+    .p99_half_width_us = 0,
+    .min_samples = 100,
+    .max_samples = 5000,
+};
+
+// Adds samples of latency_us until the run can stop, returns the sample count then
+static uint32_t run_until_done(uint32_t latency_us, struct xlat_autostop_status *status)
+{
+    xlat_hist_reset();
+    for (fake_latency_count = 1; fake_latency_count <= 10000; fake_latency_count++) {
+        xlat_hist_add(latency_us);
+        if (xlat_autostop_check(status)) {
+            return fake_latency_count;
+        }
+    }
+    return 0;
+}
+
+static void test_config(void)
+{
+    struct xlat_autostop_config cfg = mean_only;
+
+    CHECK(xlat_autostop_config_set(&cfg));
+    CHECK(xlat_autostop_enabled());
+    CHECK_EQ(xlat_autostop_run_length_get(), 5000);
+
+    cfg.level_pct = 80;
+    CHECK(!xlat_autostop_config_set(&cfg));
+    cfg = mean_only;
+    cfg.max_samples = cfg.min_samples - 1;
+    CHECK(!xlat_autostop_config_set(&cfg));
+    cfg = mean_only;
+    cfg.mean_half_width_us = 0;
+    CHECK(!xlat_autostop_config_set(&cfg));
+
+    // Rejected configurations leave the current one alone
+    xlat_autostop_config_get(&cfg);
+    CHECK_EQ(cfg.max_samples, 5000);
+
+    cfg.enabled = false;
+    CHECK(xlat_autostop_config_set(&cfg));
+    CHECK_EQ(xlat_autostop_run_length_get(), AUTO_TRIGGER_COUNT_DEFAULT);
+}
+
+static void test_mean(void)
+{
+    struct xlat_autostop_status status;
+
+    // stdev 200 us: 1.96 * 200 / sqrt(n) <= 20 from n = 385 on
+    xlat_autostop_config_set(&mean_only);
+    fake_latency_variance = 200 * 200;
+    CHECK_EQ(run_until_done(1025, &status), 385);
+    CHECK_EQ(status.count, 385);
+    CHECK_EQ(status.mean_half_width_us, 20);
+
+    // stdev 10 us: done as soon as allowed
+    fake_latency_variance = 10 * 10;
+    CHECK_EQ(run_until_done(1025, &status), 100);
+
+    // 99%: 2.576 * 200 / sqrt(n) <= 20 from n = 664 on
+    struct xlat_autostop_config cfg = mean_only;
+    cfg.level_pct = 99;
+    xlat_autostop_config_set(&cfg);
+    fake_latency_variance = 200 * 200;
+    CHECK_EQ(run_until_done(1025, &status), 664);
+
+    // Too noisy to ever be known well enough: max_samples ends the run
+    fake_latency_variance = 10000 * 10000;
+    CHECK_EQ(run_until_done(1025, &status), 5000);
+
+    cfg.enabled = false;
+    xlat_autostop_config_set(&cfg);
+    CHECK_EQ(run_until_done(1025, &status), 0);
+}
+
+static void test_p99(void)
+{
+    struct xlat_autostop_config cfg = mean_only;
+    struct xlat_autostop_status status;
+
+    // All the samples in [1000, 1050): the P99 interval is that bin once its upper rank
+    // 0.99 n + 1.96 sqrt(0.0099 n) is below n, from n = 563 on
+    fake_latency_variance = 0;
+    cfg.p99_half_width_us = XLAT_HIST_BIN_US / 2;
+    xlat_autostop_config_set(&cfg);
+    CHECK_EQ(run_until_done(1025, &status), 563);
+    CHECK_EQ(status.p99_low_us, 1000);
+    CHECK_EQ(status.p99_high_us, 1050);
+
+    xlat_hist_reset();
+    for (fake_latency_count = 1; fake_latency_count < 563; fake_latency_count++) {
+        xlat_hist_add(1025);
+    }
+    fake_latency_count = 562;
+    CHECK(!xlat_autostop_check(&status));
+    CHECK_EQ(status.p99_high_us, UINT32_MAX);
+
+    // Narrower than a bin can resolve: only max_samples stops the run
+    cfg.p99_half_width_us = XLAT_HIST_BIN_US / 2 - 1;
+    xlat_autostop_config_set(&cfg);
+    CHECK_EQ(run_until_done(1025, &status), 5000);
+
+    // Samples above the histogram range have no upper bound
+    cfg.p99_half_width_us = 1000;
+    xlat_autostop_config_set(&cfg);
+    CHECK_EQ(run_until_done(XLAT_HIST_BINS * XLAT_HIST_BIN_US, &status), 5000);
+}
+
+int main(void)
+{
+    UNIT_RUN(test_config);
+    UNIT_RUN(test_mean);
+    UNIT_RUN(test_p99);
+    return unit_result();
+}
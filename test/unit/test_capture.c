@@ -0,0 +1,134 @@
+#include <string.h>
+
+#include "unit.h"
+#include "xlat_capture.h"
+
+static struct xlat_capture_block blk;
+
+static void test_crc(void)
+{
+    // The CRC-32 check value, zlib's crc32() gives the same
+    CHECK_EQ(xlat_capture_crc32("123456789", 9), 0xCBF43926);
+    CHECK_EQ(xlat_capture_crc32("", 0), 0);
+}
+
+static void test_varint(void)
+{
+    xlat_capture_block_init(&blk, XLAT_CAPTURE_BLOCK_SAMPLES, 7);
+
+    // 300 -> AC 02, (150 << 1) | 1 -> AD 02, then a delta of 1 and a latency of 63
+    CHECK(xlat_capture_sample_put(&blk, 300, 150, true));
+    CHECK(xlat_capture_sample_put(&blk, 301, 63, false));
+    const uint8_t want[] = {0xAC, 0x02, 0xAD, 0x02, 0x01, 0x7E};
+    CHECK_EQ(blk.length, sizeof(want));
+    CHECK(!memcmp(blk.payload, want, sizeof(want)));
+    CHECK_EQ(blk.count, 2);
+    CHECK_EQ(blk.last_us, 301);
+}
+
+static void test_samples(void)
+{
+    // The counter wraps in the middle, and the latencies take 1 to 5 byte varints
+    const uint32_t timestamps[] = {0xFFFFFF00, 0xFFFFFFF0, 0x00000010, 0x00100000, 0x80000000};
+    const uint32_t latencies[] = {0, 63, 8191, 1000000, (1UL << 31) - 1};
+    uint32_t timestamp;
+    uint32_t latency;
+    bool quiet;
+
+    xlat_capture_block_init(&blk, XLAT_CAPTURE_BLOCK_SAMPLES, 7);
+    for (uint32_t i = 0; i < 5; i++) {
+        CHECK(xlat_capture_sample_put(&blk, timestamps[i], latencies[i], i & 1));
+    }
+    xlat_capture_block_seal(&blk, 42);
+    CHECK(xlat_capture_block_check(&blk));
+    CHECK_EQ(blk.seq, 42);
+    CHECK_EQ(blk.run, 7);
+
+    struct xlat_capture_cursor cur = {0};
+    for (uint32_t i = 0; i < 5; i++) {
+        CHECK(xlat_capture_sample_next(&blk, &cur, &timestamp, &latency, &quiet));
+        CHECK_EQ(timestamp, timestamps[i]);
+        CHECK_EQ(latency, latencies[i]);
+        CHECK_EQ(quiet, i & 1);
+    }
+    CHECK(!xlat_capture_sample_next(&blk, &cur, &timestamp, &latency, &quiet));
+
+    // Not a records block
+    uint8_t tag;
+    const uint8_t *data;
+    uint16_t len;
+    struct xlat_capture_cursor rec = {0};
+    CHECK(!xlat_capture_record_next(&blk, &rec, &tag, &data, &len));
+
+    // Any bit flip is caught
+    blk.payload[3] ^= 0x10;
+    CHECK(!xlat_capture_block_check(&blk));
+}
+
+static void test_full(void)
+{
+    uint32_t timestamp;
+    uint32_t latency;
+    bool quiet;
+    uint32_t n = 0;
+
+    // 3 bytes per sample, one delta byte and two for the latency
+    xlat_capture_block_init(&blk, XLAT_CAPTURE_BLOCK_SAMPLES, 1);
+    while (xlat_capture_sample_put(&blk, n * 100, 1000 + n % 50, false)) {
+        n++;
+    }
+    CHECK_EQ(n, XLAT_CAPTURE_PAYLOAD_SIZE / 3);
+    CHECK_EQ(blk.count, n);
+    xlat_capture_block_seal(&blk, 0);
+    CHECK(xlat_capture_block_check(&blk));
+
+    struct xlat_capture_cursor cur = {0};
+    for (uint32_t i = 0; i < n; i++) {
+        CHECK(xlat_capture_sample_next(&blk, &cur, &timestamp, &latency, &quiet));
+        CHECK_EQ(timestamp, i * 100);
+        CHECK_EQ(latency, 1000 + i % 50);
+    }
+    CHECK(!xlat_capture_sample_next(&blk, &cur, &timestamp, &latency, &quiet));
+}
+
+static void test_records(void)
+{
+    const char product[] = "Test mouse";
+    uint8_t big[XLAT_CAPTURE_PAYLOAD_SIZE];
+    uint8_t tag;
+    const uint8_t *data;
+    uint16_t len;
+
+    memset(big, 0x5A, sizeof(big));
+    xlat_capture_block_init(&blk, XLAT_CAPTURE_BLOCK_INFO, 3);
+    CHECK(xlat_capture_record_put(&blk, XLAT_CAPTURE_TAG_PRODUCT, product, strlen(product)));
+    CHECK(xlat_capture_record_put(&blk, XLAT_CAPTURE_TAG_REPORT_DESC, big, 200));
+    // A record never spans two blocks
+    CHECK(!xlat_capture_record_put(&blk, XLAT_CAPTURE_TAG_REPORT_DESC, big, 300));
+    xlat_capture_block_seal(&blk, 1);
+    CHECK(xlat_capture_block_check(&blk));
+
+    struct xlat_capture_cursor cur = {0};
+    CHECK(xlat_capture_record_next(&blk, &cur, &tag, &data, &len));
+    CHECK_EQ(tag, XLAT_CAPTURE_TAG_PRODUCT);
+    CHECK_EQ(len, strlen(product));
+    CHECK(!memcmp(data, product, len));
+    CHECK(xlat_capture_record_next(&blk, &cur, &tag, &data, &len));
+    CHECK_EQ(tag, XLAT_CAPTURE_TAG_REPORT_DESC);
+    CHECK_EQ(len, 200);
+    CHECK(!memcmp(data, big, len));
+    CHECK(!xlat_capture_record_next(&blk, &cur, &tag, &data, &len));
+
+    // 1 + 1 + 10 bytes, then 1 + 2 + 200
+    CHECK_EQ(blk.length, 215);
+}
+
+int main(void)
+{
+    UNIT_RUN(test_crc);
+    UNIT_RUN(test_varint);
+    UNIT_RUN(test_samples);
+    UNIT_RUN(test_full);
+    UNIT_RUN(test_records);
+    return unit_result();
+}
@@ -0,0 +1,114 @@
+#include "unit.h"
+#include "xlat_hist.h"
+#include "xlat_robust.h"
+
+static uint32_t below[XLAT_HIST_BINS + 1];
+
+static void add_n(uint32_t latency_us, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        xlat_hist_add(latency_us);
+    }
+}
+
+// 40 samples in [1000, 1050), 40 in [1050, 1100), 20 in [1100, 1150)
+static void fixture(void)
+{
+    xlat_hist_reset();
+    add_n(1025, 40);
+    add_n(1075, 40);
+    add_n(1125, 20);
+}
+
+static void test_bins(void)
+{
+    fixture();
+    CHECK_EQ(xlat_hist_total_get(), 100);
+    CHECK_EQ(xlat_hist_count_get(20), 40);
+    CHECK_EQ(xlat_hist_count_get(22), 20);
+    CHECK_EQ(xlat_hist_peak_get(), 40);
+    CHECK_EQ(xlat_hist_last_bin_get(), 22);
+    CHECK_EQ(xlat_hist_rank_bin_get(0), 20);
+    CHECK_EQ(xlat_hist_rank_bin_get(39), 20);
+    CHECK_EQ(xlat_hist_rank_bin_get(40), 21);
+    CHECK_EQ(xlat_hist_rank_bin_get(99), 22);
+
+    // Everything above the range goes to the last bin
+    CHECK_EQ(xlat_hist_add(1000000), XLAT_HIST_BINS - 1);
+    CHECK_EQ(xlat_hist_last_bin_get(), XLAT_HIST_BINS - 1);
+}
+
+static void test_median_mad(void)
+{
+    fixture();
+    xlat_hist_cumulative_get(below);
+    CHECK_EQ(below[20], 0);
+    CHECK_EQ(below[22], 80);
+    CHECK_EQ(below[XLAT_HIST_BINS], 100);
+
+    // Rank 50 is a quarter into [1050, 1100): 1062.5
+    uint32_t median = xlat_hist_median_get(below);
+    CHECK_EQ(median, 1063);
+
+    // 0.8 samples per us on both sides of the median: 50 samples within +/- 31.25 us
+    CHECK_EQ(xlat_hist_mad_get(below, median), 32);
+
+    xlat_hist_reset();
+    xlat_hist_cumulative_get(below);
+    CHECK_EQ(xlat_hist_median_get(below), 0);
+    CHECK_EQ(xlat_hist_mad_get(below, 0), 0);
+}
+
+static void robust_add(uint32_t latency_us)
+{
+    xlat_hist_add(latency_us);
+    xlat_robust_add(latency_us);
+}
+
+static void test_robust(void)
+{
+    xlat_hist_reset();
+    xlat_robust_reset();
+    xlat_robust_k_x10_set(XLAT_ROBUST_K_X10_DEFAULT);
+
+    // Never an outlier among the first samples, however far
+    robust_add(9000);
+    for (uint32_t i = 1; i < XLAT_ROBUST_MIN_SAMPLES; i++) {
+        robust_add(1000 + (i % 2) * 60);
+    }
+    CHECK_EQ(xlat_robust_outlier_count_get(), 0);
+    CHECK_EQ(xlat_robust_inlier_count_get(), XLAT_ROBUST_MIN_SAMPLES);
+
+    // 1000 and 1060 alternate from here on
+    for (uint32_t i = 0; i < 80; i++) {
+        robust_add(1000 + (i % 2) * 60);
+    }
+    CHECK_EQ(xlat_robust_outlier_count_get(), 0);
+    CHECK(!xlat_robust_last_outlier_get());
+
+    robust_add(5000);
+    CHECK(xlat_robust_last_outlier_get());
+    CHECK_EQ(xlat_robust_outlier_count_get(), 1);
+    robust_add(1020);
+    CHECK(!xlat_robust_last_outlier_get());
+
+    // 9000, 49 x 1000, 50 x 1060 and 1020 are in, the 5000 is out
+    CHECK_EQ(xlat_robust_inlier_count_get(), 101);
+    CHECK_EQ(xlat_robust_inlier_average_get(), (9000 + 49 * 1000 + 50 * 1060 + 1020) / 101);
+
+    // 50 samples in [1000, 1050), rank 51 of 102 is 1/50 into [1050, 1100)
+    CHECK_EQ(xlat_robust_median_get(), 1051);
+
+    xlat_robust_reset();
+    CHECK_EQ(xlat_robust_inlier_count_get(), 0);
+    CHECK_EQ(xlat_robust_inlier_average_get(), 0);
+    CHECK_EQ(xlat_robust_inlier_standard_deviation_get(), 0);
+}
+
+int main(void)
+{
+    UNIT_RUN(test_bins);
+    UNIT_RUN(test_median_mad);
+    UNIT_RUN(test_robust);
+    return unit_result();
+}
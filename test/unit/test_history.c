@@ -0,0 +1,107 @@
+#include "unit.h"
+#include "xlat_history.h"
+
+#define SAMPLES     5000    // more than level 0 holds
+
+// Not monotonic, so that the min and max of a block are not at its edges
+static uint32_t sample(uint32_t i)
+{
+    return 1000 + (i * 37) % 101;
+}
+
+static struct xlat_history_span expected(uint32_t first, uint32_t last)
+{
+    struct xlat_history_span span = {UINT16_MAX, 0};
+
+    for (uint32_t i = first; i < last; i++) {
+        if (sample(i) < span.min) {
+            span.min = sample(i);
+        }
+        if (sample(i) > span.max) {
+            span.max = sample(i);
+        }
+    }
+    return span;
+}
+
+static void fill(void)
+{
+    xlat_history_reset();
+    for (uint32_t i = 0; i < SAMPLES; i++) {
+        xlat_history_add(sample(i));
+    }
+}
+
+static void test_levels(void)
+{
+    struct xlat_history_span span;
+
+    fill();
+    CHECK_EQ(xlat_history_count_get(), SAMPLES);
+
+    // A range of exactly one entry of a level that still holds it is that entry:
+    // the exact min and max
+    CHECK(xlat_history_span_get(5, 6, &span));
+    CHECK_EQ(span.min, sample(5));
+    CHECK_EQ(span.max, sample(5));
+    for (uint32_t block = 4; block <= 1024; block *= 4) {
+        uint32_t end = (XLAT_HISTORY_ENTRIES * block < SAMPLES) ? (XLAT_HISTORY_ENTRIES * block) : SAMPLES;
+        for (uint32_t first = 0; (first + block) <= end; first += block) {
+            struct xlat_history_span want = expected(first, first + block);
+            CHECK(xlat_history_span_get(first, first + block, &span));
+            CHECK_EQ(span.min, want.min);
+            CHECK_EQ(span.max, want.max);
+        }
+    }
+
+    // Past the 4096 samples of level 1, 4 samples come from an entry of 16 in level 2
+    CHECK(xlat_history_span_get(4096, 4100, &span));
+    CHECK_EQ(span.min, expected(4096, 4112).min);
+    CHECK_EQ(span.max, expected(4096, 4112).max);
+}
+
+static void test_unaligned(void)
+{
+    struct xlat_history_span span;
+
+    fill();
+
+    // The envelope holds the range, and reaches at most one entry outside of it
+    const uint32_t ranges[][2] = {{3, 9}, {10, 70}, {1000, 1030}, {999, 4001}, {1, SAMPLES}};
+    for (uint32_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+        uint32_t first = ranges[r][0];
+        uint32_t last = ranges[r][1];
+        uint32_t reach = last - first;
+        struct xlat_history_span inner = expected(first, last);
+        struct xlat_history_span outer = expected((first > reach) ? (first - reach) : 0,
+                                                  (last + reach < SAMPLES) ? (last + reach) : SAMPLES);
+        CHECK(xlat_history_span_get(first, last, &span));
+        CHECK(span.min <= inner.min);
+        CHECK(span.max >= inner.max);
+        CHECK(span.min >= outer.min);
+        CHECK(span.max <= outer.max);
+    }
+}
+
+static void test_edges(void)
+{
+    struct xlat_history_span span;
+
+    xlat_history_reset();
+    CHECK(!xlat_history_span_get(0, 10, &span));
+
+    xlat_history_add(100000);
+    xlat_history_add(7);
+    CHECK(xlat_history_span_get(0, 100, &span));
+    CHECK_EQ(span.min, 7);
+    CHECK_EQ(span.max, UINT16_MAX);
+    CHECK(!xlat_history_span_get(2, 10, &span));
+}
+
+int main(void)
+{
+    UNIT_RUN(test_levels);
+    UNIT_RUN(test_unaligned);
+    UNIT_RUN(test_edges);
+    return unit_result();
+}
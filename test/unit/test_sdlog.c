@@ -0,0 +1,195 @@
+#include <string.h>
+
+#include "unit.h"
+#include "xlat_blockdev.h"
+#include "xlat_capture.h"
+#include "xlat_sdlog.h"
+
+#define FILE_START      10      // the file doesn't start at block 0 of the card
+#define FILE_BLOCKS     64
+
+static uint8_t card[(FILE_START + FILE_BLOCKS) * XLAT_BLOCK_SIZE] __attribute__((aligned(32)));
+static struct xlat_blockdev bd;
+static uint32_t now_ms = 0;
+
+// Writes fail while set
+static bool card_fail = false;
+static bool (*card_write)(struct xlat_blockdev *bd, uint32_t lba, const void *buf, uint32_t count);
+
+static bool faulty_write(struct xlat_blockdev *dev, uint32_t lba, const void *buf, uint32_t count)
+{
+    return !card_fail && card_write(dev, lba, buf, count);
+}
+
+static const struct xlat_capture_block *file_block(uint32_t i)
+{
+    return (const struct xlat_capture_block *)&card[(FILE_START + i) * XLAT_BLOCK_SIZE];
+}
+
+static uint32_t sample_latency(uint32_t i)
+{
+    return 900 + (i * 7) % 300;
+}
+
+// The logger task runs now and then, the end of the run writes everything out
+static void log_run(uint32_t first, uint32_t n)
+{
+    for (uint32_t i = first; i < first + n; i++) {
+        xlat_sdlog_add(i * 1000, sample_latency(i), i & 1);
+        if ((i % 64) == 0) {
+            xlat_sdlog_process(now_ms);
+        }
+    }
+    xlat_sdlog_run_end();
+    now_ms += XLAT_SDLOG_FLUSH_MS;
+    xlat_sdlog_process(now_ms);
+}
+
+// Block sequence number of the head, the next block to be written
+static uint32_t head_seq(void)
+{
+    uint32_t head = 0;
+
+    for (uint32_t i = 0; i < FILE_BLOCKS; i++) {
+        if (xlat_capture_block_check(file_block(i)) && (file_block(i)->seq >= head)) {
+            head = file_block(i)->seq + 1;
+        }
+    }
+    return head;
+}
+
+static void test_fresh(void)
+{
+    struct xlat_sdlog_stats stats;
+
+    memset(card, 0, sizeof(card));
+    xlat_blockdev_ram_init(&bd, card, FILE_START + FILE_BLOCKS);
+    card_write = bd.write;
+    bd.write = faulty_write;
+    CHECK(!xlat_sdlog_mount(&bd, FILE_START, XLAT_SDLOG_BATCH_BLOCKS - 1));
+    CHECK(xlat_sdlog_mount(&bd, FILE_START, FILE_BLOCKS));
+    xlat_sdlog_stats_get(&stats);
+    CHECK(stats.mounted);
+    CHECK_EQ(stats.file_blocks, FILE_BLOCKS);
+    CHECK_EQ(stats.run, 1);
+
+    log_run(0, 300);
+    xlat_sdlog_stats_get(&stats);
+    CHECK_EQ(stats.drops, 0);
+    CHECK_EQ(stats.write_errors, 0);
+    CHECK_EQ(stats.run, 2);
+    CHECK_EQ(head_seq(), stats.blocks_written);
+
+    // The info first, then every sample in order, from the start of the file
+    const struct xlat_capture_block *blk = file_block(0);
+    struct xlat_capture_cursor cur = {0};
+    uint8_t tag;
+    const uint8_t *data;
+    uint16_t len;
+    CHECK_EQ(blk->type, XLAT_CAPTURE_BLOCK_INFO);
+    CHECK_EQ(blk->seq, 0);
+    CHECK_EQ(blk->run, 1);
+    CHECK(xlat_capture_record_next(blk, &cur, &tag, &data, &len));
+    CHECK_EQ(tag, XLAT_CAPTURE_TAG_SETTINGS);
+    CHECK_EQ(len, sizeof(struct xlat_capture_settings));
+
+    uint32_t n = 0;
+    for (uint32_t b = 1; b < head_seq(); b++) {
+        uint32_t timestamp;
+        uint32_t latency;
+        bool quiet;
+        blk = file_block(b);
+        CHECK(xlat_capture_block_check(blk));
+        CHECK_EQ(blk->seq, b);
+        CHECK_EQ(blk->type, XLAT_CAPTURE_BLOCK_SAMPLES);
+        memset(&cur, 0, sizeof(cur));
+        while (xlat_capture_sample_next(blk, &cur, &timestamp, &latency, &quiet)) {
+            CHECK_EQ(timestamp, n * 1000);
+            CHECK_EQ(latency, sample_latency(n));
+            CHECK_EQ(quiet, n & 1);
+            n++;
+        }
+    }
+    CHECK_EQ(n, 300);
+}
+
+static void test_remount(void)
+{
+    struct xlat_sdlog_stats stats;
+    uint32_t head = head_seq();
+
+    // After a power cycle the next run goes right after the last block
+    CHECK(head > 0);
+    CHECK(xlat_sdlog_mount(&bd, FILE_START, FILE_BLOCKS));
+    xlat_sdlog_stats_get(&stats);
+    CHECK_EQ(stats.run, 2);
+
+    log_run(0, 10);
+    CHECK_EQ(head_seq(), head + 2);
+    CHECK_EQ(file_block(head)->seq, head);
+    CHECK_EQ(file_block(head)->run, 2);
+    CHECK_EQ(file_block(head)->type, XLAT_CAPTURE_BLOCK_INFO);
+    CHECK_EQ(file_block(head + 1)->type, XLAT_CAPTURE_BLOCK_SAMPLES);
+}
+
+static void test_wrap(void)
+{
+    struct xlat_sdlog_stats stats;
+
+    // Around the end of the file, more than once
+    while (head_seq() < 3 * FILE_BLOCKS + 5) {
+        log_run(0, 2000);
+    }
+    xlat_sdlog_stats_get(&stats);
+    CHECK_EQ(stats.drops, 0);
+    CHECK_EQ(stats.write_errors, 0);
+
+    uint32_t head = head_seq();
+    uint32_t run = stats.run;
+    CHECK(xlat_sdlog_mount(&bd, FILE_START, FILE_BLOCKS));
+    xlat_sdlog_stats_get(&stats);
+    CHECK_EQ(stats.run, run);
+
+    log_run(0, 10);
+    const struct xlat_capture_block *blk = file_block(head % FILE_BLOCKS);
+    CHECK(xlat_capture_block_check(blk));
+    CHECK_EQ(blk->seq, head);
+    CHECK_EQ(blk->run, run);
+    CHECK_EQ(blk->type, XLAT_CAPTURE_BLOCK_INFO);
+    CHECK_EQ(head_seq(), head + 2);
+}
+
+static void test_write_error(void)
+{
+    struct xlat_sdlog_stats stats;
+    uint32_t head = head_seq();
+
+    xlat_sdlog_stats_get(&stats);
+    uint32_t errors = stats.write_errors;
+    card_fail = true;
+    log_run(0, 10);
+    card_fail = false;
+    xlat_sdlog_stats_get(&stats);
+    CHECK_EQ(stats.write_errors, errors + 1);
+    CHECK_EQ(head_seq(), head);
+
+    // The next run takes the place of the lost one, no hole for the head recovery to trip on
+    log_run(0, 10);
+    CHECK_EQ(head_seq(), head + 2);
+    for (uint32_t seq = head - (FILE_BLOCKS - 2); seq < head + 2; seq++) {
+        CHECK_EQ(file_block(seq % FILE_BLOCKS)->seq, seq);
+    }
+
+    CHECK(xlat_sdlog_mount(&bd, FILE_START, FILE_BLOCKS));
+    log_run(0, 10);
+    CHECK_EQ(file_block((head + 2) % FILE_BLOCKS)->seq, head + 2);
+}
+
+int main(void)
+{
+    UNIT_RUN(test_fresh);
+    UNIT_RUN(test_remount);
+    UNIT_RUN(test_wrap);
+    UNIT_RUN(test_write_error);
+    return unit_result();
+}
@@ -0,0 +1,142 @@
+#include "unit.h"
+#include "xlat_config.h"
+#include "xlat_sdram.h"
+#include "xlat_store.h"
+
+#define CAPACITY    (XLAT_SDRAM_SAMPLE_STORE_SIZE / sizeof(struct xlat_sample))
+
+static struct xlat_run runs[XLAT_STORE_MAX_RUNS];
+
+static void test_samples(void)
+{
+    struct xlat_sample sample;
+
+    xlat_store_init();
+    CHECK_EQ(xlat_store_next_get(), 0);
+    CHECK(!xlat_store_sample_get(0, &sample));
+
+    xlat_store_add(123456, 1000, true, false);
+    xlat_store_add(124456, 1UL << 31, false, true);
+    CHECK_EQ(xlat_store_next_get(), 2);
+
+    CHECK(xlat_store_sample_get(0, &sample));
+    CHECK_EQ(sample.timestamp_us, 123456);
+    CHECK_EQ(sample.latency_us, 1000);
+    CHECK(sample.quiet);
+    CHECK(!sample.outlier);
+
+    // Saturated to what the bit field holds
+    CHECK(xlat_store_sample_get(1, &sample));
+    CHECK_EQ(sample.latency_us, XLAT_SAMPLE_LATENCY_MAX_US);
+    CHECK(!sample.quiet);
+    CHECK(sample.outlier);
+
+    CHECK(!xlat_store_sample_get(2, &sample));
+}
+
+static void test_runs(void)
+{
+    xlat_store_init();
+    xlat_mode_set(XLAT_MODE_KEYBOARD);
+    uint32_t generation = xlat_store_generation_get();
+
+    // Nothing to close
+    xlat_store_run_close();
+    CHECK_EQ(xlat_store_runs_get(runs, XLAT_STORE_MAX_RUNS), 0);
+    CHECK_EQ(xlat_store_generation_get(), generation);
+
+    // 1000, 1010 ... 1090: average 1045, variance 825
+    for (uint32_t i = 0; i < 10; i++) {
+        xlat_store_add(i * 1000, 1000 + i * 10, false, false);
+    }
+    CHECK_EQ(xlat_store_run_first_get(5), 0);
+    xlat_store_run_close();
+    CHECK(xlat_store_generation_get() != generation);
+
+    for (uint32_t i = 0; i < 5; i++) {
+        xlat_store_add(i * 1000, 2000, false, false);
+    }
+    CHECK_EQ(xlat_store_run_first_get(12), 10);
+    xlat_store_run_close();
+
+    CHECK_EQ(xlat_store_runs_get(runs, XLAT_STORE_MAX_RUNS), 2);
+    CHECK_EQ(runs[0].first, 0);
+    CHECK_EQ(runs[0].count, 10);
+    CHECK_EQ(runs[0].mode, XLAT_MODE_KEYBOARD);
+    CHECK_EQ(runs[0].avg_us, 1045);
+    CHECK_EQ(runs[0].stdev_us, 28);
+    CHECK_EQ(runs[0].min_us, 1000);
+    CHECK_EQ(runs[0].max_us, 1090);
+    CHECK_EQ(runs[1].number, runs[0].number + 1);
+    CHECK_EQ(runs[1].first, 10);
+    CHECK_EQ(runs[1].count, 5);
+    CHECK_EQ(runs[1].avg_us, 2000);
+    CHECK_EQ(runs[1].stdev_us, 0);
+
+    CHECK_EQ(xlat_store_run_first_get(3), 0);
+    CHECK_EQ(xlat_store_run_first_get(14), 10);
+    CHECK_EQ(xlat_store_runs_get(runs, 1), 1);
+    CHECK_EQ(runs[0].first, 0);
+
+    xlat_mode_set(XLAT_MODE_MOUSE_CLICK);
+}
+
+static void test_max_runs(void)
+{
+    xlat_store_init();
+
+    // The oldest run goes when there is no room for a new one
+    for (uint32_t i = 0; i < XLAT_STORE_MAX_RUNS + 1; i++) {
+        xlat_store_add(i, 1000 + i, false, false);
+        xlat_store_run_close();
+    }
+    CHECK_EQ(xlat_store_runs_get(runs, XLAT_STORE_MAX_RUNS), XLAT_STORE_MAX_RUNS);
+    CHECK_EQ(runs[0].first, 1);
+    CHECK_EQ(runs[0].avg_us, 1001);
+    CHECK_EQ(runs[XLAT_STORE_MAX_RUNS - 1].first, XLAT_STORE_MAX_RUNS);
+    CHECK_EQ(runs[XLAT_STORE_MAX_RUNS - 1].number, runs[0].number + XLAT_STORE_MAX_RUNS - 1);
+}
+
+static void test_wrap(void)
+{
+    struct xlat_sample sample;
+
+    xlat_store_init();
+    for (uint32_t i = 0; i < 100; i++) {
+        xlat_store_add(i, 1000, false, false);
+    }
+    xlat_store_run_close();
+
+    // The first run is dropped as soon as its first sample is overwritten
+    for (uint32_t i = 100; i < CAPACITY; i++) {
+        xlat_store_add(i, 2000, false, false);
+    }
+    CHECK_EQ(xlat_store_runs_get(runs, XLAT_STORE_MAX_RUNS), 1);
+    xlat_store_add(CAPACITY, 2000, false, false);
+    CHECK_EQ(xlat_store_runs_get(runs, XLAT_STORE_MAX_RUNS), 0);
+    CHECK(!xlat_store_sample_get(0, &sample));
+    CHECK(xlat_store_sample_get(1, &sample));
+    CHECK_EQ(sample.timestamp_us, 1);
+    CHECK(xlat_store_sample_get(CAPACITY, &sample));
+    CHECK_EQ(sample.timestamp_us, CAPACITY);
+
+    // A run longer than the store keeps the samples that are left, the statistics cover all
+    for (uint32_t i = CAPACITY + 1; i < CAPACITY + 200; i++) {
+        xlat_store_add(i, 3000, false, false);
+    }
+    xlat_store_run_close();
+    CHECK_EQ(xlat_store_runs_get(runs, XLAT_STORE_MAX_RUNS), 1);
+    CHECK_EQ(runs[0].first, 200);
+    CHECK_EQ(runs[0].count, CAPACITY);
+    CHECK_EQ(runs[0].min_us, 2000);
+    CHECK_EQ(runs[0].max_us, 3000);
+}
+
+int main(void)
+{
+    UNIT_RUN(test_samples);
+    UNIT_RUN(test_runs);
+    UNIT_RUN(test_max_runs);
+    UNIT_RUN(test_wrap);
+    return unit_result();
+}
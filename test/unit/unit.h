@@ -0,0 +1,37 @@
+#pragma once
+
+// Minimal test harness: every failed check is printed, main() returns unit_result()
+
+#include <stdio.h>
+
+static int unit_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            unit_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    do { \
+        long long actual_ = (long long)(actual); \
+        long long expected_ = (long long)(expected); \
+        if (actual_ != expected_) { \
+            printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, actual_, expected_); \
+            unit_failures++; \
+        } \
+    } while (0)
+
+#define UNIT_RUN(test) \
+    do { \
+        int before_ = unit_failures; \
+        test(); \
+        printf("%s %s\n", (unit_failures == before_) ? "ok  " : "FAIL", #test); \
+    } while (0)
+
+static inline int unit_result(void)
+{
+    return unit_failures ? 1 : 0;
+}
@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2025 Finalmouse, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Reference decoder for the binary capture format (src/xlat_capture.h), e.g. the
+ * XLATLOG.BIN file of the SD card logger. Prints every run as CSV, with the device
+ * and settings info as '#' comment lines.
+ *
+ * Build on the host:
+ *     cc -O2 -DXLAT_CAPTURE_HOST -Isrc -o xlat_capture_decode tools/xlat_capture_decode.c src/xlat_capture.c -lm
+ *
+ * Then:
+ *     ./xlat_capture_decode XLATLOG.BIN > runs.csv
+ *     ./xlat_capture_decode -s XLATLOG.BIN          (one summary line per run)
+ *     ./xlat_capture_decode -r 12 XLATLOG.BIN       (run 12 only)
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "xlat_capture.h"
+
+struct run_state {
+    uint32_t number;
+    uint32_t samples;
+    uint32_t quiet;
+    uint32_t min_us;
+    uint32_t max_us;
+    double sum;
+    double sum_sq;
+    uint8_t desc[512];
+    uint16_t desc_len;
+    bool desc_printed;
+};
+
+static struct run_state cur;
+static bool in_run = false;
+static long only_run = -1;
+static bool summary = false;
+
+static const char *mode_name(uint8_t mode)
+{
+    static const char *names[] = { "click", "motion", "key" };
+    return (mode < 3) ? names[mode] : "unknown";
+}
+
+static bool selected(uint32_t run)
+{
+    return (only_run < 0) || ((uint32_t)only_run == run);
+}
+
+static void desc_print(void)
+{
+    if (cur.desc_printed || !cur.desc_len || summary) {
+        return;
+    }
+    printf("# report descriptor:");
+    for (uint16_t i = 0; i < cur.desc_len; i++) {
+        printf(" %02x", cur.desc[i]);
+    }
+    printf("\n");
+    cur.desc_printed = true;
+}
+
+static void run_end(void)
+{
+    if (!in_run || !selected(cur.number)) {
+        return;
+    }
+    desc_print();
+    if (summary) {
+        double avg = cur.samples ? (cur.sum / cur.samples) : 0;
+        double var = cur.samples ? ((cur.sum_sq / cur.samples) - (avg * avg)) : 0;
+        printf("%u;%u;%u;%.1f;%.1f;%u;%u\n", cur.number, cur.samples, cur.quiet, avg, sqrt(var > 0 ? var : 0),
+               cur.samples ? cur.min_us : 0, cur.max_us);
+    }
+}
+
+static void run_start(uint32_t number, bool info)
+{
+    run_end();
+    memset(&cur, 0, sizeof(cur));
+    cur.number = number;
+    cur.min_us = UINT32_MAX;
+    in_run = true;
+    if (selected(number) && !summary) {
+        printf("# run %u%s\n", number, info ? "" : " (start overwritten, no info)");
+    }
+}
+
+static void info_print(const struct xlat_capture_block *blk)
+{
+    struct xlat_capture_cursor c = {0};
+    const uint8_t *data;
+    uint16_t len;
+    uint8_t tag;
+
+    while (xlat_capture_record_next(blk, &c, &tag, &data, &len)) {
+        if (tag == XLAT_CAPTURE_TAG_REPORT_DESC) {
+            if (len >= 2) {
+                uint16_t offset = data[0] | (data[1] << 8);
+                uint16_t n = len - 2;
+                if ((offset + n) <= sizeof(cur.desc)) {
+                    memcpy(&cur.desc[offset], &data[2], n);
+                    if ((offset + n) > cur.desc_len) {
+                        cur.desc_len = offset + n;
+                    }
+                }
+            }
+            continue;
+        }
+        if (summary) {
+            continue;
+        }
+        switch (tag) {
+            case XLAT_CAPTURE_TAG_FIRMWARE:
+                printf("# firmware: %.*s\n", len, data);
+                break;
+            case XLAT_CAPTURE_TAG_MANUFACTURER:
+                printf("# manufacturer: %.*s\n", len, data);
+                break;
+            case XLAT_CAPTURE_TAG_PRODUCT:
+                printf("# product: %.*s\n", len, data);
+                break;
+            case XLAT_CAPTURE_TAG_SERIAL:
+                printf("# serial: %.*s\n", len, data);
+                break;
+            case XLAT_CAPTURE_TAG_VIDPID:
+                printf("# vid:pid: %.*s\n", len, data);
+                break;
+            case XLAT_CAPTURE_TAG_DEVICE_DESC:
+                printf("# device descriptor:");
+                for (uint16_t i = 0; i < len; i++) {
+                    printf(" %02x", data[i]);
+                }
+                printf("\n");
+                break;
+            case XLAT_CAPTURE_TAG_SETTINGS: {
+                struct xlat_capture_settings s = {0};
+                memcpy(&s, data, (len < sizeof(s)) ? len : sizeof(s));
+                printf("# settings: mode %s, trigger interval %u ms, level %s, output D%u, quiet mode %s, "
+                       "holdoff %u us, button bits %u, motion bits %u, report id %u, keyboard %s\n",
+                       mode_name(s.mode), s.trigger_interval_ms, s.trigger_level_high ? "high" : "low",
+                       s.trigger_output, s.quiet_mode ? "on" : "off", s.gpio_irq_holdoff_us, s.button_bits,
+                       s.motion_bits, s.report_id, s.keyboard_found ? "yes" : "no");
+                break;
+            }
+            default:
+                // Newer firmware, unknown records are skipped
+                printf("# record %u, %u bytes\n", tag, len);
+                break;
+        }
+    }
+}
+
+static void samples_print(const struct xlat_capture_block *blk)
+{
+    struct xlat_capture_cursor c = {0};
+    uint32_t timestamp_us;
+    uint32_t latency_us;
+    bool quiet;
+
+    desc_print();
+    if (!summary && !cur.samples) {
+        printf("run;sample;time_us;latency_us;quiet\n");
+    }
+    while (xlat_capture_sample_next(blk, &c, &timestamp_us, &latency_us, &quiet)) {
+        cur.samples++;
+        cur.quiet += quiet;
+        cur.sum += latency_us;
+        cur.sum_sq += (double)latency_us * latency_us;
+        cur.min_us = (latency_us < cur.min_us) ? latency_us : cur.min_us;
+        cur.max_us = (latency_us > cur.max_us) ? latency_us : cur.max_us;
+        if (!summary) {
+            printf("%u;%u;%u;%u;%u\n", cur.number, cur.samples, timestamp_us, latency_us, quiet);
+        }
+    }
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-s] [-r run] <capture file>\n"
+                    "  -s      one summary line per run: run;samples;quiet;avg_us;stdev_us;min_us;max_us\n"
+                    "  -r run  only decode this run\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "sr:h")) != -1) {
+        switch (opt) {
+            case 's':
+                summary = true;
+                break;
+            case 'r':
+                only_run = strtol(optarg, NULL, 0);
+                break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    FILE *f = fopen(argv[optind], "rb");
+    if (!f) {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    // The logger writes a ring: start at the oldest valid block, then wrap around
+    static struct xlat_capture_block blk;
+    long blocks = 0;
+    long oldest = -1;
+    uint32_t oldest_seq = 0;
+    while (fread(&blk, sizeof(blk), 1, f) == 1) {
+        if (xlat_capture_block_check(&blk) && ((oldest < 0) || (blk.seq < oldest_seq))) {
+            oldest = blocks;
+            oldest_seq = blk.seq;
+        }
+        blocks++;
+    }
+    if (oldest < 0) {
+        fprintf(stderr, "%s: no capture blocks in %ld blocks\n", argv[optind], blocks);
+        fclose(f);
+        return 1;
+    }
+
+    if (summary) {
+        printf("run;samples;quiet;avg_us;stdev_us;min_us;max_us\n");
+    }
+
+    long valid = 0;
+    long invalid = 0;
+    uint64_t payload = 0;
+    uint64_t samples = 0;
+    uint32_t next_seq = oldest_seq;
+    for (long i = 0; i < blocks; i++) {
+        long pos = (oldest + i) % blocks;
+        if ((fseek(f, pos * (long)sizeof(blk), SEEK_SET) != 0) || (fread(&blk, sizeof(blk), 1, f) != 1) ||
+            !xlat_capture_block_check(&blk)) {
+            invalid++;
+            continue;
+        }
+        if (blk.seq < next_seq) {
+            // Left over from an older capture in the same file
+            invalid++;
+            continue;
+        }
+        if (blk.seq != next_seq) {
+            fprintf(stderr, "blocks %u to %u are missing\n", next_seq, blk.seq - 1);
+        }
+        next_seq = blk.seq + 1;
+        valid++;
+
+        if (!in_run || (blk.run != cur.number)) {
+            run_start(blk.run, blk.type == XLAT_CAPTURE_BLOCK_INFO);
+        }
+        if (!selected(blk.run)) {
+            continue;
+        }
+        if (blk.type == XLAT_CAPTURE_BLOCK_INFO) {
+            info_print(&blk);
+        } else if (blk.type == XLAT_CAPTURE_BLOCK_SAMPLES) {
+            samples += blk.count;
+            payload += blk.length;
+            samples_print(&blk);
+        }
+    }
+    run_end();
+    fclose(f);
+
+    fprintf(stderr, "%ld blocks: %ld valid, %ld unused or damaged, %llu samples", blocks, valid, invalid,
+            (unsigned long long)samples);
+    if (samples) {
+        fprintf(stderr, ", %.2f bytes per sample", (double)payload / samples);
+    }
+    fprintf(stderr, "\n");
+    return 0;
+}
@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2025 Finalmouse, LLC
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+"""
+Decode the XLAT binary pipeline trace (RTT up-channel 1, see src/xlat_trace.h)
+and print per-stage latency histograms.
+
+Capture the channel with e.g.:
+    JLinkRTTLogger -Device STM32F746NG -If SWD -Speed 4000 -RTTChannel 1 trace.bin
+
+Then:
+    tools/xlat_trace_decode.py trace.bin
+"""
+
+import argparse
+import collections
+import struct
+import sys
+
+RECORD = struct.Struct("<IBBH")  # cycles, id, arg8, arg16
+
+ID_INIT = 0
+ID_EXTI = 1
+ID_OTG_IRQ = 2
+ID_HID_REPORT = 3
+ID_HID_EVENT = 4
+ID_XLAT_EVENT = 5
+ID_MEASUREMENT = 6
+ID_GFX_UPDATE = 7
+ID_GFX_FLUSH = 8
+ID_TASK_IN = 9
+ID_TASK_OUT = 10
+
+# Stages of one measurement, in pipeline order
+STAGES = [
+    ("exti", "otg_irq", "button edge -> OTG interrupt"),
+    ("otg_irq", "report_cb", "OTG interrupt -> report callback"),
+    ("report_cb", "queued", "report callback -> event queued"),
+    ("queued", "xlat", "event queued -> xlat task"),
+    ("xlat", "gfx", "xlat task -> gfx update"),
+    ("gfx", "flush", "gfx update -> display flush"),
+    ("exti", "xlat", "button edge -> xlat task (total)"),
+]
+
+
+def read_records(data):
+    """Yield (time_in_cycles, id, arg8, arg16), with the 32-bit counter unwrapped."""
+    now = None
+    last = 0
+    usable = len(data) - len(data) % RECORD.size
+    for offset in range(0, usable, RECORD.size):
+        cycles, rec_id, arg8, arg16 = RECORD.unpack_from(data, offset)
+        if now is None:
+            now = cycles
+        else:
+            delta = (cycles - last) & 0xFFFFFFFF
+            if delta >= 0x80000000:
+                # An interrupt preempted a writer between timestamp and RTT write
+                delta -= 0x100000000
+            now += delta
+        last = cycles
+        yield now, rec_id, arg8, arg16
+
+
+def decode(records):
+    mhz = 200
+    chains = []
+    pending_xlat = collections.deque()
+    pending_gfx = collections.deque()
+    pending_flush = collections.deque()
+    last = {"exti": None, "otg_irq": None, "report_cb": None}
+    task_cycles = collections.Counter()
+    running = None
+
+    for t, rec_id, arg8, arg16 in records:
+        if rec_id == ID_INIT:
+            mhz = arg16 or mhz
+        elif rec_id == ID_EXTI:
+            last["exti"] = t
+        elif rec_id == ID_OTG_IRQ:
+            last["otg_irq"] = t
+        elif rec_id == ID_HID_REPORT:
+            last["report_cb"] = t
+        elif rec_id == ID_HID_EVENT:
+            chain = dict(last, queued=t, changed=arg8)
+            chains.append(chain)
+            pending_xlat.append(chain)
+        elif rec_id == ID_XLAT_EVENT and pending_xlat:
+            chain = pending_xlat.popleft()
+            chain["xlat"] = t
+            pending_gfx.append(chain)
+        elif rec_id == ID_MEASUREMENT and pending_gfx:
+            pending_gfx[-1]["latency_us"] = arg16
+            pending_gfx[-1]["quiet"] = arg8
+        elif rec_id == ID_GFX_UPDATE:
+            # Only measurements are forwarded to the gfx task
+            while pending_gfx and "latency_us" not in pending_gfx[0]:
+                pending_gfx.popleft()
+            if pending_gfx:
+                chain = pending_gfx.popleft()
+                chain["gfx"] = t
+                pending_flush.append(chain)
+        elif rec_id == ID_GFX_FLUSH:
+            while pending_flush:
+                pending_flush.popleft()["flush"] = t
+        elif rec_id == ID_TASK_IN:
+            running = (arg8, t)
+        elif rec_id == ID_TASK_OUT and running and running[0] == arg8:
+            task_cycles[arg8] += t - running[1]
+            running = None
+
+    return mhz, chains, task_cycles
+
+
+def histogram(values, bins, width):
+    lo, hi = min(values), max(values)
+    step = max((hi - lo) / bins, 1e-9)
+    counts = [0] * bins
+    for v in values:
+        counts[min(int((v - lo) / step), bins - 1)] += 1
+    peak = max(counts)
+    lines = []
+    for i, c in enumerate(counts):
+        bar = "#" * (c * width // peak) if peak else ""
+        lines.append("  {:10.2f} us | {:<{w}} {}".format(lo + i * step, bar, c, w=width))
+    return lines
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("file", nargs="?", help="raw RTT channel dump (default: stdin)")
+    parser.add_argument("--bins", type=int, default=16, help="histogram bins per stage")
+    parser.add_argument("--width", type=int, default=50, help="histogram bar width")
+    parser.add_argument("--csv", action="store_true", help="print one line per measurement instead")
+    args = parser.parse_args()
+
+    if args.file:
+        with open(args.file, "rb") as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    mhz, chains, task_cycles = decode(read_records(data))
+
+    if args.csv:
+        print("latency_us;quiet;" + ";".join("{}_{}_us".format(a, b) for a, b, _ in STAGES))
+        for chain in chains:
+            if "latency_us" not in chain:
+                continue
+            cols = [str(chain["latency_us"]), str(chain["quiet"])]
+            for a, b, _ in STAGES:
+                ok = chain.get(a) is not None and chain.get(b) is not None
+                cols.append("{:.2f}".format((chain[b] - chain[a]) / mhz) if ok else "")
+            print(";".join(cols))
+        return
+
+    measured = [c for c in chains if "latency_us" in c]
+    quiet = sum(1 for c in measured if c["quiet"])
+    print("{} events, {} measurements ({} quiet), CPU clock {} MHz\n".format(len(chains), len(measured), quiet, mhz))
+
+    for a, b, name in STAGES:
+        values = [(c[b] - c[a]) / mhz for c in measured if c.get(a) is not None and c.get(b) is not None]
+        if not values:
+            continue
+        values.sort()
+        print("{}: n={} min={:.2f} median={:.2f} p99={:.2f} max={:.2f} us".format(
+            name, len(values), values[0], values[len(values) // 2],
+            values[min(len(values) - 1, len(values) * 99 // 100)], values[-1]))
+        print("\n".join(histogram(values, args.bins, args.width)))
+        print()
+
+    total = sum(task_cycles.values())
+    if total:
+        print("CPU time per task (by FreeRTOS task number):")
+        for task, cycles in sorted(task_cycles.items()):
+            print("  task {:3d}: {:6.2f} %".format(task, 100.0 * cycles / total))
+
+
+if __name__ == "__main__":
+    main()